@@ -0,0 +1,413 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "main.h"
+#include "converting.h"
+#include "kernels.h"
+#include "portopt.h"
+
+/* Micro-benchmark for the conversion kernels, every variant in the kernel
+ * table the running CPU supports is timed over a range of input sizes, from
+ * L1 resident up to well beyond the last level cache, and reported in GB/s
+ * of combined input and output traffic and in ns per element */
+
+#define SDC_BENCH_MIN_BYTES ((size_t) 4 << 10)
+#define SDC_BENCH_MAX_BYTES ((size_t) 256 << 20)
+#define SDC_BENCH_MIN_MS    50
+
+struct benchResult
+{
+	const struct sdcKernelEntry *entry;
+	size_t in_bytes;
+	size_t elements;
+	double gbps;
+	double ns_per_elem;
+	SDC_BOOL dispatched;
+};
+
+static double nowSeconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double) ts.tv_sec + ((double) ts.tv_nsec * 1e-9);
+}
+
+static uint32_t xorshift(uint32_t *state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+
+	return (*state = x);
+}
+
+/* Values roughly spread like model weights, with the odd one beyond the
+ * range of F16 so the saturating paths get exercised as well */
+static float benchValue(uint32_t *state)
+{
+	const uint32_t r = xorshift(state);
+	float val = ((float) (r & 0xFFFF) / 32768.0f) - 1.0f;
+
+	if ((r >> 24) == 0)
+	{
+		val *= 1e6f;
+	}
+
+	return val;
+}
+
+static void fillInput(char *buf, const enum dataType dtype,
+	const size_t len)
+{
+	uint32_t state = 0x9E3779B9;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		const float val = benchValue(&state);
+
+		switch (dtype)
+		{
+			case FLOAT_64:
+				((double *) buf)[i] = (double) val;
+				break;
+			case FLOAT_32:
+				((float *) buf)[i] = val;
+				break;
+			case FLOAT_16:
+				((uint16_t *) buf)[i] = fltToHlf(val);
+				break;
+			case BFLOAT_16:
+				((uint16_t *) buf)[i] = fltToBft(val);
+				break;
+			case SIGNED_64:
+				((int64_t *) buf)[i] = (int64_t) (val
+					* 1e4f);
+				break;
+			case SIGNED_32:
+				((int32_t *) buf)[i] = (int32_t) (val
+					* 1e4f);
+				break;
+			case SIGNED_16:
+				((int16_t *) buf)[i] = (int16_t)
+					xorshift(&state);
+				break;
+			case SIGNED_8:
+				((int8_t *) buf)[i] = (int8_t)
+					xorshift(&state);
+				break;
+			case UNSIGNED_8:
+			case BOOLEAN:
+			default: /* fallthrough */
+				((uint8_t *) buf)[i] = (uint8_t)
+					xorshift(&state);
+				break;
+		}
+	}
+}
+
+/* Best of as many runs as fit into min_ms, the first run warms the caches
+ * and faults the output pages in and is not counted */
+static double timeKernel(const sdcKernel func, const char *in, char *out,
+	const size_t len, const double min_ms, struct sdcConvError *err)
+{
+	double best = -1.0;
+	double spent = 0.0;
+
+	func(in, out, len, err);
+
+	while ((spent * 1e3) < min_ms)
+	{
+		const double start = nowSeconds();
+		double elapsed;
+
+		func(in, out, len, err);
+		elapsed = nowSeconds() - start;
+		spent += elapsed;
+
+		if ((best < 0.0) || (elapsed < best))
+		{
+			best = elapsed;
+		}
+	}
+
+	return best;
+}
+
+static size_t parseSize(const char *str)
+{
+	char *end = NULL;
+	size_t val;
+
+	if (str == NULL)
+	{
+		return 0;
+	}
+
+	val = (size_t) strtoull(str, &end, 10);
+
+	switch (*end)
+	{
+		case 'K': case 'k':
+			return val << 10;
+		case 'M': case 'm':
+			return val << 20;
+		case 'G': case 'g':
+			return val << 30;
+		case '\0':
+			return val;
+		default:
+			return 0;
+	}
+}
+
+static void printTable(const struct benchResult *res, const size_t len)
+{
+	size_t i;
+
+	printf("%-26s %-7s %11s %11s %9s %9s\n", "kernel", "isa",
+		"in bytes", "elements", "GB/s", "ns/elem");
+
+	for (i = 0; i < len; i++)
+	{
+		printf("%-26s %-7s %11lu %11lu %9.2f %9.3f%s\n",
+			res[i].entry->name, isa_strs[res[i].entry->isa],
+			res[i].in_bytes, res[i].elements, res[i].gbps,
+			res[i].ns_per_elem,
+			(res[i].dispatched == SDC_TRUE) ? " *" : "");
+	}
+
+	puts("\n* marks the variant selected for this CPU");
+}
+
+static SDC_STAT printJson(const struct benchResult *res, const size_t len)
+{
+	struct cJSON *root    = NULL;
+	struct cJSON *results = NULL;
+	char *out             = NULL;
+	size_t i;
+
+	if (((root = cJSON_CreateObject()) == NULL)
+	|| (cJSON_AddStringToObject(root, "cpu_isa",
+		isa_strs[getCpuIsa()]) == NULL)
+	|| ((results = cJSON_AddArrayToObject(root, "results")) == NULL))
+	{
+		cJSON_Delete(root);
+
+		return SDC_FAILURE;
+	}
+
+	for (i = 0; i < len; i++)
+	{
+		struct cJSON *item = cJSON_CreateObject();
+
+		if ((item == NULL)
+		|| (cJSON_AddItemToArray(results, item) == 0))
+		{
+			cJSON_Delete(item);
+			cJSON_Delete(root);
+
+			return SDC_FAILURE;
+		}
+
+		cJSON_AddStringToObject(item, "kernel", res[i].entry->name);
+		cJSON_AddStringToObject(item, "isa",
+			isa_strs[res[i].entry->isa]);
+		cJSON_AddStringToObject(item, "in",
+			dtype_info[res[i].entry->in_type].name);
+		cJSON_AddStringToObject(item, "out",
+			dtype_info[res[i].entry->out_type].name);
+		cJSON_AddNumberToObject(item, "in_bytes",
+			(double) res[i].in_bytes);
+		cJSON_AddNumberToObject(item, "elements",
+			(double) res[i].elements);
+		cJSON_AddNumberToObject(item, "gbps", res[i].gbps);
+		cJSON_AddNumberToObject(item, "ns_per_elem",
+			res[i].ns_per_elem);
+		cJSON_AddBoolToObject(item, "dispatched",
+			res[i].dispatched == SDC_TRUE);
+	}
+
+	if ((out = cJSON_Print(root)) == NULL)
+	{
+		cJSON_Delete(root);
+
+		return SDC_FAILURE;
+	}
+
+	puts(out);
+	cJSON_free(out);
+	cJSON_Delete(root);
+
+	return SDC_SUCCESS;
+}
+
+static void printHelp(void)
+{
+	fputs("sdc_bench, SDC conversion kernel benchmark\n\n"
+		"-s, --min-size <BYTES>  : Smallest input, default 4K\n"
+		"-S, --max-size <BYTES>  : Largest input, default 256M\n"
+		"-k, --kernel <NAME>     : Only kernels whose name contains"
+			" NAME\n"
+		"-t, --time <MS>         : Time spent per measurement,"
+			" default 50\n"
+		"-e, --errors            : Measures conversion error as"
+			" --stats does\n"
+		"-j, --json              : Prints results as JSON\n"
+		"-h, --help              : Prints this help message\n\n"
+		"Sizes take a K, M or G suffix and grow by a factor of 4\n",
+		stdout);
+}
+
+int main(int argc, char **argv)
+{
+	const struct portoptVerboseOpt opts[] =
+	{
+		{'s', "min-size", PORTOPT_TRUE},
+		{'S', "max-size", PORTOPT_TRUE},
+		{'k', "kernel",   PORTOPT_TRUE},
+		{'t', "time",     PORTOPT_TRUE},
+		{'e', "errors",   PORTOPT_FALSE},
+		{'j', "json",     PORTOPT_FALSE},
+		{'h', "help",     PORTOPT_FALSE}
+	};
+	const size_t num_opts = sizeof(opts) / sizeof(opts[0]);
+	const size_t lenc = (size_t) argc;
+	const struct sdcKernelEntry *table = NULL;
+	struct benchResult *res = NULL;
+	const char *filter      = NULL;
+	char *in                = NULL;
+	char *out               = NULL;
+	size_t min_bytes = SDC_BENCH_MIN_BYTES;
+	size_t max_bytes = SDC_BENCH_MAX_BYTES;
+	double min_ms    = SDC_BENCH_MIN_MS;
+	SDC_BOOL json    = SDC_FALSE;
+	SDC_BOOL errors  = SDC_FALSE;
+	struct sdcConvError err;
+	size_t table_len, num_sizes, res_len = 0;
+	size_t ind = 0;
+	size_t i, size;
+	SDC_STAT ret_code = SDC_SUCCESS;
+	int flag;
+
+	while ((flag = portoptVerbose(lenc, argv, opts, num_opts, &ind)) != -1)
+	{
+		switch (flag)
+		{
+			case 's':
+				min_bytes = parseSize(portoptGetArg(lenc, argv,
+					&ind));
+				break;
+			case 'S':
+				max_bytes = parseSize(portoptGetArg(lenc, argv,
+					&ind));
+				break;
+			case 'k':
+				filter = portoptGetArg(lenc, argv, &ind);
+				break;
+			case 't':
+				min_ms = (double) parseSize(portoptGetArg(lenc,
+					argv, &ind));
+				break;
+			case 'e':
+				errors = SDC_TRUE;
+				break;
+			case 'j':
+				json = SDC_TRUE;
+				break;
+			case 'h':
+				printHelp();
+				return SDC_SUCCESS;
+			case '?':
+			default: /* fallthrough */
+				fputs("Unknown switch\n", stderr);
+				break;
+		}
+	}
+
+	if ((min_bytes == 0) || (max_bytes < min_bytes))
+	{
+		fputs("Invalid size range, see --help\n", stderr);
+
+		return SDC_FAILURE;
+	}
+
+	table = getKernelTable(&table_len);
+
+	for (num_sizes = 0, size = min_bytes; size <= max_bytes; size *= 4)
+	{
+		num_sizes++;
+	}
+
+	/* Outputs are never wider than 4 bytes per element and inputs never
+	 * narrower than 1, so 4x the input covers every kernel */
+	if (((res = malloc(sizeof(*res) * table_len * num_sizes)) == NULL)
+	|| ((in = malloc(max_bytes)) == NULL)
+	|| ((out = malloc(max_bytes * 4)) == NULL))
+	{
+		fputs("Failure to allocate benchmark buffers\n", stderr);
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	for (i = 0; i < table_len; i++)
+	{
+		const struct sdcKernelEntry *entry = &table[i];
+		const size_t in_size  = dtype_info[entry->in_type].size;
+		const size_t out_size = dtype_info[entry->out_type].size;
+
+		if ((entry->isa > getCpuIsa())
+		|| ((filter != NULL) && (strstr(entry->name, filter) == NULL)))
+		{
+			continue;
+		}
+
+		fillInput(in, entry->in_type, max_bytes / in_size);
+
+		for (size = min_bytes; size <= max_bytes; size *= 4)
+		{
+			struct benchResult *cur = &res[res_len++];
+			const size_t elems = size / in_size;
+			double secs;
+
+			memset(&err, 0, sizeof(err));
+			secs = timeKernel(entry->func, in, out, elems, min_ms,
+				(errors == SDC_TRUE) ? &err : NULL);
+
+			cur->entry       = entry;
+			cur->in_bytes    = elems * in_size;
+			cur->elements    = elems;
+			cur->gbps        = ((double) (elems * (in_size
+				+ out_size)) / secs) * 1e-9;
+			cur->ns_per_elem = (secs * 1e9) / (double) elems;
+			cur->dispatched  = (getConversionKernel(entry->in_type,
+				entry->out_type) == entry->func)
+				? SDC_TRUE : SDC_FALSE;
+		}
+	}
+
+	if (json == SDC_TRUE)
+	{
+		ret_code = printJson(res, res_len);
+	}
+	else
+	{
+		printTable(res, res_len);
+	}
+
+CLEANUP:
+	free(res);
+	free(in);
+	free(out);
+
+	return ret_code;
+}
@@ -0,0 +1,444 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "sdc.h"
+#include "cJSON.h"
+#include "portopt.h"
+
+/* End-to-end benchmark, runs whole conversions through the library on the
+ * given files, typically made with sdc_gen, and reports throughput along
+ * with the peak RSS and the read and write syscall counts they cost */
+
+#define SDC_E2E_MAX_INPUTS 64
+
+struct ioCounters
+{
+	long long syscr;
+	long long syscw;
+	long long rchar;
+	long long wchar;
+};
+
+struct e2eResult
+{
+	const char *path;
+	uint64_t in_bytes;
+	uint64_t out_bytes;
+	double best_secs;
+	double mean_secs;
+	long peak_rss_kb;
+	long minor_faults;
+	long major_faults;
+	struct ioCounters io;  /* per run, -1 without /proc/self/io */
+};
+
+static double nowSeconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double) ts.tv_sec + ((double) ts.tv_nsec * 1e-9);
+}
+
+/* Linux only, everything is left at -1 elsewhere */
+static void readIoCounters(struct ioCounters *io)
+{
+	FILE *fhandle = fopen("/proc/self/io", "r");
+	char line[128];
+
+	io->syscr = io->syscw = io->rchar = io->wchar = -1;
+
+	if (fhandle == NULL)
+	{
+		return;
+	}
+
+	while (fgets(line, sizeof(line), fhandle) != NULL)
+	{
+		sscanf(line, "syscr: %lld", &io->syscr);
+		sscanf(line, "syscw: %lld", &io->syscw);
+		sscanf(line, "rchar: %lld", &io->rchar);
+		sscanf(line, "wchar: %lld", &io->wchar);
+	}
+
+	fclose(fhandle);
+}
+
+static char* slurpFile(const char *path, size_t *len)
+{
+	FILE *fhandle = fopen(path, "rb");
+	char *buf     = NULL;
+	long size;
+
+	if (fhandle == NULL)
+	{
+		return NULL;
+	}
+
+	if ((fseek(fhandle, 0, SEEK_END) == 0)
+	&& ((size = ftell(fhandle)) > 0)
+	&& (fseek(fhandle, 0, SEEK_SET) == 0)
+	&& ((buf = malloc((size_t) size)) != NULL))
+	{
+		*len = fread(buf, sizeof(char), (size_t) size, fhandle);
+
+		if (*len != (size_t) size)
+		{
+			free(buf);
+			buf = NULL;
+		}
+	}
+
+	fclose(fhandle);
+
+	return buf;
+}
+
+static uint64_t fileSize(const char *path)
+{
+	FILE *fhandle = fopen(path, "rb");
+	long size = 0;
+
+	if (fhandle != NULL)
+	{
+		if (fseek(fhandle, 0, SEEK_END) == 0)
+		{
+			size = ftell(fhandle);
+		}
+
+		fclose(fhandle);
+	}
+
+	return (size > 0) ? (uint64_t) size : 0;
+}
+
+static SDC_STAT runOne(struct sdc_context *ctx, const char *in_path,
+	const char *out_path, const size_t runs, const SDC_BOOL use_buffer,
+	struct e2eResult *res)
+{
+	struct ioCounters before, after, overhead;
+	struct rusage usage_before, usage_after;
+	char *in_buf    = NULL;
+	size_t in_len   = 0;
+	double total    = 0.0;
+	size_t i;
+	SDC_STAT ret_code = SDC_SUCCESS;
+
+	memset(res, 0, sizeof(*res));
+	res->path      = in_path;
+	res->best_secs = -1.0;
+
+	if ((use_buffer == SDC_TRUE)
+	&& ((in_buf = slurpFile(in_path, &in_len)) == NULL))
+	{
+		fprintf(stderr, "Failure to read '%s'\n", in_path);
+
+		return SDC_FAILURE;
+	}
+
+	/* Reading /proc/self/io costs syscalls of its own, measured here so
+	 * they can be taken back out */
+	readIoCounters(&before);
+	readIoCounters(&after);
+	overhead.syscr = after.syscr - before.syscr;
+	overhead.syscw = after.syscw - before.syscw;
+	overhead.rchar = after.rchar - before.rchar;
+	overhead.wchar = after.wchar - before.wchar;
+
+	getrusage(RUSAGE_SELF, &usage_before);
+	readIoCounters(&before);
+
+	for (i = 0; (i < runs) && (ret_code == SDC_SUCCESS); i++)
+	{
+		const double start = nowSeconds();
+		double elapsed;
+
+		if (use_buffer == SDC_TRUE)
+		{
+			void *out = NULL;
+			size_t out_len = 0;
+
+			ret_code = sdcConvertBuffer(ctx, in_buf, in_len, &out,
+				&out_len);
+			sdcFree(ctx, out);
+			res->out_bytes = out_len;
+		}
+		else
+		{
+			ret_code = sdcConvertFile(ctx, in_path, out_path);
+		}
+
+		elapsed = nowSeconds() - start;
+		total += elapsed;
+
+		if ((res->best_secs < 0.0) || (elapsed < res->best_secs))
+		{
+			res->best_secs = elapsed;
+		}
+	}
+
+	readIoCounters(&after);
+	getrusage(RUSAGE_SELF, &usage_after);
+
+	if (ret_code == SDC_FAILURE)
+	{
+		fprintf(stderr, "Conversion of '%s' failed\n", in_path);
+		free(in_buf);
+
+		return SDC_FAILURE;
+	}
+
+	res->in_bytes     = fileSize(in_path);
+	res->out_bytes    = (use_buffer == SDC_TRUE)
+		? res->out_bytes : fileSize(out_path);
+	res->mean_secs    = total / (double) runs;
+	res->peak_rss_kb  = usage_after.ru_maxrss;
+	res->minor_faults = (usage_after.ru_minflt - usage_before.ru_minflt)
+		/ (long) runs;
+	res->major_faults = (usage_after.ru_majflt - usage_before.ru_majflt)
+		/ (long) runs;
+
+	if (after.syscr >= 0)
+	{
+		res->io.syscr = (after.syscr - before.syscr - overhead.syscr)
+			/ (long long) runs;
+		res->io.syscw = (after.syscw - before.syscw - overhead.syscw)
+			/ (long long) runs;
+		res->io.rchar = (after.rchar - before.rchar - overhead.rchar)
+			/ (long long) runs;
+		res->io.wchar = (after.wchar - before.wchar - overhead.wchar)
+			/ (long long) runs;
+	}
+	else
+	{
+		res->io = after;
+	}
+
+	free(in_buf);
+
+	return SDC_SUCCESS;
+}
+
+static void addJsonResult(struct cJSON *arr, const struct e2eResult *res)
+{
+	struct cJSON *item = cJSON_CreateObject();
+
+	if ((item == NULL) || (cJSON_AddItemToArray(arr, item) == 0))
+	{
+		cJSON_Delete(item);
+
+		return;
+	}
+
+	cJSON_AddStringToObject(item, "file", res->path);
+	cJSON_AddNumberToObject(item, "in_bytes", (double) res->in_bytes);
+	cJSON_AddNumberToObject(item, "out_bytes", (double) res->out_bytes);
+	cJSON_AddNumberToObject(item, "best_secs", res->best_secs);
+	cJSON_AddNumberToObject(item, "mean_secs", res->mean_secs);
+	cJSON_AddNumberToObject(item, "mb_per_sec",
+		((double) res->in_bytes / res->best_secs) / 1e6);
+	cJSON_AddNumberToObject(item, "peak_rss_kb",
+		(double) res->peak_rss_kb);
+	cJSON_AddNumberToObject(item, "minor_faults",
+		(double) res->minor_faults);
+	cJSON_AddNumberToObject(item, "major_faults",
+		(double) res->major_faults);
+	cJSON_AddNumberToObject(item, "syscr", (double) res->io.syscr);
+	cJSON_AddNumberToObject(item, "syscw", (double) res->io.syscw);
+	cJSON_AddNumberToObject(item, "rchar", (double) res->io.rchar);
+	cJSON_AddNumberToObject(item, "wchar", (double) res->io.wchar);
+}
+
+static void printResult(const struct e2eResult *res)
+{
+	printf("%s\n"
+		"\tin / out bytes : %llu / %llu\n"
+		"\tbest / mean    : %.4f s / %.4f s\n"
+		"\tthroughput     : %.2f MB/s\n"
+		"\tpeak RSS       : %ld KiB\n"
+		"\tpage faults    : %ld minor, %ld major\n"
+		"\tread syscalls  : %lld (%lld bytes)\n"
+		"\twrite syscalls : %lld (%lld bytes)\n",
+		res->path, (unsigned long long) res->in_bytes,
+		(unsigned long long) res->out_bytes, res->best_secs,
+		res->mean_secs, ((double) res->in_bytes / res->best_secs)
+		/ 1e6, res->peak_rss_kb, res->minor_faults,
+		res->major_faults, res->io.syscr, res->io.rchar,
+		res->io.syscw, res->io.wchar);
+}
+
+static void printHelp(void)
+{
+	fputs("sdc_e2e, SDC end-to-end conversion benchmark\n\n"
+		"-i, --input <FILE PATH>          : File to convert,"
+			" repeatable\n"
+		"-o, --output <FILE PATH>         : Scratch output,"
+			" default sdc_e2e.safetensors\n"
+		"-f, --float-out {F32, F16, BF16} : Float output type\n"
+		"-r, --rule <PATTERN=DTYPE>       : Per-tensor dtype rule,"
+			" repeatable\n"
+		"-n, --runs <COUNT>               : Runs per file, default 3\n"
+		"-b, --buffer                     : Uses sdcConvertBuffer on"
+			" a file read beforehand\n"
+		"-j, --json                       : Prints results as JSON\n"
+		"-h, --help                       : Prints this help"
+			" message\n\n"
+		"Syscall and fault counts are per run, peak RSS is that of the"
+			" whole process so far\n",
+		stdout);
+}
+
+int main(int argc, char **argv)
+{
+	const struct portoptVerboseOpt opts[] =
+	{
+		{'i', "input",     PORTOPT_TRUE},
+		{'o', "output",    PORTOPT_TRUE},
+		{'f', "float-out", PORTOPT_TRUE},
+		{'r', "rule",      PORTOPT_TRUE},
+		{'n', "runs",      PORTOPT_TRUE},
+		{'b', "buffer",    PORTOPT_FALSE},
+		{'j', "json",      PORTOPT_FALSE},
+		{'h', "help",      PORTOPT_FALSE}
+	};
+	const size_t num_opts = sizeof(opts) / sizeof(opts[0]);
+	const size_t lenc = (size_t) argc;
+	const char *inputs[SDC_E2E_MAX_INPUTS];
+	struct sdc_context *ctx = NULL;
+	struct cJSON *json_arr  = NULL;
+	const char *out_path    = "sdc_e2e.safetensors";
+	const char *arg;
+	struct e2eResult res;
+	SDC_BOOL use_buffer = SDC_FALSE;
+	SDC_BOOL json       = SDC_FALSE;
+	size_t num_inputs   = 0;
+	size_t runs         = 3;
+	size_t ind = 0;
+	size_t i;
+	SDC_STAT ret_code = SDC_SUCCESS;
+	int flag;
+
+	if ((ctx = sdcCreateContext(NULL)) == NULL)
+	{
+		fputs("Failure to create conversion context\n", stderr);
+
+		return SDC_FAILURE;
+	}
+
+	while ((flag = portoptVerbose(lenc, argv, opts, num_opts, &ind)) != -1)
+	{
+		switch (flag)
+		{
+			case 'i':
+				arg = portoptGetArg(lenc, argv, &ind);
+
+				if ((arg != NULL)
+				&& (num_inputs < SDC_E2E_MAX_INPUTS))
+				{
+					inputs[num_inputs++] = arg;
+				}
+				break;
+			case 'o':
+				out_path = portoptGetArg(lenc, argv, &ind);
+				break;
+			case 'f':
+				ret_code = sdcSetFloatOut(ctx, portoptGetArg(
+					lenc, argv, &ind));
+				break;
+			case 'r':
+				ret_code = sdcAddRule(ctx, portoptGetArg(lenc,
+					argv, &ind));
+				break;
+			case 'n':
+				arg = portoptGetArg(lenc, argv, &ind);
+				runs = (arg != NULL)
+					? (size_t) strtoul(arg, NULL, 10) : 0;
+				break;
+			case 'b':
+				use_buffer = SDC_TRUE;
+				break;
+			case 'j':
+				json = SDC_TRUE;
+				break;
+			case 'h':
+				printHelp();
+				sdcDestroyContext(ctx);
+				return SDC_SUCCESS;
+			case '?':
+			default: /* fallthrough */
+				fputs("Unknown switch\n", stderr);
+				break;
+		}
+
+		if (ret_code == SDC_FAILURE)
+		{
+			fputs("Invalid --float-out or --rule\n", stderr);
+			sdcDestroyContext(ctx);
+
+			return SDC_FAILURE;
+		}
+	}
+
+	if ((num_inputs == 0) || (runs == 0) || (out_path == NULL))
+	{
+		fputs("At least one input and run are required, see --help\n",
+			stderr);
+		sdcDestroyContext(ctx);
+
+		return SDC_FAILURE;
+	}
+
+	if ((json == SDC_TRUE) && ((json_arr = cJSON_CreateArray()) == NULL))
+	{
+		sdcDestroyContext(ctx);
+
+		return SDC_FAILURE;
+	}
+
+	for (i = 0; (i < num_inputs) && (ret_code == SDC_SUCCESS); i++)
+	{
+		if ((ret_code = runOne(ctx, inputs[i], out_path, runs,
+			use_buffer, &res)) == SDC_FAILURE)
+		{
+			break;
+		}
+
+		if (json_arr != NULL)
+		{
+			addJsonResult(json_arr, &res);
+		}
+		else
+		{
+			printResult(&res);
+		}
+	}
+
+	if (json_arr != NULL)
+	{
+		char *out = cJSON_Print(json_arr);
+
+		if (out != NULL)
+		{
+			puts(out);
+			cJSON_free(out);
+		}
+
+		cJSON_Delete(json_arr);
+	}
+
+	if (use_buffer == SDC_FALSE)
+	{
+		remove(out_path);
+	}
+
+	sdcDestroyContext(ctx);
+
+	return ret_code;
+}
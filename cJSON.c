@@ -1199,9 +1199,13 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value,
 	parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
 	cJSON *item = NULL;
 
-	/* reset error position */
-	global_error.json = NULL;
-	global_error.position = 0;
+	/* reset error position, callers passing return_parse_end get it there
+	 * instead so that parsing on several threads races on nothing */
+	if (return_parse_end == NULL)
+	{
+		global_error.json = NULL;
+		global_error.position = 0;
+	}
 
 	if (value == NULL || 0 == buffer_length)
 	{
@@ -1270,8 +1274,10 @@ fail:
 		{
 			*return_parse_end = (const char *)local_error.json + local_error.position;
 		}
-
-		global_error = local_error;
+		else
+		{
+			global_error = local_error;
+		}
 	}
 
 	return NULL;
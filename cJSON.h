@@ -166,8 +166,8 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithLength(const char *value,
 /* ParseWithOpts allows you to require (and check) that the JSON is null 
  * terminated, and to retrieve the pointer to the final byte parsed. */
 /* If you supply a ptr in return_parse_end and parsing fails, then 
- * return_parse_end will contain a pointer to the error so will match 
- * cJSON_GetErrorPtr(). */
+ * return_parse_end will contain a pointer to the error, which is then not 
+ * recorded for cJSON_GetErrorPtr() so that no global is written. */
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value,
 	const char **return_parse_end, cJSON_bool require_null_terminated);
 CJSON_PUBLIC(cJSON *) cJSON_ParseWithLengthOpts(const char *value,
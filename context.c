@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "context.h"
+#include "converting.h"
+#include "kernels.h"
+
+#define SDC_LOG_BUF_LEN 512
+
+static void* stdMalloc(void *user, size_t size)
+{
+	(void) user;
+
+	return malloc(size);
+}
+
+static void* stdRealloc(void *user, void *ptr, size_t size)
+{
+	(void) user;
+
+	return realloc(ptr, size);
+}
+
+static void stdFree(void *user, void *ptr)
+{
+	(void) user;
+
+	free(ptr);
+}
+
+static void stdLog(void *user, const enum sdcLogLevel level, const char *msg)
+{
+	(void) user;
+
+	fputs(msg, (level == SDC_LOG_INFO) ? stdout : stderr);
+}
+
+struct sdc_context* sdcCreateContext(const struct sdcAllocator *alloc)
+{
+	const struct sdcAllocator std_alloc = {stdMalloc, stdRealloc, stdFree,
+		NULL};
+	struct sdc_context *ctx = NULL;
+
+	if (alloc == NULL)
+	{
+		alloc = &std_alloc;
+	}
+
+	if ((alloc->malloc_func == NULL) || (alloc->realloc_func == NULL)
+	|| (alloc->free_func == NULL))
+	{
+		return NULL;
+	}
+
+	if ((ctx = alloc->malloc_func(alloc->user, sizeof(*ctx))) == NULL)
+	{
+		return NULL;
+	}
+
+	/* Process wide state is settled here, before any conversion */
+	memoryInstallJsonHooks();
+	getCpuIsa();
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->float_out   = FLOAT_32;
+	ctx->auto_budget = SDC_AUTO_BUDGET;
+	ctx->alloc       = *alloc;
+	ctx->log_func    = stdLog;
+
+	return ctx;
+}
+
+void sdcDestroyContext(struct sdc_context *ctx)
+{
+	if (ctx == NULL)
+	{
+		return;
+	}
+
+	freeDtypeRules(ctx, &ctx->rules);
+	freeNameFilter(ctx, &ctx->filter);
+	memoryArenaFree(ctx);
+	statsClear(ctx);
+	traceClear(ctx);
+	ctx->alloc.free_func(ctx->alloc.user, ctx);
+}
+
+static void logVa(struct sdc_context *ctx, const enum sdcLogLevel level,
+	const char *fmt, va_list args)
+{
+	char buf[SDC_LOG_BUF_LEN];
+	char *msg = buf;
+	va_list copy;
+	int len;
+
+	va_copy(copy, args);
+	len = vsnprintf(buf, sizeof(buf), fmt, args);
+
+	/* Only the rare long message pays for an allocation */
+	if ((len >= (int) sizeof(buf))
+	&& ((msg = sdcMalloc(ctx, (size_t) len + 1)) != NULL))
+	{
+		vsnprintf(msg, (size_t) len + 1, fmt, copy);
+	}
+	else if (msg == NULL)
+	{
+		msg = buf;
+	}
+
+	va_end(copy);
+
+	if (len >= 0)
+	{
+		ctx->log_func(ctx->log_user, level, msg);
+	}
+
+	if (msg != buf)
+	{
+		sdcFree(ctx, msg);
+	}
+}
+
+void sdcLog(struct sdc_context *ctx, const enum sdcLogLevel level,
+	const char *fmt, ...)
+{
+	va_list args;
+
+	if ((level == SDC_LOG_INFO) && (ctx->verbose == SDC_FALSE))
+	{
+		return;
+	}
+
+	va_start(args, fmt);
+	logVa(ctx, level, fmt, args);
+	va_end(args);
+}
+
+void verbosePrintf(struct sdc_context *ctx, const char *fmt, ...)
+{
+	if (ctx->verbose == SDC_TRUE)
+	{
+		va_list args;
+		va_start(args, fmt);
+		logVa(ctx, SDC_LOG_INFO, fmt, args);
+		va_end(args);
+	}
+}
+
+void errorPrintf(struct sdc_context *ctx, const char *fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	logVa(ctx, SDC_LOG_ERROR, fmt, args);
+	va_end(args);
+}
+
+SDC_STAT sdcSetFloatOut(struct sdc_context *ctx, const char *dtype_name)
+{
+	size_t i;
+
+	if (dtype_name == NULL)
+	{
+		return SDC_FAILURE;
+	}
+
+	/* Integer tensors still need somewhere to go, F32 as by default */
+	if (strcmp(dtype_name, "auto") == 0)
+	{
+		ctx->float_out  = FLOAT_32;
+		ctx->float_auto = AUTO_BUDGET;
+
+		return SDC_SUCCESS;
+	}
+
+	if (strcmp(dtype_name, "lossless") == 0)
+	{
+		ctx->float_out  = FLOAT_32;
+		ctx->float_auto = AUTO_LOSSLESS;
+
+		return SDC_SUCCESS;
+	}
+
+	for (i = 0; i < dtype_info_len; i++)
+	{
+		if ((strcmp(dtype_name, dtype_info[i].name) == 0)
+		&& ((dtype_info[i].dtype == FLOAT_32)
+			|| (dtype_info[i].dtype == FLOAT_16)
+			|| (dtype_info[i].dtype == BFLOAT_16)))
+		{
+			ctx->float_out  = dtype_info[i].dtype;
+			ctx->float_auto = AUTO_OFF;
+
+			return SDC_SUCCESS;
+		}
+	}
+
+	return SDC_FAILURE;
+}
+
+SDC_STAT sdcSetAutoBudget(struct sdc_context *ctx, const double max_rel)
+{
+	if (!(max_rel > 0.0))
+	{
+		errorPrintf(ctx, "%s: Auto budget must be above zero\n",
+			__func__);
+
+		return SDC_FAILURE;
+	}
+
+	ctx->auto_budget = max_rel;
+
+	return SDC_SUCCESS;
+}
+
+void sdcSetVerbose(struct sdc_context *ctx, const SDC_BOOL verbose)
+{
+	ctx->verbose = verbose;
+}
+
+void sdcSetInplace(struct sdc_context *ctx, const SDC_BOOL inplace)
+{
+	ctx->inplace = inplace;
+}
+
+void sdcSetCacheFriendly(struct sdc_context *ctx, const SDC_BOOL enabled)
+{
+	ctx->cache_friendly = enabled;
+}
+
+void sdcSetDirectIO(struct sdc_context *ctx, const SDC_BOOL enabled)
+{
+	ctx->direct_io = enabled;
+}
+
+void sdcSetHash(struct sdc_context *ctx, const SDC_BOOL enabled)
+{
+	ctx->hash_output = enabled;
+}
+
+void sdcSetThreads(struct sdc_context *ctx, const unsigned threads)
+{
+	ctx->threads = threads;
+}
+
+void sdcSetLogger(struct sdc_context *ctx, const sdcLogFunc func, void *user)
+{
+	ctx->log_func = (func != NULL) ? func : stdLog;
+	ctx->log_user = user;
+}
+
+void sdcSetProgress(struct sdc_context *ctx, const sdcProgressFunc func,
+	void *user, const unsigned interval_ms)
+{
+	ctx->progress.func     = func;
+	ctx->progress.user     = user;
+	ctx->progress.interval = (double) interval_ms / 1e3;
+	ctx->progress.active   = SDC_FALSE;
+}
+
+SDC_STAT sdcAddRule(struct sdc_context *ctx, const char *rule)
+{
+	return addDtypeRule(ctx, &ctx->rules, rule);
+}
+
+SDC_STAT sdcLoadRules(struct sdc_context *ctx, const char *file_path)
+{
+	return loadDtypeRules(ctx, &ctx->rules, file_path);
+}
+
+SDC_STAT sdcAddInclude(struct sdc_context *ctx, const char *pattern)
+{
+	return addNamePattern(ctx, &ctx->filter.include, pattern);
+}
+
+SDC_STAT sdcAddExclude(struct sdc_context *ctx, const char *pattern)
+{
+	return addNamePattern(ctx, &ctx->filter.exclude, pattern);
+}
+
+void sdcSetCollectStats(struct sdc_context *ctx, const SDC_BOOL collect)
+{
+	ctx->collect_stats = collect;
+}
+
+const struct sdcStats* sdcGetStats(const struct sdc_context *ctx)
+{
+	return &ctx->stats;
+}
+
+/* Whatever is still allocated stays counted, it will be freed later */
+void sdcResetStats(struct sdc_context *ctx)
+{
+	uint64_t mem_current;
+
+	statsClear(ctx);
+	mem_current = ctx->stats.mem_current;
+	memset(&ctx->stats, 0, sizeof(ctx->stats));
+	ctx->stats.mem_current = mem_current;
+	ctx->stats.mem_peak    = mem_current;
+}
+
+const char* sdcDtypeName(const enum dataType dtype)
+{
+	return (dtype < DTYPE_UNKNOWN) ? dtype_info[dtype].name : "UNKNOWN";
+}
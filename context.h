@@ -0,0 +1,53 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include "main.h"
+#include "rules.h"
+#include "stats.h"
+#include "progress.h"
+#include "trace.h"
+#include "memory.h"
+
+#if defined(__GNUC__)
+#define SDC_THREAD_LOCAL __thread
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) \
+	&& !defined(__STDC_NO_THREADS__)
+#define SDC_THREAD_LOCAL _Thread_local
+#else
+#define SDC_THREAD_LOCAL
+#endif
+
+/* Everything a conversion needs beyond its input and output, the library
+ * keeps no other mutable state */
+struct sdc_context
+{
+	enum dataType float_out;
+	enum autoMode float_auto;
+	double auto_budget;
+	SDC_BOOL verbose;
+	SDC_BOOL inplace;
+	SDC_BOOL cache_friendly;
+	SDC_BOOL direct_io;
+	SDC_BOOL large_seek_warned;
+	SDC_BOOL hash_output;
+	unsigned threads;
+	struct ruleSet rules;
+	struct nameFilter filter;
+	struct sdcAllocator alloc;
+	sdcLogFunc log_func;
+	void *log_user;
+	struct sdcStats stats;
+	SDC_BOOL collect_stats;
+	struct statsLog stats_log;
+	struct progressState progress;
+	struct traceState trace;
+	const char *mem_tensor;
+	struct memoryArena json_arena;
+};
+
+void sdcLog(struct sdc_context *ctx, const enum sdcLogLevel level,
+	const char *fmt, ...);
+void verbosePrintf(struct sdc_context *ctx, const char *fmt, ...);
+void errorPrintf(struct sdc_context *ctx, const char *fmt, ...);
+
+#endif /* CONTEXT_H */
@@ -3,59 +3,8 @@
 #include <string.h>
 
 #include "converting.h"
-#include "fileLoading.h" /* for verbosePrintf */
-
-#define SDC_MIN(x, y) ((x) < (y) ? (x) : (y))
-#define SDC_MAX(x, y) ((x) > (y) ? (x) : (y))
-#define SDC_CLAMP(min, x, max) (SDC_MIN(SDC_MAX(x, min), max))
-
-#define SDC_INT_TO_I64(type, in, out, len)                     \
-do                                                             \
-{                                                              \
-	size_t iti_i;                                          \
-	                                                       \
-	for (iti_i = 0; iti_i < len; iti_i++)                  \
-	{                                                      \
-		((int64_t *) out)[iti_i]                       \
-			= (int64_t) (((type *) in)[iti_i]);    \
-	}                                                      \
-} while (0)
-
-#define SDC_DOWNCONVERT(in_type, in, out_type, out, max, min, len)     \
-do                                                                     \
-{                                                                      \
-	size_t dc_i;                                                   \
-	                                                               \
-	for (dc_i = 0; dc_i < len; dc_i++)                             \
-	{                                                              \
-		if (((in_type *) in)[dc_i] < min)                      \
-		{                                                      \
-			((out_type *) out)[dc_i] = min;                \
-		}                                                      \
-		else if (((in_type *) in)[dc_i] > max)                 \
-		{                                                      \
-			((out_type *) out)[dc_i] = max;                \
-		}                                                      \
-		else                                                   \
-		{                                                      \
-			((out_type *) out)[dc_i]                       \
-				= (out_type) (((in_type *) in)[dc_i]); \
-		}                                                      \
-	}                                                              \
-} while (0)
-
-enum dataType float_out = FLOAT_32;
-
-enum
-{
-	INCOMING = 0,
-	OUTGOING
-};
-
-struct
-{
-	size_t type[2][NUM_DATA_TYPE];
-} conversion_info = {0};
+#include "context.h"
+#include "kernels.h"
 
 /* IEEE double-precision float */
 /* 1 sign bit
@@ -77,233 +26,202 @@ struct
  * 8 exponent bits
  * 7 fraction bits */
 
-void dumpTypeInfo(void)
+void dumpTypeInfo(struct sdc_context *ctx)
 {
 	size_t i;
 
-	verbosePrintf("\nData type conversion information\n");
+	verbosePrintf(ctx, "\nData type conversion information\n");
 
 	for (i = 0; i < UNSIGNED_8; i++)
 	{
-		verbosePrintf("%s:\t%-4lu -> %lu\n",
+		verbosePrintf(ctx, "%s:\t%-4lu -> %lu\n",
 			dtype_strs[i], 
-			conversion_info.type[INCOMING][i],
-			conversion_info.type[OUTGOING][i]);
+			ctx->stats.type_in[i],
+			ctx->stats.type_out[i]);
 	}
-}
-
-/* Helper function to get around strict aliasing */
-static uint32_t asU32(const float in) 
-{
-	uint32_t out = 0;
-
-	memcpy(&out, &in, sizeof(float));
 
-	return out;
-}
-
-static float asF32(const uint32_t in)
-{
-	float out = 0;
-
-	memcpy(&out, &in, sizeof(float));
-
-	return out;
-}
-
-/* Adapted from Maratyszcza's FP16 header library */
-static uint16_t fltToHlf(const float in)
-{
-	const float scale_to_inf  = asF32(0x77800000);
-	const float scale_to_zero = asF32(0x08800000);
-	const uint32_t u32_in     = asU32(in);
-	const uint32_t shl1       = u32_in << 1;
-	const uint32_t sign       = u32_in & 0x80000000;
-	uint32_t bias             = SDC_MAX((shl1 & 0xFF000000), 0x71000000);
-	float base = ((((in < 0.f) ? -in : in) * scale_to_inf) * scale_to_zero)
-		+ asF32((bias >> 1) + 0x07800000);
-	uint32_t nonsign = ((asU32(base) >> 13) & 0x00007C00) 
-		+ (asU32(base) & 0x00000FFF);
-
-	return (uint16_t) ((sign >> 16) | ((shl1 > 0xFF000000) 
-		? 0x7E00 : nonsign));
-}
+	verbosePrintf(ctx, "\nPeak memory: %lu bytes", ctx->stats.mem_peak);
 
-static uint16_t dblToBft(const double in)
-{
-	const float flt = ((float) in) * 1.001957f;
+	if (ctx->stats.mem_peak_tensor[0] != '\0')
+	{
+		verbosePrintf(ctx, " converting %s",
+			ctx->stats.mem_peak_tensor);
+	}
 
-	return (uint16_t) (asU32(flt) >> 16);
-}
+	if (ctx->stats.mem_predicted_peak != 0)
+	{
+		verbosePrintf(ctx, ", %lu predicted",
+			ctx->stats.mem_predicted_peak);
+	}
 
-static void doubleToHalf(const double *in, uint16_t *out, const size_t len)
-{
-	size_t i;
+	verbosePrintf(ctx, "\n");
 
-	for (i = 0; i < len; i++)
+	if (ctx->collect_stats == SDC_TRUE)
 	{
-		out[i] = fltToHlf((float) in[i]);
+		verbosePrintf(ctx, "Conversion error: %g max absolute, "
+			"%g max relative, %lu overflowed, %lu underflowed, "
+			"%lu NaN\n", ctx->stats.error.max_abs,
+			ctx->stats.error.max_rel,
+			ctx->stats.error.overflow, ctx->stats.error.underflow,
+			ctx->stats.error.nan);
 	}
 }
 
-static void signed64ToHalf(const int64_t *in, uint16_t *out, const size_t len)
+/* Without a rule every float and signed integer tensor goes to float_out, 
+ * except for the half types which only ever convert across to the other 
+ * half type as widening them gains nothing */
+enum dataType defaultOutputType(const struct sdc_context *ctx,
+	const enum dataType in_type)
 {
-	size_t i;
-
-	for (i = 0; i < len; i++)
+	if ((in_type >= UNSIGNED_8)
+	|| ((SDC_DTYPE_IS_HALF(in_type) == SDC_TRUE) 
+		&& (SDC_DTYPE_IS_HALF(ctx->float_out) == SDC_FALSE)))
 	{
-		out[i] = fltToHlf((float) in[i]);
+		return in_type;
 	}
+
+	return ctx->float_out;
 }
 
-static void doubleToBrain(const double *in, uint16_t *out, const size_t len)
+/* Narrowest first, F16 ahead of BF16 for its precision. The worst case
+ * relative error is eps for normal values, growing as values get into the
+ * subnormals where the absolute error is up to half the smallest one */
+static const struct
 {
-	size_t i;
+	const enum dataType dtype;
+	const double eps;
+	const double min_sub;
+	const double max;
+} auto_types[] =
+{
+	{FLOAT_16,  0x1p-11, 0x1p-24,  SDC_HLF_MAX},
+	{BFLOAT_16, 0x1p-8,  0x1p-133, SDC_BFT_MAX},
+	{FLOAT_32,  0x1p-24, 0x1p-149, FLT_MAX}
+};
 
-	for (i = 0; i < len; i++)
-	{
-		out[i] = dblToBft(in[i]);
-	}
-}
+/* Integers narrow only to those they fit in, narrowest first */
+static const struct
+{
+	const enum dataType dtype;
+	const double min;
+	const double max;
+} narrow_types[] =
+{
+	{SIGNED_8,  INT8_MIN,  INT8_MAX},
+	{SIGNED_16, INT16_MIN, INT16_MAX},
+	{SIGNED_32, INT32_MIN, INT32_MAX}
+};
 
-static void signed64ToBrain(const int64_t *in, uint16_t *out, const size_t len)
+/* The narrowest dtype narrower than in_type converting losslessly, or else
+ * within the budget without saturating anything, keeping in_type if none.
+ * Lossless mode has no budget */
+enum dataType autoOutputType(const struct sdc_context *ctx,
+	const enum dataType in_type, const struct sdcRange *range,
+	const enum autoMode mode)
 {
+	const double budget  = (mode == AUTO_LOSSLESS) ? 0.0 
+		: ctx->auto_budget;
+	const double abs_max = (-range->min > range->max)
+		? -range->min : range->max;
 	size_t i;
 
-	for (i = 0; i < len; i++)
+	if (SDC_DTYPE_IS_FLOAT(in_type) == SDC_FALSE)
 	{
-		out[i] = dblToBft((double) in[i]);
-	}
-}
+		for (i = 0; i < sizeof(narrow_types) / sizeof(narrow_types[0]);
+			i++)
+		{
+			if ((dtype_info[narrow_types[i].dtype].size
+				< dtype_info[in_type].size)
+			&& (range->min >= narrow_types[i].min)
+			&& (range->max <= narrow_types[i].max))
+			{
+				return narrow_types[i].dtype;
+			}
+		}
 
-/* All float values can be represented accurately as a double so this rather
- * trivial */
-static void floatToDouble(const float *in, double *out, const size_t len)
-{
-	size_t i;
+		return in_type;
+	}
 
-	for (i = 0; i < len; i++)
+	for (i = 0; i < sizeof(auto_types) / sizeof(auto_types[0]); i++)
 	{
-		out[i] = (double) in[i];
+		const enum dataType dtype = auto_types[i].dtype;
+		double worst = auto_types[i].eps;
+
+		if (dtype_info[dtype].size >= dtype_info[in_type].size)
+		{
+			continue;
+		}
+
+		if (range->inexact[dtype] == 0)
+		{
+			return dtype;
+		}
+
+		if (abs_max > auto_types[i].max)
+		{
+			continue;
+		}
+
+		if ((auto_types[i].min_sub * 0.5) / range->abs_min > worst)
+		{
+			worst = (auto_types[i].min_sub * 0.5) / range->abs_min;
+		}
+
+		if (worst <= budget)
+		{
+			return dtype;
+		}
 	}
 
-	return;
+	return in_type;
 }
 
-char* downConvertDTypes(char *in, const size_t len, 
-	const enum dataType in_type, enum dataType *out_type)
+char* downConvertDTypes(struct sdc_context *ctx, char *in, const size_t len, 
+	const enum dataType in_type, const enum dataType out_type,
+	struct sdcConvError *err)
 {
-	/* Both int64_t and double should be eight bytes long */
-	char *tmp_arr = calloc(len, 8);
 	char *out_arr = NULL;
+	sdcKernel kernel;
 
-	conversion_info.type[INCOMING][in_type]++;
-
-	switch (in_type)
+	if ((in_type >= DTYPE_UNKNOWN) || (out_type >= DTYPE_UNKNOWN))
 	{
-		case FLOAT_64:
-			memcpy(tmp_arr, in, len * sizeof(double));
-			break;
-		case FLOAT_32:
-			/* SDC_FLT_TO_F64(float, in, tmp_arr, len); */
-			floatToDouble((float *) in, (double *) tmp_arr, len);
-			break;
-		/* If the input is either F16 or BF16 already there isn't 
-		 * much reason to touch them at the moment */
-		case FLOAT_16:
-			*out_type = FLOAT_16;
-			out_arr = malloc(sizeof(uint16_t) * len);
-			memcpy(out_arr, in, len * sizeof(uint16_t));
-			conversion_info.type[OUTGOING][*out_type]++;
-			free(tmp_arr);
-			return out_arr;
-		case BFLOAT_16:
-			*out_type = BFLOAT_16;
-			out_arr = malloc(sizeof(uint16_t) * len);
-			memcpy(out_arr, in, len * sizeof(uint16_t));
-			conversion_info.type[OUTGOING][*out_type]++;
-			free(tmp_arr);
-			return out_arr;
-		case SIGNED_64:
-			memcpy(tmp_arr, in, len * sizeof(int64_t));
-			break;
-		case SIGNED_32:
-			SDC_INT_TO_I64(int32_t, in, tmp_arr, len);
-			break;
-		case SIGNED_16:
-			SDC_INT_TO_I64(int16_t, in, tmp_arr, len);
-			break;
-		case SIGNED_8:
-			SDC_INT_TO_I64(int8_t, in, tmp_arr, len);
-			break;
-		case UNSIGNED_8:
-			SDC_INT_TO_I64(uint8_t, in, tmp_arr, len);
-			break;
-		case BOOLEAN: /* fallthrough */
-		default:
-			fprintf(stderr, "Unsupported dtype\n");
-			free(tmp_arr);
-			return NULL;
+		errorPrintf(ctx, "Unsupported dtype\n");
+
+		return NULL;
 	}
 
-	*out_type = float_out;
-	conversion_info.type[OUTGOING][*out_type]++;
-	out_arr = malloc(dtype_info[*out_type].size * len);
+	ctx->stats.type_in[in_type]++;
+	ctx->stats.type_out[out_type]++;
 
-	/* down-convert to target float */
-	switch (*out_type)
+	if ((out_arr = sdcMalloc(ctx, dtype_info[out_type].size * len)) == NULL)
 	{
-		case FLOAT_32:
-			if (SDC_DTYPE_IS_FLOAT(in_type) == SDC_TRUE)
-			{
-				SDC_DOWNCONVERT(double, tmp_arr, 
-					float, out_arr, 
-					FLT_MAX, -FLT_MAX, len);
-			}
-			else
-			{
-				SDC_DOWNCONVERT(int64_t, tmp_arr, 
-					float, out_arr, 
-					FLT_MAX, -FLT_MAX, len);
-			}
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
 
-			break;
-		case FLOAT_16:  
-			if (SDC_DTYPE_IS_FLOAT(in_type) == SDC_TRUE)
-			{
-				doubleToHalf((double *) tmp_arr, 
-					(uint16_t *) out_arr, len);
-			}
-			else
-			{
-				signed64ToHalf((int64_t *) tmp_arr, 
-					(uint16_t *) out_arr, len);
-			}
+		return NULL;
+	}
 
-			break;
-		case BFLOAT_16: 
-			if (SDC_DTYPE_IS_FLOAT(in_type) == SDC_TRUE)
-			{
-				doubleToBrain((double *) tmp_arr, 
-					(uint16_t *) out_arr, len);
-			}
-			else
-			{
-				signed64ToBrain((int64_t *) tmp_arr,
-					(uint16_t *) out_arr, len);
-			}
+	if (out_type == in_type)
+	{
+		memcpy(out_arr, in, len * dtype_info[in_type].size);
+
+		return out_arr;
+	}
+
+	if ((kernel = getConversionKernel(in_type, out_type)) != NULL)
+	{
+		kernel(in, out_arr, len, err);
 
-			break;
-		default:
-			fprintf(stderr, "Bad output type: %s\n",
-				dtype_info[*out_type].name);
-			free(tmp_arr);
-			free(out_arr);
+		if (err != NULL)
+		{
+			mergeConvError(&ctx->stats.error, err);
+		}
 
-			return NULL;
+		return out_arr;
 	}
 
-	free(tmp_arr);
+	errorPrintf(ctx, "%s: No conversion from %s to %s\n", __func__,
+		dtype_info[in_type].name, dtype_info[out_type].name);
+	sdcFree(ctx, out_arr);
 
-	return out_arr;
+	return NULL;
 }
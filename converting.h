@@ -2,8 +2,14 @@
 #define CONVERTING_H 
 
 #include "main.h"
+#include "rules.h"
 
 #define SDC_DTYPE_IS_FLOAT(type) (((type) < SIGNED_64) ? SDC_TRUE : SDC_FALSE)
+#define SDC_DTYPE_IS_HALF(type) \
+	((((type) == FLOAT_16) || ((type) == BFLOAT_16)) ? SDC_TRUE : SDC_FALSE)
+
+/* Default -f auto relative error budget, 2^-8 being BF16's precision */
+#define SDC_AUTO_BUDGET 0.00390625
 
 static struct
 {
@@ -29,9 +35,18 @@ static struct
 static const size_t dtype_info_len 
 	= sizeof(dtype_info) / sizeof(dtype_info[0]);
 
-char* downConvertDTypes(char *in, const size_t len, 
-	const enum dataType in_type, enum dataType *out_type);
-void dumpTypeInfo(void);
+enum dataType defaultOutputType(const struct sdc_context *ctx,
+	const enum dataType in_type);
+struct sdcRange;
+
+enum dataType autoOutputType(const struct sdc_context *ctx,
+	const enum dataType in_type, const struct sdcRange *range,
+	const enum autoMode mode);
+/* Given err the precision lost is measured into it, and the stats' total */
+char* downConvertDTypes(struct sdc_context *ctx, char *in, const size_t len, 
+	const enum dataType in_type, const enum dataType out_type,
+	struct sdcConvError *err);
+void dumpTypeInfo(struct sdc_context *ctx);
 
 #endif /* CONVERTING_H */
 
@@ -1,66 +1,59 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <stdarg.h>
-#include <assert.h>
 #include <string.h>
 #include <limits.h>
 #include <float.h>
+#include <math.h>
 
 #include "converting.h"
 #include "fileLoading.h"
+#include "context.h"
+#include "kernels.h"
+#include "rules.h"
+#include "io.h"
+#include "stats.h"
+#include "progress.h"
+#include "trace.h"
+#include "memory.h"
 #include "cJSON.h"
 
+/* Bytes of parsed tree per byte of header, what the arena starts out at */
+#define SDC_TREE_PER_BYTE 8
+/* cJSON_PrintPreallocated wants room past the terminator to print into */
+#define SDC_PRINT_SLACK 5
+/* Largest integer below which every integer is exactly a double */
+#define SDC_MAX_EXACT 9007199254740992.0
+#define SDC_MAX(a, b) (((a) > (b)) ? (a) : (b))
+#define SDC_MIN(a, b) (((a) < (b)) ? (a) : (b))
+
 /* TODO:
- * 	- Better float bounds checking 
+ * 	- Better float bounds checking
  */
 
-SDC_BOOL verbose_output = SDC_FALSE;
-SDC_BOOL inplace_conv   = SDC_FALSE;
-extern enum dataType float_out;
-
-void verbosePrintf(const char *fmt, ...)
-{
-	if (verbose_output == SDC_TRUE)
-	{
-		va_list args;
-		va_start(args, fmt);
-		vfprintf(stdout, fmt, args);
-		va_end(args);
-	}
-}
-
-
-static char* slurpHeader(FILE *fhandle, const size_t header_len)
+static char* slurpHeader(struct sdc_context *ctx, struct sdcReader *reader,
+	const size_t header_len)
 {
-	size_t bytes_read = 0;
 	char *slurp = NULL;
 
-	if (fhandle == NULL)
+	if ((slurp = sdcMalloc(ctx, sizeof(char) * header_len)) == NULL)
 	{
-		fprintf(stderr, "%s: Bad file handle argument\n", __func__);
-
-		return NULL;
-	}
-
-	if ((slurp = malloc(sizeof(char) * header_len)) == NULL)
-	{
-		fprintf(stderr, "%s: Failure to allocated header buffer\n",
+		errorPrintf(ctx, "%s: Failure to allocated header buffer\n",
 			__func__);
 
 		return NULL;
 	}
 
-	if ((bytes_read = fread(slurp, sizeof(char), header_len, fhandle))
-		!= header_len)
+	if (readerReadAt(ctx, reader, sizeof(uint64_t), slurp, header_len)
+		== SDC_FAILURE)
 	{
-		fprintf(stderr, "%s: Incomplete read, %lu / %lu\n",
-			__func__, bytes_read, header_len);
-		free(slurp);
+		errorPrintf(ctx, "%s: Incomplete header read of %lu bytes\n",
+			__func__, header_len);
+		sdcFree(ctx, slurp);
 
 		return NULL;
 	}
 
-	verbosePrintf("%s: %lu bytes read\n", __func__, bytes_read);
+	verbosePrintf(ctx, "%s: %lu bytes read\n", __func__, header_len);
 
 	return slurp;
 }
@@ -80,408 +73,1900 @@ static enum dataType extractDataType(const struct cJSON *target)
 	return DTYPE_UNKNOWN;
 }
 
-static char* extractRawData(FILE *fhandle, const struct cJSON *src,
-	const size_t binary_start, size_t *data_range)
+static char* extractRawData(struct sdc_context *ctx,
+	struct sdcReader *reader, const uint64_t offset, const uint64_t len)
 {
-	static SDC_BOOL large_seek_warned = SDC_FALSE;
-	struct cJSON *start_cur = NULL;
-	struct cJSON *end_cur   = NULL;
-	char *arr               = NULL;
-	size_t data_len;
+	char *arr = NULL;
 
-	if ((fhandle == NULL) || (src == NULL) || (data_range == NULL))
+	if ((len > SIZE_MAX)
+	|| ((arr = sdcMalloc(ctx, sizeof(char) * (size_t) len)) == NULL))
 	{
-		fprintf(stderr, "%s: bad args\n", __func__);
+		errorPrintf(ctx, "%s: Malloc failure for data\n", __func__);
 
 		return NULL;
 	}
 
-	start_cur = cJSON_GetArrayItem(src, 0);
-	end_cur   = cJSON_GetArrayItem(src, 1);
-
-	if ((start_cur == NULL) || (end_cur == NULL))
+	if (readerReadAt(ctx, reader, offset, arr, (size_t) len)
+		== SDC_FAILURE)
 	{
-		fprintf(stderr, "%s: Failure determining tensor data range\n",
-			__func__);
+		sdcFree(ctx, arr);
 
 		return NULL;
 	}
 
-	/* TODO: Figure out what the maximum integer value a double can 
-	 * represent and make sure that this doesn't exceed that because 
-	 * losing precision here could spoil everything but exact floating
-	 * point behavior is a can of worms I don't want to deal with right
-	 * now */
-	data_range[0] = (size_t) start_cur->valuedouble;
-	data_range[1] = (size_t) end_cur->valuedouble;
-	data_range[0] = PORTEGG_LE_TO_SYS(size_t, data_range[0]);
-	data_range[1] = PORTEGG_LE_TO_SYS(size_t, data_range[1]);
+	ctx->stats.bytes_read += len;
+
+	return arr;
+}
 
-	data_len = data_range[1] - data_range[0];
+/* Takes the number of elements rather than bytes */
+static char* rawDataArrayEndianness(struct sdc_context *ctx, char *data,
+	const size_t len, const enum dataType dtype, SDC_BOOL is_outgoing)
+{
+	size_t i;
 
-	if ((arr = malloc(sizeof(char) * (data_len))) == NULL)
+	if (dtype >= dtype_info_len)
 	{
-		fprintf(stderr, "%s: Malloc failure for data\n", __func__);
+		errorPrintf(ctx, "Unknown dtype %d\n", dtype);
 
-		return NULL;
+		return data;
 	}
 
-	if ((binary_start + data_range[0] > LONG_MAX)
-	&& (large_seek_warned == SDC_FALSE))
+	if (porteggIsLittle() == PORTEGG_TRUE)
 	{
-		fprintf(stderr, "%s: Attempting to seek to a range outside of "
-			"the historical capacity of fseek, if output doesn't "
-			"work this is the place to check first\n", __func__);
-
-		large_seek_warned = SDC_TRUE;
+		return data;
 	}
 
-	if (fseek(fhandle, binary_start + data_range[0], SEEK_SET) != 0)
+	for (i = 0; i < len; i++)
 	{
-		fprintf(stderr, "%s: Bad file seek\n", __func__);
-		free(arr);
+		if (is_outgoing == SDC_TRUE)
+		{
+			PORTEGG_SYS_TO_LE_RAW(dtype_info[dtype].size,
+				data + (i * dtype_info[dtype].size));
+		}
+		else
+		{
+			PORTEGG_LE_TO_SYS_RAW(dtype_info[dtype].size,
+				data + (i * dtype_info[dtype].size));
+		}
+	}
 
-		return NULL;
+	return data;
+}
+
+/* Whether a tensor is scanned to settle its dtype under mode, -f auto 
+ * leaving integers to its F32 fallback. Lossless mode keeps whatever it 
+ * cannot scan rather than risk converting it */
+static enum dataType settleAutoMode(const enum autoMode mode,
+	const enum dataType dtype, const enum dataType out_dtype,
+	enum autoMode *automatic)
+{
+	*automatic = ((getScanKernel(dtype) != NULL)
+		&& ((mode == AUTO_LOSSLESS)
+			|| (SDC_DTYPE_IS_FLOAT(dtype) == SDC_TRUE)))
+		? mode : AUTO_OFF;
+
+	return ((mode == AUTO_LOSSLESS) && (*automatic == AUTO_OFF))
+		? dtype : out_dtype;
+}
+
+/* Picks the output dtype for a tensor, the first matching rule if there is
+ * one and otherwise the --float-type default. *automatic is set should the
+ * tensor's data need scanning to settle on it */
+static enum dataType selectOutputType(struct sdc_context *ctx,
+	const struct cJSON *json_cursor, const enum dataType dtype,
+	const size_t data_len, enum autoMode *automatic)
+{
+	const struct dtypeRule *rule = NULL;
+	struct cJSON *shape_obj      = NULL;
+	struct cJSON *dim_obj        = NULL;
+	struct tensorDesc desc       = {0};
+	size_t *shape                = NULL;
+	enum dataType out_dtype;
+	size_t i = 0;
+
+	if (ctx->rules.len == 0)
+	{
+		return settleAutoMode(ctx->float_auto, dtype,
+			defaultOutputType(ctx, dtype), automatic);
 	}
 
-	if (fread(arr, sizeof(char), data_len, fhandle) != data_len)
+	desc.name  = json_cursor->string;
+	desc.dtype = dtype;
+	desc.numel = data_len / dtype_info[dtype].size;
+
+	if (((shape_obj = cJSON_GetObjectItemCaseSensitive(
+		json_cursor, "shape")) != NULL)
+	&& ((desc.ndim = (size_t) cJSON_GetArraySize(shape_obj)) > 0)
+	&& ((shape = sdcMalloc(ctx, desc.ndim * sizeof(size_t))) != NULL))
 	{
-		fprintf(stderr, "%s: Bad read from file\n", __func__);
-		free(arr);
+		cJSON_ArrayForEach(dim_obj, shape_obj)
+		{
+			shape[i++] = (size_t) dim_obj->valuedouble;
+		}
 
-		return NULL;
+		desc.shape = shape;
+	}
+	else
+	{
+		desc.ndim = 0;
 	}
 
-	return arr;
+	if ((rule = matchDtypeRule(&ctx->rules, &desc)) == NULL)
+	{
+		out_dtype = defaultOutputType(ctx, dtype);
+	}
+	else if ((rule->keep == SDC_TRUE)
+	|| (rule->automatic == AUTO_LOSSLESS))
+	{
+		out_dtype = dtype;
+	}
+	else if ((rule->target != dtype)
+	&& (getConversionKernel(dtype, rule->target) == NULL))
+	{
+		verbosePrintf(ctx, "%s: No conversion from %s to %s, keeping\n",
+			desc.name, dtype_info[dtype].name,
+			dtype_info[rule->target].name);
+		out_dtype = dtype;
+	}
+	else
+	{
+		out_dtype = rule->target;
+	}
+
+	sdcFree(ctx, shape);
+
+	return settleAutoMode((rule != NULL) ? rule->automatic
+		: ctx->float_auto, dtype, out_dtype, automatic);
 }
 
-static char* rawDataArrayEndianness(char *data, const size_t len, 
-	const enum dataType dtype, SDC_BOOL is_outgoing)
+/* Where a tensor comes from and goes to, worked out from the header before
+ * any data is touched so the output header can be written up front */
+struct tensorPlan
 {
-	size_t i;
+	struct cJSON *json;
+	size_t index;
+	enum dataType dtype;
+	enum dataType out_dtype;
+	uint64_t in_start;
+	uint64_t in_len;
+	uint64_t out_len;
+	enum autoMode automatic;  /* out_dtype is settled by a data scan */
+	uint64_t hash;
+	size_t hash_at;           /* of its placeholder in the header */
+};
+
+/* The output header from the first hash placeholder on, as printed, to
+ * be written again at tail_at once the hashes are known */
+struct hashStamp
+{
+	struct tensorPlan *plans;
+	size_t count;
+	char *tail;
+	size_t tail_len;
+	uint64_t tail_at;
+};
+
+static int comparePlans(const void *a, const void *b)
+{
+	const struct tensorPlan *lhs = a;
+	const struct tensorPlan *rhs = b;
 
-	if (dtype > dtype_info_len)
+	if (lhs->in_start != rhs->in_start)
 	{
-		fprintf(stderr, "Unknown dtype %d\n", dtype);
-
-		return data;
+		return (lhs->in_start < rhs->in_start) ? -1 : 1;
 	}
 
-	for (i = 0; i < len; i++)
+	return (lhs->index < rhs->index) ? -1 : (lhs->index > rhs->index);
+}
+
+struct tensorRange
+{
+	uint64_t start;
+	uint64_t end;
+	const char *name;
+};
+
+static int compareRanges(const void *a, const void *b)
+{
+	const struct tensorRange *lhs = a;
+	const struct tensorRange *rhs = b;
+
+	if (lhs->start != rhs->start)
 	{
-		if (is_outgoing == SDC_TRUE)
-		{
-			PORTEGG_SYS_TO_LE_RAW(dtype_info[dtype].size, 
-				data + (i * dtype_info[dtype].size));	
-		}
-		else
-		{
-			PORTEGG_LE_TO_SYS_RAW(dtype_info[dtype].size, 
-				data + (i * dtype_info[dtype].size));	
-		}
+		return (lhs->start < rhs->start) ? -1 : 1;
 	}
 
-	return data;
+	return (lhs->end < rhs->end) ? -1 : (lhs->end > rhs->end);
 }
 
-static SDC_STAT loadTensorFromToken(FILE *fhandle, FILE *data_file, 
-	const size_t binary_start, size_t *write_cursor, 
-	const struct cJSON *json_cursor)
+/* Doubles hold integers exactly up to 2^53, offsets and dimensions past
+ * that cannot be trusted */
+static SDC_BOOL isCount(const struct cJSON *item)
 {
-	enum dataType dtype     = DTYPE_UNKNOWN;
-	enum dataType out_dtype = DTYPE_UNKNOWN;
-	struct cJSON *data_obj  = NULL;
-	struct cJSON *dtype_obj = NULL;
-	struct cJSON *arr_obj   = NULL;
-	char *data              = NULL;
-	size_t data_range[2]    = {0};
-	size_t data_len         = 0;
-	size_t bytes_out, write_tmp;
+	return ((cJSON_IsNumber(item) != 0) && (item->valuedouble >= 0.0)
+		&& (item->valuedouble <= SDC_MAX_EXACT)
+		&& (item->valuedouble == (double) (uint64_t) item->valuedouble))
+		? SDC_TRUE : SDC_FALSE;
+}
 
-	if ((fhandle == NULL) || (data_file == NULL) || (json_cursor == NULL))
+/* Checks one tensor's entry, its data must be a whole number of elements
+ * of its dtype matching its shape and lie within the data section */
+static SDC_STAT validateTensor(struct sdc_context *ctx,
+	const struct cJSON *json, const uint64_t data_len,
+	struct tensorRange *range)
+{
+	const struct cJSON *dtype_obj = cJSON_GetObjectItemCaseSensitive(
+		json, "dtype");
+	const struct cJSON *data_obj = cJSON_GetObjectItemCaseSensitive(
+		json, "data_offsets");
+	const struct cJSON *shape = cJSON_GetObjectItemCaseSensitive(
+		json, "shape");
+	const struct cJSON *dim = NULL;
+	enum dataType dtype;
+	uint64_t numel = 1;
+
+	if ((cJSON_IsString(dtype_obj) == 0) || (cJSON_IsArray(shape) == 0)
+	|| (cJSON_GetArraySize(data_obj) != 2)
+	|| (isCount(cJSON_GetArrayItem(data_obj, 0)) == SDC_FALSE)
+	|| (isCount(cJSON_GetArrayItem(data_obj, 1)) == SDC_FALSE))
 	{
-		fprintf(stderr, "%s: Invalid Arguments\n", __func__);
+		errorPrintf(ctx, "%s: %s lacks a dtype, shape or valid "
+			"data_offsets\n", __func__, json->string);
 
 		return SDC_FAILURE;
 	}
 
-	if (((dtype_obj = cJSON_GetObjectItemCaseSensitive(
-		json_cursor, "dtype")) == NULL)
-	|| ((data_obj = cJSON_GetObjectItemCaseSensitive(
-		json_cursor, "data_offsets")) == NULL))
+	range->name  = json->string;
+	range->start = (uint64_t) cJSON_GetArrayItem(data_obj, 0)->valuedouble;
+	range->end   = (uint64_t) cJSON_GetArrayItem(data_obj, 1)->valuedouble;
+
+	if (range->end < range->start)
 	{
-		fprintf(stderr, "%s: Cannot access tensor object members\n",
-			__func__);
+		errorPrintf(ctx, "%s: data_offsets of %s end before they "
+			"start\n", __func__, json->string);
 
 		return SDC_FAILURE;
 	}
 
-	dtype = extractDataType(dtype_obj);
-	data = extractRawData(fhandle, data_obj, binary_start, data_range);
-
-	if (data == NULL)
+	if (range->end > data_len)
 	{
-		fprintf(stderr, "%s: Failure to extract raw tensor data\n",
-			__func__);
+		errorPrintf(ctx, "%s: %s ends at %llu, past the %llu bytes of "
+			"data, the file may be truncated\n", __func__,
+			json->string, (unsigned long long) range->end,
+			(unsigned long long) data_len);
 
 		return SDC_FAILURE;
 	}
 
-	data_len = data_range[1] - data_range[0];
-	data = rawDataArrayEndianness(data, data_len, dtype, SDC_FALSE);
-	
-	if ((dtype != float_out) /* Nothing to be done */
-	&& (dtype != FLOAT_16)   /* Currently no handling for F16 <--> BF16 */
-	&& (dtype != BFLOAT_16)
-	&& (dtype < UNSIGNED_8)) /* ie: F64 and F32 and all signed ints */
+	cJSON_ArrayForEach(dim, shape)
 	{
-		const size_t num_items = data_len / dtype_info[dtype].size;
-		void *tmp = downConvertDTypes(data, num_items, dtype, 
-			&out_dtype);
+		const uint64_t len = (uint64_t) dim->valuedouble;
 
-		if (tmp == NULL)
+		if ((isCount(dim) == SDC_FALSE)
+		|| ((len != 0) && (numel > UINT64_MAX / len)))
 		{
-			fprintf(stderr, "Bad down conversion\n");
-			free(data);
+			errorPrintf(ctx, "%s: Bad shape for %s\n", __func__,
+				json->string);
 
 			return SDC_FAILURE;
 		}
 
-		free(data);
-		data = (char *) tmp;
-		data_len = num_items * dtype_info[out_dtype].size;
-		cJSON_SetValuestring(dtype_obj, dtype_info[out_dtype].name);
-	}
-
-	if ((arr_obj = cJSON_GetArrayItem(data_obj, 0)) == NULL)
-	{
-		fprintf(stderr, "%s: Cannot access tensor data_range array\n",
-			__func__);
-		free(data);
-
-		return  SDC_FAILURE;
+		numel *= len;
 	}
 
-	porteggSysToLeCopy(size_t, *write_cursor, write_tmp);
-	cJSON_SetNumberValue(arr_obj, write_tmp);
-
-	if ((arr_obj = cJSON_GetArrayItem(data_obj, 1)) == NULL)
+	/* Whatever the size of an unknown dtype it is copied across as is */
+	if ((dtype = extractDataType(dtype_obj)) == DTYPE_UNKNOWN)
 	{
-		fprintf(stderr, "%s: Cannot access tensor data_range array\n",
-			__func__);
-		free(data);
+		sdcLog(ctx, SDC_LOG_WARNING, "%s: Unknown dtype %s of %s, it "
+			"will be copied unchecked\n", __func__,
+			dtype_obj->valuestring, json->string);
 
-		return  SDC_FAILURE;
+		return SDC_SUCCESS;
 	}
 
-	porteggSysToLeCopy(size_t, *write_cursor + data_len, write_tmp);
-	cJSON_SetNumberValue(arr_obj, write_tmp);
-	data = rawDataArrayEndianness(data, data_len, dtype, SDC_TRUE);
-
-	if ((bytes_out = fwrite(data, sizeof(char), data_len, data_file)) 
-		!= data_len)
+	if ((numel > UINT64_MAX / dtype_info[dtype].size)
+	|| (numel * dtype_info[dtype].size != range->end - range->start))
 	{
-		fprintf(stderr, "%s: Incomplete write to file (%lu / %lu)\n", 
-			__func__, bytes_out, data_len);
-		free(data);
+		errorPrintf(ctx, "%s: %s holds %llu bytes where its shape "
+			"needs %llu elements of %s\n", __func__, json->string,
+			(unsigned long long) (range->end - range->start),
+			(unsigned long long) numel, dtype_info[dtype].name);
 
 		return SDC_FAILURE;
 	}
 
-	*write_cursor += data_len;
-	free(data);
-
 	return SDC_SUCCESS;
 }
 
-
-SDC_STAT convertSafetensorFile(const char *file_path, const char *out_path)
+/* Tensors are matched up by name alone, a second of the same name would
+ * be taken for the first */
+static SDC_STAT checkNames(struct sdc_context *ctx,
+	const struct tensorRange *ranges, const size_t len)
 {
-	FILE *fhandle             = NULL;
-	FILE *out_file		  = NULL;
-	FILE *data_file           = NULL;
-	struct cJSON *json_tree   = NULL;
-	struct cJSON *cursor      = NULL;
-	char *header              = NULL;
-	uint64_t header_len       = 0;
-	size_t tensors_loaded     = 0;
-	size_t tensors_total      = 0;
-	size_t write_cursor       = 0;
+	const char **names = NULL;
+	struct nameIndex index;
+	size_t i;
 	SDC_STAT ret_code = SDC_SUCCESS;
 
-	if (((fhandle  = fopen(file_path, "rb")) == NULL)
-	|| ((inplace_conv == SDC_FALSE) 
-		&& ((out_file  = fopen(out_path,  "w"))  == NULL))
-	|| ((data_file = tmpfile()) == NULL))
+	memset(&index, 0, sizeof(index));
+
+	if ((names = sdcMalloc(ctx, (len + 1) * sizeof(*names))) == NULL)
 	{
-		fprintf(stderr, "%s: Failure to open file '%s'\n", 
-			__func__, file_path);
-		ret_code = SDC_FAILURE;
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
 
-		goto CLEANUP;
+		return SDC_FAILURE;
 	}
 
-	if (fread(&header_len, sizeof(uint64_t), 1, fhandle) != 1)
+	for (i = 0; i < len; i++)
+	{
+		names[i] = ranges[i].name;
+	}
+
+	if (buildNameIndex(ctx, &index, names, len) == SDC_FAILURE)
 	{
-		fprintf(stderr, "%s: Failure to read from file '%s'\n", 
-			__func__, file_path);
 		ret_code = SDC_FAILURE;
 
 		goto CLEANUP;
 	}
 
-	header_len = PORTEGG_LE_TO_SYS(uint64_t, header_len);
-	verbosePrintf("Reading header of length: %lu\n", header_len);
-
-	if ((header = slurpHeader(fhandle, header_len)) == NULL)
+	for (i = 0; i < len; i++)
 	{
-		fprintf(stderr, "%s: Failure to slurp header\n", __func__);
-		ret_code = SDC_FAILURE;
+		if (findName(&index, names[i]) != i)
+		{
+			errorPrintf(ctx, "%s: There is more than one tensor "
+				"named %s\n", __func__, names[i]);
+			ret_code = SDC_FAILURE;
 
-		goto CLEANUP;
+			goto CLEANUP;
+		}
 	}
 
-	if ((json_tree = cJSON_ParseWithLength(header, header_len)) == NULL)
+CLEANUP:
+	sdcFree(ctx, index.slots);
+	sdcFree(ctx, names);
+
+	return ret_code;
+}
+
+/* Goes over every entry of the header before any data is read, so a
+ * corrupt or truncated file fails straight away. Names must be unique,
+ * ranges are sorted to find overlaps, holes are only warned about as they
+ * do no harm here.
+ * data_len is UINT64_MAX when the input's size is not known */
+static SDC_STAT validateHeader(struct sdc_context *ctx,
+	const struct cJSON *json_tree, const uint64_t data_len)
+{
+	struct tensorRange *ranges = NULL;
+	const struct cJSON *cursor = NULL;
+	uint64_t covered = 0;
+	uint64_t holes   = 0;
+	size_t len = 0;
+	size_t i;
+	SDC_STAT ret_code = SDC_SUCCESS;
+
+	if (cJSON_IsObject(json_tree) == 0)
 	{
-		fprintf(stderr, "%s: Failure to initialize JSON tree\n",
+		errorPrintf(ctx, "%s: Header is not a JSON object\n",
 			__func__);
-		ret_code = SDC_FAILURE;
 
-		goto CLEANUP;
+		return SDC_FAILURE;
 	}
 
 	for (cursor = json_tree->child; cursor != NULL; cursor = cursor->next)
 	{
-		if (strcmp(cursor->string, "__metadata__") == 0)
+		if (strcmp(cursor->string, "__metadata__") != 0)
 		{
-			continue;
+			len++;
 		}
+	}
+
+	if ((len > 0)
+	&& ((ranges = sdcMalloc(ctx, len * sizeof(*ranges))) == NULL))
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
 
-		tensors_total++;
+		return SDC_FAILURE;
+	}
 
-		if (loadTensorFromToken(fhandle, data_file, 
-			header_len + sizeof(uint64_t), &write_cursor, 
-			cursor) == SDC_FAILURE)
+	for (cursor = json_tree->child, i = 0; cursor != NULL;
+		cursor = cursor->next)
+	{
+		if ((strcmp(cursor->string, "__metadata__") != 0)
+		&& (validateTensor(ctx, cursor, data_len, &ranges[i++])
+			== SDC_FAILURE))
 		{
-			fprintf(stderr, "%s: Failure to load %s into tensor\n",
-				__func__, cursor->string);
+			ret_code = SDC_FAILURE;
 
-			continue;
+			goto CLEANUP;
 		}
-
-		tensors_loaded++;
 	}
 
-	if (tensors_loaded != tensors_total)
+	if (checkNames(ctx, ranges, len) == SDC_FAILURE)
 	{
-		fprintf(stderr, 
-			"%s: Incomplete load, (%lu / %lu) tensors loaded\n", 
-			__func__, tensors_loaded, tensors_total);
 		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
 	}
-	else
-	{
-		FILE *tmp_handle = NULL;
-		char *tmp = cJSON_PrintUnformatted(json_tree);
-		uint64_t tmp_len = (uint64_t) strlen(tmp);
-		uint64_t write_len;
-		size_t i;
 
-		porteggSysToLeCopy(uint64_t, tmp_len, write_len);
-		verbosePrintf("%lu of %lu tensors loaded successfully\n",
-			tensors_loaded, tensors_total);
+	/* ranges is NULL without tensors, which qsort may not be given */
+	if (len > 0)
+	{
+		qsort(ranges, len, sizeof(*ranges), compareRanges);
+	}
 
-		if (inplace_conv == SDC_FALSE)
+	for (i = 0; i < len; i++)
+	{
+		if (ranges[i].start == ranges[i].end)
 		{
-			tmp_handle = out_file;
+			continue;
 		}
-		else
+
+		if (ranges[i].start < covered)
 		{
-			if (fclose(fhandle) == EOF) 
-			{
-				/* To prevent another attempt which is UB */
-				fhandle = NULL;
-				fprintf(stderr, "Bad close on input file\n");
+			errorPrintf(ctx, "%s: Data of %s overlaps that of an "
+				"earlier tensor\n", __func__, ranges[i].name);
+			ret_code = SDC_FAILURE;
 
-				goto CLEANUP;
-			}
+			goto CLEANUP;
+		}
 
-			fhandle = NULL;
+		holes  += ranges[i].start - covered;
+		covered = ranges[i].end;
+	}
 
-			if ((tmp_handle = fopen(file_path, "w")) == NULL)
-			{
-				fprintf(stderr, "Failed to open input file "
-					"'%s' for overwriting\n", file_path);
+	if (data_len != UINT64_MAX)
+	{
+		holes += data_len - covered;
+	}
 
-				goto CLEANUP;
-			}
-		}
+	if (holes > 0)
+	{
+		sdcLog(ctx, SDC_LOG_WARNING, "%s: %llu bytes of data belong to "
+			"no tensor and will be dropped\n", __func__,
+			(unsigned long long) holes);
+	}
 
-		/* Write out the length of the header, taking into account
-		 * the potentially new values in the various data_range arrays
-		 * and how that affects the byte-length */
-		if (fwrite(&write_len, sizeof(uint64_t), 1, tmp_handle) != 1)
-		{
-			fprintf(stderr, 
-				"%s: Failure to write out header length\n",
-				__func__);
-			ret_code = SDC_FAILURE;
-		}
+CLEANUP:
+	sdcFree(ctx, ranges);
+
+	return ret_code;
+}
+
+/* Drops the tensors not selected by --include and --exclude from the
+ * header, so neither the plan nor the output header know of them and their
+ * data is never read */
+static SDC_STAT selectTensors(struct sdc_context *ctx,
+	struct cJSON *json_tree)
+{
+	const char **names = NULL;
+	SDC_BOOL *selected = NULL;
+	struct cJSON *cursor = NULL;
+	struct cJSON *next   = NULL;
+	size_t len  = 0;
+	size_t kept = 0;
+	size_t i;
+	SDC_STAT ret_code = SDC_SUCCESS;
+
+	if ((ctx->filter.include.len == 0) && (ctx->filter.exclude.len == 0))
+	{
+		return SDC_SUCCESS;
+	}
 
-		if (fwrite(tmp, sizeof(char), tmp_len, tmp_handle) != tmp_len)
+	for (cursor = json_tree->child; cursor != NULL; cursor = cursor->next)
+	{
+		if (strcmp(cursor->string, "__metadata__") != 0)
 		{
-			fprintf(stderr, 
-				"%s: Failure to write out entire header\n",
-				__func__);
-			ret_code = SDC_FAILURE;
+			len++;
 		}
+	}
 
-		rewind(data_file);
+	if ((len > 0)
+	&& (((names = sdcMalloc(ctx, len * sizeof(*names))) == NULL)
+	|| ((selected = sdcMalloc(ctx, len * sizeof(*selected))) == NULL)))
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
 
-		for (i = 0; i < write_cursor; i++)
+	for (cursor = json_tree->child, i = 0; cursor != NULL;
+		cursor = cursor->next)
+	{
+		if (strcmp(cursor->string, "__metadata__") != 0)
 		{
-			fputc(getc(data_file), tmp_handle);
+			names[i++] = cursor->string;
 		}
+	}
+
+	if (selectNames(ctx, &ctx->filter, names, len, selected)
+		== SDC_FAILURE)
+	{
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
 
-		verbosePrintf("%lu bytes written to output file\n",
-			write_cursor + tmp_len + sizeof(uint64_t));
+	for (cursor = json_tree->child, i = 0; cursor != NULL; cursor = next)
+	{
+		next = cursor->next;
 
-		if (inplace_conv == SDC_TRUE)
+		if (strcmp(cursor->string, "__metadata__") == 0)
 		{
-			fclose(tmp_handle);
+			continue;
 		}
 
-		free(tmp);
+		if (selected[i++] == SDC_TRUE)
+		{
+			kept++;
+		}
+		else
+		{
+			cJSON_Delete(cJSON_DetachItemViaPointer(json_tree,
+				cursor));
+		}
 	}
 
-	dumpTypeInfo();
+	verbosePrintf(ctx, "Selected %lu of %lu tensors\n", kept, len);
+
+	if (kept == 0)
+	{
+		errorPrintf(ctx, "%s: No tensors selected\n", __func__);
+		ret_code = SDC_FAILURE;
+	}
 
 CLEANUP:
-	if (header != NULL)
+	sdcFree(ctx, names);
+	sdcFree(ctx, selected);
+
+	return ret_code;
+}
+
+static void planTensor(struct sdc_context *ctx, struct cJSON *json,
+	struct tensorPlan *plan)
+{
+	const struct cJSON *data_obj = cJSON_GetObjectItemCaseSensitive(
+		json, "data_offsets");
+	const uint64_t start = (uint64_t)
+		cJSON_GetArrayItem(data_obj, 0)->valuedouble;
+	const uint64_t end   = (uint64_t)
+		cJSON_GetArrayItem(data_obj, 1)->valuedouble;
+
+	plan->json      = json;
+	plan->dtype     = extractDataType(cJSON_GetObjectItemCaseSensitive(
+		json, "dtype"));
+	plan->out_dtype = plan->dtype;
+	plan->in_start  = start;
+	plan->in_len    = end - start;
+	plan->out_len   = plan->in_len;
+	plan->automatic = AUTO_OFF;
+	plan->hash      = 0;
+	plan->hash_at   = 0;
+
+	if (plan->dtype == DTYPE_UNKNOWN)
 	{
-		free(header);
+		return;
 	}
 
-	if (fhandle != NULL)
+	plan->out_dtype = selectOutputType(ctx, json, plan->dtype,
+		(size_t) plan->in_len, &plan->automatic);
+	plan->out_len = (plan->in_len / dtype_info[plan->dtype].size)
+		* dtype_info[plan->out_dtype].size;
+}
+
+/* Settles every automatic plan's dtype from a scan of its data, read a
+ * chunk at a time in file order ahead of the header being written */
+static SDC_STAT scanTensors(struct sdc_context *ctx,
+	struct sdcReader *reader, const uint64_t binary_start,
+	struct tensorPlan *plans, const size_t len)
+{
+	char *chunk        = NULL;
+	uint64_t bytes_total = 0;
+	size_t chunk_len   = 0;
+	size_t scanned     = 0;
+	double lap;
+	double span;
+	size_t i;
+	SDC_STAT ret_code = SDC_SUCCESS;
+
+	for (i = 0; i < len; i++)
 	{
-		fclose(fhandle);
+		if (plans[i].automatic != AUTO_OFF)
+		{
+			bytes_total += plans[i].in_len;
+			scanned++;
+			chunk_len = (size_t) SDC_MAX(chunk_len,
+				SDC_MIN(plans[i].in_len, SDC_SCAN_CHUNK));
+		}
 	}
 
-	if (out_file != NULL)
+	if (scanned == 0)
 	{
-		fclose(out_file);
+		return SDC_SUCCESS;
 	}
 
-	if (data_file != NULL)
+	lap  = statsNow(ctx);
+	span = traceStart(ctx);
+
+	if ((chunk_len > 0)
+	&& ((chunk = sdcMalloc(ctx, chunk_len)) == NULL))
 	{
-		fclose(data_file);
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+
+		return SDC_FAILURE;
 	}
 
-	if (json_tree != NULL)
+	progressBegin(ctx, SDC_STAGE_SCAN, bytes_total, scanned);
+
+	for (i = 0; i < len; i++)
 	{
-		cJSON_Delete(json_tree);
+		struct tensorPlan *plan  = &plans[i];
+		const size_t size        = dtype_info[plan->dtype].size;
+		const sdcScanKernel scan = getScanKernel(plan->dtype);
+		struct sdcRange range;
+		uint64_t done = 0;
+
+		if (plan->automatic == AUTO_OFF)
+		{
+			continue;
+		}
+
+		initRange(&range);
+		progressTensor(ctx, plan->json->string, SDC_FALSE);
+
+		while (done < plan->in_len)
+		{
+			const size_t n = (size_t) SDC_MIN(plan->in_len - done,
+				chunk_len);
+
+			if (readerReadAt(ctx, reader, binary_start
+				+ plan->in_start + done, chunk, n)
+				== SDC_FAILURE)
+			{
+				errorPrintf(ctx, "%s: Failure to scan %s\n",
+					__func__, plan->json->string);
+				ret_code = SDC_FAILURE;
+
+				goto CLEANUP;
+			}
+
+			rawDataArrayEndianness(ctx, chunk, n / size,
+				plan->dtype, SDC_FALSE);
+			scan(chunk, n / size, &range);
+			done += n;
+			progressAdvance(ctx, n);
+		}
+
+		ctx->stats.bytes_read += plan->in_len;
+		plan->out_dtype = autoOutputType(ctx, plan->dtype, &range,
+			plan->automatic);
+		plan->out_len   = (plan->in_len / size)
+			* dtype_info[plan->out_dtype].size;
+		progressTensor(ctx, plan->json->string, SDC_TRUE);
+		verbosePrintf(ctx, "%s: scan picked %s, range [%g, %g], "
+			"smallest magnitude %g\n", plan->json->string,
+			dtype_info[plan->out_dtype].name, range.min, range.max,
+			range.abs_min);
 	}
 
+CLEANUP:
+	progressEnd(ctx);
+	sdcFree(ctx, chunk);
+	statsLap(ctx, SDC_PHASE_RANGE_SCAN, NULL, lap);
+	traceSpan(ctx, "range_scan", SDC_FALSE, span);
+
 	return ret_code;
 }
 
+/* Plans every tensor and lays the output data out in the order of the
+ * input data, so both files are gone through front to back whatever order
+ * the header keys are in. The header is updated to match */
+static SDC_STAT planTensors(struct sdc_context *ctx,
+	struct sdcReader *reader, const uint64_t binary_start,
+	struct cJSON *json_tree, struct tensorPlan **plans_out, size_t *count)
+{
+	struct tensorPlan *plans = NULL;
+	struct cJSON *cursor     = NULL;
+	uint64_t out_cursor      = 0;
+	size_t len = 0;
+	size_t i;
+
+	for (cursor = json_tree->child; cursor != NULL; cursor = cursor->next)
+	{
+		if (strcmp(cursor->string, "__metadata__") != 0)
+		{
+			len++;
+		}
+	}
+
+	if ((len > 0)
+	&& ((plans = sdcMalloc(ctx, len * sizeof(*plans))) == NULL))
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	for (cursor = json_tree->child, i = 0; cursor != NULL;
+		cursor = cursor->next)
+	{
+		if (strcmp(cursor->string, "__metadata__") == 0)
+		{
+			continue;
+		}
+
+		plans[i].index = i;
+		planTensor(ctx, cursor, &plans[i++]);
+	}
+
+	if (len > 0)
+	{
+		qsort(plans, len, sizeof(*plans), comparePlans);
+	}
+
+	if (scanTensors(ctx, reader, binary_start, plans, len)
+		== SDC_FAILURE)
+	{
+		sdcFree(ctx, plans);
+
+		return SDC_FAILURE;
+	}
+
+	for (i = 0; i < len; i++)
+	{
+		struct cJSON *data_obj = cJSON_GetObjectItemCaseSensitive(
+			plans[i].json, "data_offsets");
+
+		if (plans[i].out_dtype != plans[i].dtype)
+		{
+			cJSON_SetValuestring(cJSON_GetObjectItemCaseSensitive(
+				plans[i].json, "dtype"),
+				dtype_info[plans[i].out_dtype].name);
+		}
+
+		cJSON_SetNumberValue(cJSON_GetArrayItem(data_obj, 0),
+			(double) out_cursor);
+		out_cursor += plans[i].out_len;
+		cJSON_SetNumberValue(cJSON_GetArrayItem(data_obj, 1),
+			(double) out_cursor);
+	}
+
+	*plans_out = plans;
+	*count     = len;
+
+	return SDC_SUCCESS;
+}
+
+/* The digests of the tensor's chunks are only held while hashing it */
+static SDC_STAT hashTensor(struct sdc_context *ctx, const char *data,
+	const uint64_t len, uint64_t *hash)
+{
+	const size_t chunks = (size_t) ((len + SDC_HASH_CHUNK - 1)
+		/ SDC_HASH_CHUNK);
+	uint64_t *digests;
+
+	if ((digests = sdcMalloc(ctx, (chunks + 1) * sizeof(*digests)))
+		== NULL)
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	getHashKernel()(data, len, digests);
+	*hash = foldDigests(digests, chunks);
+	sdcFree(ctx, digests);
+
+	return SDC_SUCCESS;
+}
+
+static SDC_STAT loadTensor(struct sdc_context *ctx,
+	struct sdcReader *reader, struct sdcWriter *out,
+	const uint64_t binary_start, struct tensorPlan *plan)
+{
+	const char *name = plan->json->string;
+	const enum dataType dtype     = plan->dtype;
+	const enum dataType out_dtype = plan->out_dtype;
+	struct tensorStats *rec = NULL;
+	char *data              = NULL;
+	double lap = statsNow(ctx);
+	const double tensor_span = traceStart(ctx);
+	double span = tensor_span;
+
+	rec = statsAddTensor(ctx, name, dtype);
+	progressTensor(ctx, name, SDC_FALSE);
+	data = extractRawData(ctx, reader, binary_start + plan->in_start,
+		plan->in_len);
+	lap = statsLap(ctx, SDC_PHASE_DATA_READ, rec, lap);
+	traceSpan(ctx, "read", SDC_FALSE, span);
+	span = traceStart(ctx);
+
+	if (data == NULL)
+	{
+		errorPrintf(ctx, "%s: Failure to extract raw tensor data\n",
+			__func__);
+
+		return SDC_FAILURE;
+	}
+
+	if (dtype < DTYPE_UNKNOWN)
+	{
+		data = rawDataArrayEndianness(ctx, data,
+			plan->in_len / dtype_info[dtype].size, dtype,
+			SDC_FALSE);
+		lap = statsLap(ctx, SDC_PHASE_ENDIAN, rec, lap);
+	}
+
+	if (out_dtype != dtype)
+	{
+		const size_t num_items = plan->in_len / dtype_info[dtype].size;
+		void *tmp = downConvertDTypes(ctx, data, num_items, dtype,
+			out_dtype, (rec != NULL) ? &rec->error : NULL);
+
+		if (tmp == NULL)
+		{
+			errorPrintf(ctx, "Bad down conversion\n");
+			sdcFree(ctx, data);
+
+			return SDC_FAILURE;
+		}
+
+		sdcFree(ctx, data);
+		data = (char *) tmp;
+	}
+
+	lap = statsLap(ctx, SDC_PHASE_CONVERT, rec, lap);
+
+	if (out_dtype < DTYPE_UNKNOWN)
+	{
+		data = rawDataArrayEndianness(ctx, data,
+			plan->out_len / dtype_info[out_dtype].size, out_dtype,
+			SDC_TRUE);
+		lap = statsLap(ctx, SDC_PHASE_ENDIAN, rec, lap);
+	}
+
+	traceSpan(ctx, "convert", SDC_FALSE, span);
+	span = traceStart(ctx);
+
+	/* Hashed as written, while still in cache from converting */
+	if (ctx->hash_output == SDC_TRUE)
+	{
+		if (hashTensor(ctx, data, plan->out_len, &plan->hash)
+			== SDC_FAILURE)
+		{
+			sdcFree(ctx, data);
+
+			return SDC_FAILURE;
+		}
+
+		lap = statsLap(ctx, SDC_PHASE_HASH, rec, lap);
+		traceSpan(ctx, "hash", SDC_FALSE, span);
+		span = traceStart(ctx);
+	}
+
+	if (writerWrite(ctx, out, data, (size_t) plan->out_len)
+		== SDC_FAILURE)
+	{
+		sdcFree(ctx, data);
+
+		return SDC_FAILURE;
+	}
+
+	statsLap(ctx, SDC_PHASE_DATA_WRITE, rec, lap);
+	traceSpan(ctx, "write", SDC_FALSE, span);
+	traceSpan(ctx, name, SDC_TRUE, tensor_span);
+	sdcFree(ctx, data);
+
+	if (rec != NULL)
+	{
+		rec->out_type  = out_dtype;
+		rec->bytes_in  = plan->in_len;
+		rec->bytes_out = plan->out_len;
+	}
+
+	return SDC_SUCCESS;
+}
+
+/* Sizes the convert stage from the plan so progress runs on bytes */
+static void beginConvertProgress(struct sdc_context *ctx,
+	const struct tensorPlan *plans, const size_t count)
+{
+	uint64_t bytes_total = 0;
+	size_t i;
+
+	if (ctx->progress.func == NULL)
+	{
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		bytes_total += plans[i].in_len;
+	}
+
+	progressBegin(ctx, SDC_STAGE_CONVERT, bytes_total, count);
+}
+
+/* Replays the allocations of a conversion from its plan. The parsed header
+ * and the plan, allocated by now, are held throughout. The input header
+ * is held alongside the tree while parsing, the output header's buffer
+ * while the output is reserved in full for buffers or a write chunk for
+ * files, and each tensor needs its input alongside any converted copy. Direct
+ * I/O's read buffer is part of the base, allocated for the header. The
+ * statistics and trace are left out as they depend on the options rather
+ * than the file */
+static uint64_t predictPeakMemory(const struct sdc_context *ctx,
+	const struct tensorPlan *plans, const size_t count,
+	const uint64_t in_header_len, const uint64_t out_header_len,
+	const SDC_BOOL to_file)
+{
+	const uint64_t base = ctx->stats.mem_current;
+	const uint64_t header_buf = sizeof(uint64_t) + out_header_len
+		+ SDC_PRINT_SLACK;
+	uint64_t out_held = sizeof(uint64_t) + out_header_len;
+	uint64_t peak;
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		out_held += plans[i].out_len;
+	}
+
+	out_held = (to_file == SDC_FALSE) ? out_held
+		: SDC_WRITE_CHUNK + SDC_DIRECT_ALIGN;
+	/* The tree's arena is already counted in base */
+	peak = SDC_MAX(base + in_header_len, base + header_buf + out_held);
+
+	for (i = 0; i < count; i++)
+	{
+		const uint64_t copy = (plans[i].out_dtype != plans[i].dtype)
+			? plans[i].out_len : 0;
+
+		peak = SDC_MAX(peak, base + out_held + plans[i].in_len + copy);
+	}
+
+	return peak;
+}
+
+/* What cJSON_PrintUnformatted would give a string, escapes included */
+static size_t jsonStringLength(const char *str)
+{
+	size_t len = sizeof("\"\"") - 1;
+
+	if (str == NULL)
+	{
+		return len;
+	}
+
+	for (; *str != '\0'; str++)
+	{
+		switch (*str)
+		{
+			case '\"':
+			case '\\':
+			case '\b':
+			case '\f':
+			case '\n':
+			case '\r':
+			case '\t':
+				len += 2;
+				break;
+			default:
+				len += ((unsigned char) *str < 32) ? 6 : 1;
+				break;
+		}
+	}
+
+	return len;
+}
+
+/* Follows print_number, offsets and shapes are whole numbers short of
+ * 1e15 which %1.15g prints as plain digits, anything else is formatted */
+static size_t jsonNumberLength(const struct cJSON *item)
+{
+	const double d = item->valuedouble;
+	char buf[32];
+	double test;
+	int len;
+
+	if ((isnan(d) != 0) || (isinf(d) != 0))
+	{
+		return sizeof("null") - 1;
+	}
+
+	if ((d > -1e15) && (d < 1e15) && (d == (double) (int64_t) d))
+	{
+		uint64_t mag = (uint64_t) ((d < 0.0) ? -d : d);
+		size_t digits = (d < 0.0) ? 2 : 1;
+
+		for (; mag >= 10; mag /= 10)
+		{
+			digits++;
+		}
+
+		return digits;
+	}
+
+	len = sprintf(buf, "%1.15g", d);
+
+	if ((sscanf(buf, "%lg", &test) != 1)
+	|| (fabs(test - d) > SDC_MAX(fabs(test), fabs(d)) * DBL_EPSILON))
+	{
+		len = sprintf(buf, "%1.17g", d);
+	}
+
+	return (size_t) len;
+}
+
+/* Exact length of the tree printed unformatted, only dtypes and offsets
+ * change from the input header but its spacing and escapes may differ */
+static size_t jsonPrintedLength(const struct cJSON *item)
+{
+	const struct cJSON *child = NULL;
+	size_t len;
+
+	switch (item->type & 0xFF)
+	{
+		case cJSON_NULL:
+		case cJSON_True:
+			return sizeof("null") - 1;
+		case cJSON_False:
+			return sizeof("false") - 1;
+		case cJSON_Number:
+			return jsonNumberLength(item);
+		case cJSON_String:
+			return jsonStringLength(item->valuestring);
+		case cJSON_Raw:
+			return (item->valuestring != NULL)
+				? strlen(item->valuestring) : 0;
+		case cJSON_Array:
+		case cJSON_Object:
+			break;
+		default:
+			return 0;
+	}
+
+	len = sizeof("[]") - 1;
+
+	for (child = item->child; child != NULL; child = child->next)
+	{
+		len += jsonPrintedLength(child) + (child->next != NULL);
+
+		if ((item->type & 0xFF) == cJSON_Object)
+		{
+			len += jsonStringLength(child->string) + 1;
+		}
+	}
+
+	return len;
+}
+
+static SDC_BOOL isHashKey(const char *key)
+{
+	return ((strcmp(key, SDC_HASH_KEY) == 0) || (strncmp(key,
+		SDC_HASH_PREFIX, sizeof(SDC_HASH_PREFIX) - 1) == 0))
+		? SDC_TRUE : SDC_FALSE;
+}
+
+/* Hashes carried over from the input would not match the output, so are
+ * always dropped. With hashing enabled __metadata__ is moved last, ending
+ * in the scheme and a placeholder for every tensor in plan order, which
+ * is where writeHeader looks for them */
+static SDC_STAT stampHashes(struct sdc_context *ctx,
+	struct cJSON *json_tree, const struct tensorPlan *plans,
+	const size_t count)
+{
+	static const char placeholder[SDC_HASH_HEX + 1] = "0000000000000000";
+	struct cJSON *meta = cJSON_GetObjectItemCaseSensitive(json_tree,
+		"__metadata__");
+	struct cJSON *cursor = NULL;
+	struct cJSON *next   = NULL;
+	char scheme[32];
+	char *key = NULL;
+	size_t key_cap = 0;
+	size_t i;
+	SDC_STAT ret_code = SDC_SUCCESS;
+
+	for (cursor = (cJSON_IsObject(meta) != 0) ? meta->child : NULL;
+		cursor != NULL; cursor = next)
+	{
+		next = cursor->next;
+
+		if (isHashKey(cursor->string) == SDC_TRUE)
+		{
+			cJSON_Delete(cJSON_DetachItemViaPointer(meta, cursor));
+		}
+	}
+
+	if (ctx->hash_output == SDC_FALSE)
+	{
+		return SDC_SUCCESS;
+	}
+
+	if ((meta != NULL) && (cJSON_IsObject(meta) == 0))
+	{
+		errorPrintf(ctx, "%s: __metadata__ is not an object, there "
+			"is nowhere to put hashes\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	meta = (meta != NULL) ? cJSON_DetachItemViaPointer(json_tree, meta)
+		: cJSON_CreateObject();
+	snprintf(scheme, sizeof(scheme), "%s%d", SDC_HASH_SCHEME,
+		SDC_HASH_CHUNK);
+
+	if ((meta == NULL)
+	|| (cJSON_AddItemToObject(json_tree, "__metadata__", meta) == 0)
+	|| (cJSON_AddStringToObject(meta, SDC_HASH_KEY, scheme) == NULL))
+	{
+		errorPrintf(ctx, "%s: Failure to add hashes\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		const size_t len = sizeof(SDC_HASH_PREFIX)
+			+ strlen(plans[i].json->string);
+
+		if (len > key_cap)
+		{
+			sdcFree(ctx, key);
+			key_cap = SDC_MAX(len, 2 * key_cap);
+
+			if ((key = sdcMalloc(ctx, key_cap)) == NULL)
+			{
+				ret_code = SDC_FAILURE;
+
+				break;
+			}
+		}
+
+		snprintf(key, key_cap, "%s%s", SDC_HASH_PREFIX,
+			plans[i].json->string);
+
+		if (cJSON_AddStringToObject(meta, key, placeholder) == NULL)
+		{
+			ret_code = SDC_FAILURE;
+
+			break;
+		}
+	}
+
+	if (ret_code == SDC_FAILURE)
+	{
+		errorPrintf(ctx, "%s: Failure to add hashes\n", __func__);
+	}
+
+	sdcFree(ctx, key);
+
+	return ret_code;
+}
+
+/* The header printed unformatted ends in the placeholders stampHashes
+ * left, each found working back from the end by the printed length of
+ * its key and checked to be there */
+static SDC_STAT locateHashes(struct sdc_context *ctx, const char *header,
+	const size_t header_len, struct hashStamp *stamp)
+{
+	static const char placeholder[SDC_HASH_HEX + 1] = "0000000000000000";
+	struct tensorPlan *plans = stamp->plans;
+	size_t end = header_len - 2;  /* before the closing braces */
+	size_t i;
+
+	for (i = stamp->count; i-- > 0;)
+	{
+		const size_t key_len = sizeof(SDC_HASH_PREFIX) - 1
+			+ jsonStringLength(plans[i].json->string);
+
+		if ((end < key_len + SDC_HASH_HEX + 4)
+		|| (header[end - 1] != '"')
+		|| (memcmp(header + end - 1 - SDC_HASH_HEX, placeholder,
+			SDC_HASH_HEX) != 0)
+		|| (header[end - 2 - SDC_HASH_HEX] != '"')
+		|| (header[end - 3 - SDC_HASH_HEX] != ':'))
+		{
+			errorPrintf(ctx, "%s: Hash of %s not where expected\n",
+				__func__, plans[i].json->string);
+
+			return SDC_FAILURE;
+		}
+
+		plans[i].hash_at = end - 1 - SDC_HASH_HEX;
+		end = plans[i].hash_at - 3 - key_len;
+	}
+
+	if (stamp->count == 0)
+	{
+		return SDC_SUCCESS;
+	}
+
+	stamp->tail_len = header_len - plans[0].hash_at;
+	stamp->tail_at  = sizeof(uint64_t) + plans[0].hash_at;
+
+	if ((stamp->tail = sdcMalloc(ctx, stamp->tail_len)) == NULL)
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	memcpy(stamp->tail, header + plans[0].hash_at, stamp->tail_len);
+
+	return SDC_SUCCESS;
+}
+
+/* Fills the hashes in and writes them over their placeholders, all in one
+ * go as they sit together at the end of the header */
+static SDC_STAT patchHashes(struct sdc_context *ctx, struct sdcWriter *out,
+	const struct hashStamp *stamp)
+{
+	char hex[SDC_HASH_HEX + 1];
+	size_t i;
+
+	for (i = 0; i < stamp->count; i++)
+	{
+		snprintf(hex, sizeof(hex), "%016llx",
+			(unsigned long long) stamp->plans[i].hash);
+		memcpy(stamp->tail + (stamp->plans[i].hash_at
+			- stamp->plans[0].hash_at), hex, SDC_HASH_HEX);
+	}
+
+	if ((stamp->count == 0) || (writerFlush(ctx, out) == SDC_FAILURE))
+	{
+		return (stamp->count == 0) ? SDC_SUCCESS : SDC_FAILURE;
+	}
+
+	return writerPatch(ctx, out, stamp->tail_at, stamp->tail,
+		stamp->tail_len);
+}
+
+/* The length prefix and header go out in a single write from a buffer of
+ * their exact size, bar cJSON's slack, with the header printed straight
+ * into it. The output's full size is known by then, so it is reserved
+ * before writing anything */
+static SDC_STAT writeHeader(struct sdc_context *ctx, struct sdcWriter *out,
+	struct cJSON *json_tree, const size_t header_len,
+	const uint64_t data_len, struct hashStamp *stamp)
+{
+	const double lap  = statsNow(ctx);
+	const double span = traceStart(ctx);
+	const size_t total = sizeof(uint64_t) + header_len;
+	uint64_t write_len;
+	char *buf;
+
+	if (header_len > INT_MAX - SDC_PRINT_SLACK)
+	{
+		errorPrintf(ctx, "%s: Header of %lu bytes is too large\n",
+			__func__, header_len);
+
+		return SDC_FAILURE;
+	}
+
+	if ((buf = sdcMalloc(ctx, total + SDC_PRINT_SLACK)) == NULL)
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	porteggSysToLeCopy(uint64_t, header_len, write_len);
+	memcpy(buf, &write_len, sizeof(uint64_t));
+
+	if ((cJSON_PrintPreallocated(json_tree, buf + sizeof(uint64_t),
+		(int) header_len + SDC_PRINT_SLACK, 0) == 0)
+	|| (strlen(buf + sizeof(uint64_t)) != header_len))
+	{
+		errorPrintf(ctx, "%s: Failure to print header\n", __func__);
+		sdcFree(ctx, buf);
+
+		return SDC_FAILURE;
+	}
+
+	if ((stamp != NULL) && (locateHashes(ctx, buf + sizeof(uint64_t),
+		header_len, stamp) == SDC_FAILURE))
+	{
+		sdcFree(ctx, buf);
+
+		return SDC_FAILURE;
+	}
+
+	if ((writerReserve(ctx, out, total + data_len) == SDC_FAILURE)
+	|| (writerWrite(ctx, out, buf, total) == SDC_FAILURE))
+	{
+		errorPrintf(ctx, "%s: Failure to write out header\n",
+			__func__);
+		sdcFree(ctx, buf);
+
+		return SDC_FAILURE;
+	}
+
+	sdcFree(ctx, buf);
+	ctx->stats.bytes_written += total;
+	statsLap(ctx, SDC_PHASE_HEADER_SERIALIZE, NULL, lap);
+	traceSpan(ctx, "header_serialize", SDC_FALSE, span);
+
+	return SDC_SUCCESS;
+}
+
+/* Reads the length and then the header itself, *data_len is what the
+ * file holds past it or UINT64_MAX when its size is not known */
+static SDC_STAT readHeader(struct sdc_context *ctx, struct sdcReader *reader,
+	char **header, uint64_t *header_len, uint64_t *data_len)
+{
+	const uint64_t file_len = readerSize(reader);
+
+	*data_len = UINT64_MAX;
+
+	if (readerReadAt(ctx, reader, 0, header_len, sizeof(uint64_t))
+		== SDC_FAILURE)
+	{
+		errorPrintf(ctx, "%s: Failure to read header length\n",
+			__func__);
+
+		return SDC_FAILURE;
+	}
+
+	*header_len = PORTEGG_LE_TO_SYS(uint64_t, *header_len);
+	verbosePrintf(ctx, "Reading header of length: %lu\n", *header_len);
+
+	if (file_len != UINT64_MAX)
+	{
+		if (*header_len > file_len - sizeof(uint64_t))
+		{
+			errorPrintf(ctx, "%s: Header length %llu runs past the "
+				"end of the file\n", __func__,
+				(unsigned long long) *header_len);
+
+			return SDC_FAILURE;
+		}
+
+		*data_len = file_len - sizeof(uint64_t) - *header_len;
+	}
+
+	if ((*header = slurpHeader(ctx, reader, *header_len)) == NULL)
+	{
+		errorPrintf(ctx, "%s: Failure to slurp header\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	return SDC_SUCCESS;
+}
+
+SDC_STAT loadHeader(struct sdc_context *ctx, struct sdcReader *reader,
+	struct cJSON **json_out, uint64_t *header_len)
+{
+	const char *parse_end = NULL;
+	char *header = NULL;
+	uint64_t data_len;
+
+	if (readHeader(ctx, reader, &header, header_len, &data_len)
+		== SDC_FAILURE)
+	{
+		return SDC_FAILURE;
+	}
+
+	*json_out = cJSON_ParseWithLengthOpts(header, *header_len, &parse_end,
+		0);
+
+	if (*json_out == NULL)
+	{
+		errorPrintf(ctx, "%s: Failure to initialize JSON tree, bad "
+			"JSON at byte %lu of the header\n", __func__,
+			(unsigned long) (parse_end - header));
+		sdcFree(ctx, header);
+
+		return SDC_FAILURE;
+	}
+
+	sdcFree(ctx, header);
+
+	if (validateHeader(ctx, *json_out, data_len) == SDC_FAILURE)
+	{
+		cJSON_Delete(*json_out);
+		*json_out = NULL;
+
+		return SDC_FAILURE;
+	}
+
+	return SDC_SUCCESS;
+}
+
+/* Reads and parses the header then plans the output from it. The tree is
+ * left in the arena, for the caller to release along with the plans */
+static SDC_STAT readPlan(struct sdc_context *ctx, struct sdcReader *reader,
+	struct cJSON **json_out, struct tensorPlan **plans, size_t *count,
+	uint64_t *header_len)
+{
+	struct cJSON *json_tree = NULL;
+	const char *parse_end   = NULL;
+	char *header            = NULL;
+	uint64_t data_len;
+	double lap  = statsNow(ctx);
+	double span = traceStart(ctx);
+
+	if (readHeader(ctx, reader, &header, header_len, &data_len)
+		== SDC_FAILURE)
+	{
+		return SDC_FAILURE;
+	}
+
+	ctx->stats.bytes_read += *header_len + sizeof(uint64_t);
+	lap = statsLap(ctx, SDC_PHASE_HEADER_READ, NULL, lap);
+	traceSpan(ctx, "header_read", SDC_FALSE, span);
+	span = traceStart(ctx);
+
+	if (memoryArenaBegin(ctx, (size_t) *header_len * SDC_TREE_PER_BYTE)
+		== SDC_FAILURE)
+	{
+		sdcFree(ctx, header);
+
+		return SDC_FAILURE;
+	}
+
+	json_tree = cJSON_ParseWithLengthOpts(header, *header_len, &parse_end,
+		0);
+
+	if (json_tree == NULL)
+	{
+		errorPrintf(ctx, "%s: Failure to initialize JSON tree, bad "
+			"JSON at byte %lu of the header\n", __func__,
+			(unsigned long) (parse_end - header));
+		sdcFree(ctx, header);
+		memoryArenaRelease(ctx);
+
+		return SDC_FAILURE;
+	}
+
+	sdcFree(ctx, header);
+
+	if (validateHeader(ctx, json_tree, data_len) == SDC_FAILURE)
+	{
+		memoryArenaRelease(ctx);
+
+		return SDC_FAILURE;
+	}
+
+	statsLap(ctx, SDC_PHASE_JSON_PARSE, NULL, lap);
+	traceSpan(ctx, "json_parse", SDC_FALSE, span);
+
+	if (selectTensors(ctx, json_tree) == SDC_FAILURE)
+	{
+		memoryArenaRelease(ctx);
+
+		return SDC_FAILURE;
+	}
+
+	if (planTensors(ctx, reader, sizeof(uint64_t) + *header_len,
+		json_tree, plans, count) == SDC_FAILURE)
+	{
+		errorPrintf(ctx, "%s: Failure to lay out the output\n",
+			__func__);
+		memoryArenaRelease(ctx);
+
+		return SDC_FAILURE;
+	}
+
+	if (stampHashes(ctx, json_tree, *plans, *count) == SDC_FAILURE)
+	{
+		sdcFree(ctx, *plans);
+		memoryArenaRelease(ctx);
+
+		return SDC_FAILURE;
+	}
+
+	/* The tree is done changing, serializing it needs no arena space */
+	memoryArenaEnd(ctx);
+	*json_out = json_tree;
+
+	return SDC_SUCCESS;
+}
+
+/* Writes the converted file to out, header first and then every tensor
+ * as it is converted, nothing is staged. *out_len gets the bytes written */
+static SDC_STAT convertTensors(struct sdc_context *ctx,
+	struct sdcReader *reader, struct sdcWriter *out, uint64_t *out_len)
+{
+	struct cJSON *json_tree   = NULL;
+	struct tensorPlan *plans  = NULL;
+	struct hashStamp stamp;
+	uint64_t header_len       = 0;
+	size_t out_header_len     = 0;
+	uint64_t data_len         = 0;
+	uint64_t data_total       = 0;
+	size_t tensors_loaded     = 0;
+	size_t tensors_total      = 0;
+	size_t i;
+	const uint64_t written_before = ctx->stats.bytes_written;
+	SDC_STAT ret_code = SDC_SUCCESS;
+
+	memset(&stamp, 0, sizeof(stamp));
+
+	if (readPlan(ctx, reader, &json_tree, &plans, &tensors_total,
+		&header_len) == SDC_FAILURE)
+	{
+		return SDC_FAILURE;
+	}
+
+	stamp.plans = plans;
+	stamp.count = tensors_total;
+
+	/* Hashes go into the header once all is written, which a pipe
+	 * cannot take */
+	if ((ctx->hash_output == SDC_TRUE)
+	&& (writerCanPatch(out) == SDC_FALSE))
+	{
+		errorPrintf(ctx, "%s: Hashing needs the output to be a "
+			"regular file\n", __func__);
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	out_header_len = jsonPrintedLength(json_tree);
+
+	if (ctx->collect_stats == SDC_TRUE)
+	{
+		ctx->stats.mem_predicted_peak = SDC_MAX(
+			ctx->stats.mem_predicted_peak, predictPeakMemory(ctx,
+			plans, tensors_total, header_len, out_header_len,
+			(out->fhandle != NULL) ? SDC_TRUE : SDC_FALSE));
+	}
+
+	for (i = 0; i < tensors_total; i++)
+	{
+		data_total += plans[i].out_len;
+	}
+
+	if (writeHeader(ctx, out, json_tree, out_header_len, data_total,
+		(ctx->hash_output == SDC_TRUE) ? &stamp : NULL) == SDC_FAILURE)
+	{
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	beginConvertProgress(ctx, plans, tensors_total);
+
+	for (i = 0; i < tensors_total; i++)
+	{
+		const char *name = plans[i].json->string;
+
+		memorySetTensor(ctx, name);
+
+		if (loadTensor(ctx, reader, out, header_len + sizeof(uint64_t),
+			&plans[i]) == SDC_FAILURE)
+		{
+			errorPrintf(ctx, "%s: Failure to load %s into tensor\n",
+				__func__, name);
+			memorySetTensor(ctx, NULL);
+
+			break;
+		}
+
+		memorySetTensor(ctx, NULL);
+		progressTensor(ctx, name, SDC_TRUE);
+		data_len += plans[i].out_len;
+		tensors_loaded++;
+	}
+
+	progressEnd(ctx);
+
+	ctx->stats.tensors_total  += tensors_total;
+	ctx->stats.tensors_loaded += tensors_loaded;
+	ctx->stats.bytes_written  += data_len;
+
+	if (tensors_loaded != tensors_total)
+	{
+		errorPrintf(ctx,
+			"%s: Incomplete load, (%lu / %lu) tensors loaded\n",
+			__func__, tensors_loaded, tensors_total);
+		ret_code = SDC_FAILURE;
+	}
+	else if ((ctx->hash_output == SDC_TRUE)
+	&& (patchHashes(ctx, out, &stamp) == SDC_FAILURE))
+	{
+		ret_code = SDC_FAILURE;
+	}
+	else
+	{
+		verbosePrintf(ctx, "%lu of %lu tensors loaded successfully\n",
+			tensors_loaded, tensors_total);
+		*out_len = ctx->stats.bytes_written - written_before;
+	}
+
+CLEANUP:
+	sdcFree(ctx, stamp.tail);
+	sdcFree(ctx, plans);
+	memoryArenaRelease(ctx);
+
+	return ret_code;
+}
+
+/* Bytes a read of the range takes, direct reads cover whole blocks */
+static uint64_t readSpan(const struct sdcReader *reader,
+	const uint64_t offset, const uint64_t len)
+{
+	const uint64_t end = offset + len;
+
+	if ((reader->direct == SDC_FALSE) || (len == 0))
+	{
+		return len;
+	}
+
+	return (((end + SDC_DIRECT_ALIGN - 1) / SDC_DIRECT_ALIGN)
+		- (offset / SDC_DIRECT_ALIGN)) * SDC_DIRECT_ALIGN;
+}
+
+/* Works out everything a conversion would do from its plan, only the
+ * header is read */
+static SDC_STAT estimateTensors(struct sdc_context *ctx,
+	struct sdcReader *reader, const SDC_BOOL to_file,
+	struct sdcEstimate *est)
+{
+	struct cJSON *json_tree  = NULL;
+	struct tensorPlan *plans = NULL;
+	uint64_t header_len      = 0;
+	uint64_t binary_start;
+	size_t count = 0;
+	size_t i;
+
+	memset(est, 0, sizeof(*est));
+
+	if (readPlan(ctx, reader, &json_tree, &plans, &count, &header_len)
+		== SDC_FAILURE)
+	{
+		return SDC_FAILURE;
+	}
+
+	binary_start = sizeof(uint64_t) + header_len;
+	est->tensors      = count;
+	est->header_bytes = jsonPrintedLength(json_tree);
+	est->output_bytes = sizeof(uint64_t) + est->header_bytes;
+	est->bytes_read   = readSpan(reader, 0, sizeof(uint64_t))
+		+ readSpan(reader, sizeof(uint64_t), header_len);
+
+	for (i = 0; i < count; i++)
+	{
+		const struct tensorPlan *plan = &plans[i];
+
+		est->output_bytes += plan->out_len;
+		est->bytes_read   += readSpan(reader,
+			binary_start + plan->in_start, plan->in_len)
+			* ((plan->automatic != AUTO_OFF) ? 2 : 1);
+
+		if (plan->dtype != DTYPE_UNKNOWN)
+		{
+			est->tensors_in[plan->dtype]++;
+			est->bytes_in[plan->dtype] += plan->in_len;
+			est->tensors_out[plan->out_dtype]++;
+			est->bytes_out[plan->out_dtype] += plan->out_len;
+		}
+	}
+
+	/* Direct writes pad out the last block before trimming it off */
+	est->bytes_written = ((to_file == SDC_TRUE)
+		&& (ctx->direct_io == SDC_TRUE))
+		? ((est->output_bytes + SDC_DIRECT_ALIGN - 1)
+			/ SDC_DIRECT_ALIGN) * SDC_DIRECT_ALIGN
+		: est->output_bytes;
+	est->peak_memory = predictPeakMemory(ctx, plans, count, header_len,
+		est->header_bytes, to_file);
+	sdcFree(ctx, plans);
+	memoryArenaRelease(ctx);
+
+	return SDC_SUCCESS;
+}
+
+/* Only regular files are synced, progress gets a stage of its own as
+ * flushing a large file out of the page cache can take a while */
+static SDC_STAT syncOutput(struct sdc_context *ctx,
+	struct sdcOutputFile *out_file, const uint64_t out_len)
+{
+	const double lap  = statsNow(ctx);
+	const double span = traceStart(ctx);
+	SDC_STAT ret_code;
+
+	progressBegin(ctx, SDC_STAGE_SYNC, out_len, 0);
+	ret_code = outputFileCommit(ctx, out_file);
+	progressAdvance(ctx, out_len);
+	progressEnd(ctx);
+	statsLap(ctx, SDC_PHASE_SYNC, NULL, lap);
+	traceSpan(ctx, "sync", SDC_FALSE, span);
+
+	return ret_code;
+}
+
+SDC_STAT sdcConvertFile(struct sdc_context *ctx, const char *file_path,
+	const char *out_path)
+{
+	FILE *fhandle = NULL;
+	uint64_t out_len = 0;
+	struct sdcOutputFile out_file;
+	struct sdcReader reader;
+	struct sdcWriter out_writer;
+	struct sdc_context *prev_ctx;
+	SDC_STAT ret_code = SDC_SUCCESS;
+	double span;
+
+	if ((ctx == NULL) || (file_path == NULL)
+	|| ((ctx->inplace == SDC_FALSE) && (out_path == NULL)))
+	{
+		return SDC_FAILURE;
+	}
+
+	span = traceStart(ctx);
+	prev_ctx = memoryEnter(ctx);
+	memset(&out_file, 0, sizeof(out_file));
+	memset(&reader, 0, sizeof(reader));
+	memset(&out_writer, 0, sizeof(out_writer));
+
+	if ((fhandle = fopen(file_path, "rb")) == NULL)
+	{
+		errorPrintf(ctx, "%s: Failure to open file '%s'\n",
+			__func__, file_path);
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	/* In-place conversion is just output to a sibling of the input,
+	 * which is only replaced once the output is complete */
+	if (outputFileOpen(ctx, &out_file, (ctx->inplace == SDC_TRUE)
+		? file_path : out_path, ctx->inplace) == SDC_FAILURE)
+	{
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	readerFromFile(&reader, fhandle);
+	writerToFile(&out_writer, out_file.fhandle);
+
+	if (ctx->direct_io == SDC_TRUE)
+	{
+		readerDirect(ctx, &reader);
+		writerDirect(ctx, &out_writer);
+	}
+
+	if (convertTensors(ctx, &reader, &out_writer, &out_len)
+		== SDC_FAILURE)
+	{
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	fclose(fhandle);
+	fhandle = NULL;
+
+	if ((ret_code = writerFlush(ctx, &out_writer)) == SDC_FAILURE)
+	{
+		goto CLEANUP;
+	}
+
+	if ((ret_code = syncOutput(ctx, &out_file, out_len)) == SDC_SUCCESS)
+	{
+		dumpTypeInfo(ctx);
+		verbosePrintf(ctx, "%lu bytes written to output file\n",
+			out_len);
+	}
+
+CLEANUP:
+	if (fhandle != NULL)
+	{
+		fclose(fhandle);
+	}
+
+	readerRelease(ctx, &reader);
+	writerFreeMemory(ctx, &out_writer);
+	outputFileDiscard(ctx, &out_file);
+	memoryLeave(prev_ctx);
+	traceSpan(ctx, "sdcConvertFile", SDC_FALSE, span);
+
+	return ret_code;
+}
+
+SDC_STAT sdcConvertBuffer(struct sdc_context *ctx, const void *in,
+	const size_t in_len, void **out, size_t *out_len)
+{
+	uint64_t written = 0;
+	struct sdcReader reader;
+	struct sdcWriter out_writer;
+	struct sdc_context *prev_ctx;
+	SDC_STAT ret_code;
+	double span;
+
+	if ((ctx == NULL) || (in == NULL) || (out == NULL) || (out_len == NULL))
+	{
+		return SDC_FAILURE;
+	}
+
+	span = traceStart(ctx);
+	prev_ctx = memoryEnter(ctx);
+	readerFromMemory(&reader, in, in_len);
+	writerToMemory(&out_writer);
+
+	if ((ret_code = convertTensors(ctx, &reader, &out_writer, &written))
+		== SDC_SUCCESS)
+	{
+		dumpTypeInfo(ctx);
+		*out     = out_writer.buf;
+		*out_len = out_writer.buf_len;
+	}
+	else
+	{
+		writerFreeMemory(ctx, &out_writer);
+	}
+
+	memoryLeave(prev_ctx);
+	traceSpan(ctx, "sdcConvertBuffer", SDC_FALSE, span);
+
+	return ret_code;
+}
+
+SDC_STAT sdcEstimateFile(struct sdc_context *ctx, const char *in_path,
+	struct sdcEstimate *est)
+{
+	FILE *fhandle = NULL;
+	struct sdcReader reader;
+	struct sdc_context *prev_ctx;
+	SDC_STAT ret_code;
+	double span;
+
+	if ((ctx == NULL) || (in_path == NULL) || (est == NULL))
+	{
+		return SDC_FAILURE;
+	}
+
+	if ((fhandle = fopen(in_path, "rb")) == NULL)
+	{
+		errorPrintf(ctx, "%s: Failure to open file '%s'\n",
+			__func__, in_path);
+
+		return SDC_FAILURE;
+	}
+
+	span = traceStart(ctx);
+	prev_ctx = memoryEnter(ctx);
+	readerFromFile(&reader, fhandle);
+
+	if (ctx->direct_io == SDC_TRUE)
+	{
+		readerDirect(ctx, &reader);
+	}
+
+	ret_code = estimateTensors(ctx, &reader, SDC_TRUE, est);
+	readerRelease(ctx, &reader);
+	fclose(fhandle);
+	memoryLeave(prev_ctx);
+	traceSpan(ctx, "sdcEstimateFile", SDC_FALSE, span);
+
+	return ret_code;
+}
+
+SDC_STAT sdcEstimateBuffer(struct sdc_context *ctx, const void *in,
+	const size_t in_len, struct sdcEstimate *est)
+{
+	struct sdcReader reader;
+	struct sdc_context *prev_ctx;
+	SDC_STAT ret_code;
+	double span;
+
+	if ((ctx == NULL) || (in == NULL) || (est == NULL))
+	{
+		return SDC_FAILURE;
+	}
+
+	span = traceStart(ctx);
+	prev_ctx = memoryEnter(ctx);
+	readerFromMemory(&reader, in, in_len);
+	ret_code = estimateTensors(ctx, &reader, SDC_FALSE, est);
+	memoryLeave(prev_ctx);
+	traceSpan(ctx, "sdcEstimateBuffer", SDC_FALSE, span);
+
+	return ret_code;
+}
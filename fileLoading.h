@@ -2,9 +2,22 @@
 #define FILE_LOADING_H
 	
 #include "main.h"
+#include "io.h"
+#include "cJSON.h"
 
-SDC_STAT convertSafetensorFile(const char *filepath, const char *outpath);
-void verbosePrintf(const char *fmt, ...);
+/* sdcConvertFile and sdcConvertBuffer, declared in sdc.h, live here */
 
-#endif /* FILE_LOADING_H */
+/* With hashing enabled __metadata__ gets SDC_HASH_KEY naming the scheme,
+ * SDC_HASH_SCHEME followed by the chunk size, and SDC_HASH_PREFIX followed
+ * by the name of each tensor for its hash, as lowercase hex */
+#define SDC_HASH_KEY "sdc.hash"
+#define SDC_HASH_PREFIX "sdc.hash."
+#define SDC_HASH_SCHEME "xxh64:"
+#define SDC_HASH_HEX 16
+
+/* Reads, parses and validates the header outside of any arena, the tree
+ * is the caller's to cJSON_Delete */
+SDC_STAT loadHeader(struct sdc_context *ctx, struct sdcReader *reader,
+	struct cJSON **json_out, uint64_t *header_len);
 
+#endif /* FILE_LOADING_H */
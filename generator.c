@@ -0,0 +1,593 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "main.h"
+#include "converting.h"
+#include "kernels.h"
+#include "portopt.h"
+
+/* Writes synthetic, but valid, .safetensors files for benchmarking so that
+ * nobody has to go fetch a multi-gigabyte checkpoint first. Tensor sizes,
+ * dtypes and the order of the header keys relative to the data offsets are
+ * all configurable and repeatable for a given seed */
+
+#define SDC_GEN_CHUNK    (1 << 20)
+#define SDC_GEN_MAX_COLS 4096
+
+enum shapeDist
+{
+	DIST_EQUAL = 0, /* every tensor the same size */
+	DIST_RANDOM,    /* uniform between half and one and a half the mean */
+	DIST_SKEWED     /* a few large tensors and many small ones */
+};
+
+enum keyOrder
+{
+	ORDER_OFFSET = 0, /* keys in the order of their data */
+	ORDER_REVERSE,
+	ORDER_RANDOM
+};
+
+struct genTensor
+{
+	char name[64];
+	enum dataType dtype;
+	size_t numel;
+	size_t offset;
+};
+
+struct dtypeMix
+{
+	enum dataType dtypes[NUM_DATA_TYPE];
+	unsigned weights[NUM_DATA_TYPE];
+	unsigned total;
+	size_t len;
+};
+
+static uint64_t rng_state = 0x853C49E6748FEA9BULL;
+
+static uint64_t nextRandom(void)
+{
+	uint64_t x = rng_state;
+
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+
+	return (rng_state = x);
+}
+
+/* Uniform in [0, 1) */
+static double nextUnit(void)
+{
+	return (double) (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static size_t parseSize(const char *str)
+{
+	char *end = NULL;
+	size_t val;
+
+	if (str == NULL)
+	{
+		return 0;
+	}
+
+	val = (size_t) strtoull(str, &end, 10);
+
+	switch (*end)
+	{
+		case 'K': case 'k':
+			return val << 10;
+		case 'M': case 'm':
+			return val << 20;
+		case 'G': case 'g':
+			return val << 30;
+		case '\0':
+			return val;
+		default:
+			return 0;
+	}
+}
+
+/* Parses a mix of the form DTYPE[:WEIGHT][,DTYPE[:WEIGHT]...], eg:
+ * 'F64:3,I64:1' for three F64 tensors to every I64 one */
+static SDC_STAT parseDtypeMix(const char *str, struct dtypeMix *mix)
+{
+	memset(mix, 0, sizeof(*mix));
+
+	while ((str != NULL) && (*str != '\0'))
+	{
+		const size_t len = strcspn(str, ":,");
+		unsigned weight = 1;
+		size_t i;
+
+		for (i = 0; i < dtype_info_len; i++)
+		{
+			if ((strlen(dtype_info[i].name) == len)
+			&& (strncmp(dtype_info[i].name, str, len) == 0))
+			{
+				break;
+			}
+		}
+
+		if ((i == dtype_info_len) || (mix->len == NUM_DATA_TYPE))
+		{
+			fprintf(stderr, "Unknown dtype in mix '%s'\n", str);
+
+			return SDC_FAILURE;
+		}
+
+		str += len;
+
+		if (*str == ':')
+		{
+			char *end = NULL;
+
+			weight = (unsigned) strtoul(str + 1, &end, 10);
+			str = end;
+		}
+
+		if (weight > 0)
+		{
+			mix->dtypes[mix->len]  = dtype_info[i].dtype;
+			mix->weights[mix->len] = weight;
+			mix->total += weight;
+			mix->len++;
+		}
+
+		if (*str == ',')
+		{
+			str++;
+		}
+		else if (*str != '\0')
+		{
+			fprintf(stderr, "Malformed dtype mix near '%s'\n",
+				str);
+
+			return SDC_FAILURE;
+		}
+	}
+
+	return (mix->total > 0) ? SDC_SUCCESS : SDC_FAILURE;
+}
+
+static enum dataType pickDtype(const struct dtypeMix *mix)
+{
+	unsigned pick = (unsigned) (nextRandom() % mix->total);
+	size_t i;
+
+	for (i = 0; i < mix->len - 1; i++)
+	{
+		if (pick < mix->weights[i])
+		{
+			break;
+		}
+
+		pick -= mix->weights[i];
+	}
+
+	return mix->dtypes[i];
+}
+
+/* Relative weight of a tensor's share of the total size */
+static double sizeWeight(const enum shapeDist dist)
+{
+	switch (dist)
+	{
+		case DIST_RANDOM:
+			return 0.5 + nextUnit();
+		case DIST_SKEWED:
+			/* Pareto distributed, capped so one tensor cannot
+			 * swallow the whole file */
+			{
+				const double val = 1.0
+					/ (1.0 - (nextUnit() * 0.999));
+
+				return (val < 1000.0) ? val : 1000.0;
+			}
+		case DIST_EQUAL:
+		default: /* fallthrough */
+			return 1.0;
+	}
+}
+
+/* Matrices where the element count allows it, vectors otherwise */
+static void writeShape(struct cJSON *obj, const size_t numel)
+{
+	struct cJSON *shape = cJSON_AddArrayToObject(obj, "shape");
+	size_t cols = SDC_GEN_MAX_COLS;
+
+	while ((cols > 1) && ((numel % cols) != 0 || (numel / cols) < 2))
+	{
+		cols /= 2;
+	}
+
+	if (cols > 1)
+	{
+		cJSON_AddItemToArray(shape,
+			cJSON_CreateNumber((double) (numel / cols)));
+	}
+
+	cJSON_AddItemToArray(shape, cJSON_CreateNumber((double) ((cols > 1)
+		? cols : numel)));
+}
+
+static void fillData(char *buf, const enum dataType dtype, const size_t len)
+{
+	const size_t size = dtype_info[dtype].size;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		const uint64_t r = nextRandom();
+		const float val = ((float) (r & 0xFFFFFF) / 8388608.0f)
+			- 1.0f;
+		char *dst = buf + (i * size);
+
+		switch (dtype)
+		{
+			case FLOAT_64:
+				*(double *) dst = (double) val;
+				break;
+			case FLOAT_32:
+				*(float *) dst = val;
+				break;
+			case FLOAT_16:
+				*(uint16_t *) dst = fltToHlf(val);
+				break;
+			case BFLOAT_16:
+				*(uint16_t *) dst = fltToBft(val);
+				break;
+			case SIGNED_64:
+				*(int64_t *) dst = (int64_t) (r >> 40)
+					- (1 << 23);
+				break;
+			case SIGNED_32:
+				*(int32_t *) dst = (int32_t) (r >> 40)
+					- (1 << 23);
+				break;
+			case SIGNED_16:
+				*(int16_t *) dst = (int16_t) (r >> 48);
+				break;
+			case SIGNED_8:
+				*(int8_t *) dst = (int8_t) (r >> 56);
+				break;
+			case BOOLEAN:
+				*(uint8_t *) dst = (uint8_t) (r >> 63);
+				break;
+			case UNSIGNED_8:
+			default: /* fallthrough */
+				*(uint8_t *) dst = (uint8_t) (r >> 56);
+				break;
+		}
+
+		PORTEGG_SYS_TO_LE_RAW(size, dst);
+	}
+}
+
+static char* buildHeader(const struct genTensor *tensors, const size_t len,
+	const enum keyOrder order, const SDC_BOOL metadata, size_t *header_len)
+{
+	struct cJSON *root = cJSON_CreateObject();
+	size_t *perm       = malloc(sizeof(size_t) * len);
+	char *header       = NULL;
+	char *padded       = NULL;
+	size_t i, raw_len;
+
+	if ((root == NULL) || (perm == NULL))
+	{
+		goto CLEANUP;
+	}
+
+	if (metadata == SDC_TRUE)
+	{
+		struct cJSON *meta = cJSON_AddObjectToObject(root,
+			"__metadata__");
+
+		cJSON_AddStringToObject(meta, "format", "pt");
+		cJSON_AddStringToObject(meta, "generator", "sdc_gen");
+	}
+
+	for (i = 0; i < len; i++)
+	{
+		perm[i] = (order == ORDER_REVERSE) ? len - 1 - i : i;
+	}
+
+	/* Fisher-Yates */
+	for (i = len; (order == ORDER_RANDOM) && (i > 1); i--)
+	{
+		const size_t j = (size_t) (nextRandom() % i);
+		const size_t tmp = perm[i - 1];
+
+		perm[i - 1] = perm[j];
+		perm[j] = tmp;
+	}
+
+	for (i = 0; i < len; i++)
+	{
+		const struct genTensor *cur = &tensors[perm[i]];
+		const size_t end = cur->offset
+			+ (cur->numel * dtype_info[cur->dtype].size);
+		struct cJSON *obj = cJSON_AddObjectToObject(root, cur->name);
+		struct cJSON *offsets;
+
+		cJSON_AddStringToObject(obj, "dtype",
+			dtype_info[cur->dtype].name);
+		writeShape(obj, cur->numel);
+		offsets = cJSON_AddArrayToObject(obj, "data_offsets");
+		cJSON_AddItemToArray(offsets,
+			cJSON_CreateNumber((double) cur->offset));
+		cJSON_AddItemToArray(offsets,
+			cJSON_CreateNumber((double) end));
+	}
+
+	if ((header = cJSON_PrintUnformatted(root)) == NULL)
+	{
+		goto CLEANUP;
+	}
+
+	/* The spec allows trailing spaces, used here to keep the data
+	 * section 8 byte aligned as the reference implementation does */
+	raw_len = strlen(header);
+	*header_len = (raw_len + 7) & ~(size_t) 7;
+
+	if ((padded = malloc(*header_len)) != NULL)
+	{
+		memcpy(padded, header, raw_len);
+		memset(padded + raw_len, ' ', *header_len - raw_len);
+	}
+
+CLEANUP:
+	if (header != NULL)
+	{
+		cJSON_free(header);
+	}
+
+	cJSON_Delete(root);
+	free(perm);
+
+	return padded;
+}
+
+static const char * const name_fmts[] =
+{
+	"model.layers.%lu.self_attn.q_proj.weight",
+	"model.layers.%lu.self_attn.k_proj.weight",
+	"model.layers.%lu.self_attn.v_proj.weight",
+	"model.layers.%lu.self_attn.o_proj.weight",
+	"model.layers.%lu.mlp.gate_proj.weight",
+	"model.layers.%lu.mlp.up_proj.weight",
+	"model.layers.%lu.mlp.down_proj.weight",
+	"model.layers.%lu.input_layernorm.weight"
+};
+
+static const size_t name_fmts_len = sizeof(name_fmts) / sizeof(name_fmts[0]);
+
+static void printHelp(void)
+{
+	fputs("sdc_gen, synthetic safetensors generator\n\n"
+		"-o, --output <FILE PATH>       : File to write, required\n"
+		"-n, --tensors <COUNT>          : Tensor count, default 64\n"
+		"-s, --size <BYTES>             : Approximate data size,"
+			" default 64M\n"
+		"-d, --dtypes <MIX>             : Dtype weights, default"
+			" F64, eg: F64:3,I64:1\n"
+		"-D, --distribution <DIST>      : equal, random or skewed"
+			" tensor sizes\n"
+		"-k, --key-order <ORDER>        : offset, reverse or random"
+			" header key order\n"
+		"-m, --metadata                 : Adds a __metadata__ entry\n"
+		"-S, --seed <NUMBER>            : Random seed\n"
+		"-h, --help                     : Prints this help message\n",
+		stdout);
+}
+
+int main(int argc, char **argv)
+{
+	const struct portoptVerboseOpt opts[] =
+	{
+		{'o', "output",       PORTOPT_TRUE},
+		{'n', "tensors",      PORTOPT_TRUE},
+		{'s', "size",         PORTOPT_TRUE},
+		{'d', "dtypes",       PORTOPT_TRUE},
+		{'D', "distribution", PORTOPT_TRUE},
+		{'k', "key-order",    PORTOPT_TRUE},
+		{'m', "metadata",     PORTOPT_FALSE},
+		{'S', "seed",         PORTOPT_TRUE},
+		{'h', "help",         PORTOPT_FALSE}
+	};
+	const size_t num_opts = sizeof(opts) / sizeof(opts[0]);
+	const size_t lenc = (size_t) argc;
+	struct genTensor *tensors = NULL;
+	double *weights           = NULL;
+	char *header              = NULL;
+	char *chunk               = NULL;
+	FILE *out_file            = NULL;
+	const char *out_path      = NULL;
+	const char *mix_str       = "F64";
+	const char *arg;
+	struct dtypeMix mix;
+	enum shapeDist dist   = DIST_EQUAL;
+	enum keyOrder order   = ORDER_OFFSET;
+	SDC_BOOL metadata     = SDC_FALSE;
+	size_t num_tensors    = 64;
+	size_t total_size     = (size_t) 64 << 20;
+	size_t header_len     = 0;
+	size_t data_len       = 0;
+	double weight_sum     = 0.0;
+	uint64_t len_le;
+	size_t ind = 0;
+	size_t i;
+	SDC_STAT ret_code = SDC_SUCCESS;
+	int flag;
+
+	while ((flag = portoptVerbose(lenc, argv, opts, num_opts, &ind)) != -1)
+	{
+		switch (flag)
+		{
+			case 'o':
+				out_path = portoptGetArg(lenc, argv, &ind);
+				break;
+			case 'n':
+				num_tensors = parseSize(portoptGetArg(lenc,
+					argv, &ind));
+				break;
+			case 's':
+				total_size = parseSize(portoptGetArg(lenc,
+					argv, &ind));
+				break;
+			case 'd':
+				mix_str = portoptGetArg(lenc, argv, &ind);
+				break;
+			case 'D':
+				arg = portoptGetArg(lenc, argv, &ind);
+				dist = ((arg != NULL) && (strcmp(arg, "skewed")
+					== 0)) ? DIST_SKEWED : ((arg != NULL)
+					&& (strcmp(arg, "random") == 0))
+					? DIST_RANDOM : DIST_EQUAL;
+				break;
+			case 'k':
+				arg = portoptGetArg(lenc, argv, &ind);
+				order = ((arg != NULL) && (strcmp(arg, "random")
+					== 0)) ? ORDER_RANDOM : ((arg != NULL)
+					&& (strcmp(arg, "reverse") == 0))
+					? ORDER_REVERSE : ORDER_OFFSET;
+				break;
+			case 'm':
+				metadata = SDC_TRUE;
+				break;
+			case 'S':
+				arg = portoptGetArg(lenc, argv, &ind);
+				rng_state ^= (arg != NULL)
+					? strtoull(arg, NULL, 10) : 0;
+				rng_state += (rng_state == 0) ? 1 : 0;
+				break;
+			case 'h':
+				printHelp();
+				return SDC_SUCCESS;
+			case '?':
+			default: /* fallthrough */
+				fputs("Unknown switch\n", stderr);
+				break;
+		}
+	}
+
+	if ((out_path == NULL) || (num_tensors == 0)
+	|| (parseDtypeMix(mix_str, &mix) == SDC_FAILURE))
+	{
+		fputs("An output path, a tensor count and a valid dtype mix"
+			" are required, see --help\n", stderr);
+
+		return SDC_FAILURE;
+	}
+
+	if (((tensors = calloc(num_tensors, sizeof(*tensors))) == NULL)
+	|| ((weights = malloc(num_tensors * sizeof(*weights))) == NULL)
+	|| ((chunk = malloc(SDC_GEN_CHUNK)) == NULL))
+	{
+		fputs("Failure to allocate generator buffers\n", stderr);
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	for (i = 0; i < num_tensors; i++)
+	{
+		weights[i] = sizeWeight(dist);
+		weight_sum += weights[i];
+	}
+
+	for (i = 0; i < num_tensors; i++)
+	{
+		struct genTensor *cur = &tensors[i];
+		const double share = ((double) total_size * weights[i])
+			/ weight_sum;
+
+		cur->dtype  = pickDtype(&mix);
+		cur->numel  = (size_t) (share
+			/ (double) dtype_info[cur->dtype].size);
+		/* Rounded so most tensors come out as matrices */
+		cur->numel -= (cur->numel >= 128) ? cur->numel % 64 : 0;
+		cur->numel += (cur->numel == 0) ? 1 : 0;
+		cur->offset = data_len;
+		data_len   += cur->numel * dtype_info[cur->dtype].size;
+		snprintf(cur->name, sizeof(cur->name),
+			name_fmts[i % name_fmts_len],
+			(unsigned long) (i / name_fmts_len));
+	}
+
+	if ((header = buildHeader(tensors, num_tensors, order, metadata,
+		&header_len)) == NULL)
+	{
+		fputs("Failure to build header\n", stderr);
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	if ((out_file = fopen(out_path, "wb")) == NULL)
+	{
+		fprintf(stderr, "Failure to open file '%s'\n", out_path);
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	porteggSysToLeCopy(uint64_t, (uint64_t) header_len, len_le);
+
+	if ((fwrite(&len_le, sizeof(len_le), 1, out_file) != 1)
+	|| (fwrite(header, sizeof(char), header_len, out_file) != header_len))
+	{
+		fputs("Failure to write header\n", stderr);
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	for (i = 0; (i < num_tensors) && (ret_code == SDC_SUCCESS); i++)
+	{
+		const size_t size = dtype_info[tensors[i].dtype].size;
+		size_t left = tensors[i].numel;
+
+		while (left > 0)
+		{
+			const size_t batch = (left < SDC_GEN_CHUNK / size)
+				? left : SDC_GEN_CHUNK / size;
+
+			fillData(chunk, tensors[i].dtype, batch);
+
+			if (fwrite(chunk, size, batch, out_file) != batch)
+			{
+				fputs("Failure to write tensor data\n", stderr);
+				ret_code = SDC_FAILURE;
+
+				break;
+			}
+
+			left -= batch;
+		}
+	}
+
+	if (ret_code == SDC_SUCCESS)
+	{
+		printf("%s: %lu tensors, %lu header bytes, %lu data bytes\n",
+			out_path, (unsigned long) num_tensors,
+			(unsigned long) header_len, (unsigned long) data_len);
+	}
+
+CLEANUP:
+	if ((out_file != NULL) && (fclose(out_file) == EOF))
+	{
+		fputs("Bad close on output file\n", stderr);
+		ret_code = SDC_FAILURE;
+	}
+
+	free(tensors);
+	free(weights);
+	free(header);
+	free(chunk);
+
+	return ret_code;
+}
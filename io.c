@@ -0,0 +1,1101 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#else
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#else
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+#include "io.h"
+#include "context.h"
+
+/* Reads are split up this finely only while progress is being reported or
+ * the page cache spared */
+#define SDC_READ_CHUNK (16 << 20)
+
+/* How far ahead of a cache friendly read the kernel is asked to fetch */
+#define SDC_READ_AHEAD (64 << 20)
+
+/* Chunks allowed to be in flight to disk before waiting on the oldest */
+#define SDC_WRITE_BEHIND 4
+
+#define SDC_ALIGN_DOWN(x) ((x) & ~((uint64_t) SDC_DIRECT_ALIGN - 1))
+#define SDC_ALIGN_UP(x) SDC_ALIGN_DOWN((x) + SDC_DIRECT_ALIGN - 1)
+
+/* The block of size bytes it returns sits aligned within *base */
+static char* alignedAlloc(struct sdc_context *ctx, const size_t size,
+	void **base)
+{
+	uintptr_t addr;
+
+	if ((*base = sdcMalloc(ctx, size + SDC_DIRECT_ALIGN)) == NULL)
+	{
+		return NULL;
+	}
+
+	addr = (uintptr_t) *base;
+
+	return (char *) *base + (SDC_ALIGN_UP(addr) - addr);
+}
+
+#ifdef O_DIRECT
+/* Only for regular files, on a pipe O_DIRECT means packet mode instead */
+static SDC_BOOL setDirect(FILE *fhandle, const SDC_BOOL direct)
+{
+	const int fd = fileno(fhandle);
+	struct stat st;
+	int flags;
+
+	if ((fstat(fd, &st) != 0) || ((st.st_mode & S_IFMT) != S_IFREG)
+	|| ((flags = fcntl(fd, F_GETFL)) == -1))
+	{
+		return SDC_FALSE;
+	}
+
+	flags = (direct == SDC_TRUE) ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+
+	return (fcntl(fd, F_SETFL, flags) == 0) ? SDC_TRUE : SDC_FALSE;
+}
+#endif
+
+void readerDirect(struct sdc_context *ctx, struct sdcReader *reader)
+{
+#ifdef O_DIRECT
+	if ((reader->fhandle != NULL)
+	&& (setDirect(reader->fhandle, SDC_TRUE) == SDC_TRUE))
+	{
+		reader->direct = SDC_TRUE;
+
+		return;
+	}
+#endif
+
+	verbosePrintf(ctx, "Direct I/O unavailable for input, buffering\n");
+}
+
+void writerDirect(struct sdc_context *ctx, struct sdcWriter *writer)
+{
+#ifdef O_DIRECT
+	if ((writer->fhandle != NULL)
+	&& (setDirect(writer->fhandle, SDC_TRUE) == SDC_TRUE))
+	{
+		writer->direct = SDC_TRUE;
+
+		return;
+	}
+#endif
+
+	verbosePrintf(ctx, "Direct I/O unavailable for output, buffering\n");
+}
+
+void readerFromFile(struct sdcReader *reader, FILE *fhandle)
+{
+	memset(reader, 0, sizeof(*reader));
+	reader->fhandle = fhandle;
+}
+
+uint64_t readerSize(const struct sdcReader *reader)
+{
+	struct stat st;
+
+	if (reader->fhandle == NULL)
+	{
+		return reader->buf_len;
+	}
+
+	if ((fstat(fileno(reader->fhandle), &st) != 0)
+	|| ((st.st_mode & S_IFMT) != S_IFREG))
+	{
+		return UINT64_MAX;
+	}
+
+	return (uint64_t) st.st_size;
+}
+
+void readerRelease(struct sdc_context *ctx, struct sdcReader *reader)
+{
+	sdcFree(ctx, reader->bounce_base);
+	reader->bounce      = NULL;
+	reader->bounce_base = NULL;
+}
+
+void readerFromMemory(struct sdcReader *reader, const void *buf,
+	const uint64_t len)
+{
+	memset(reader, 0, sizeof(*reader));
+	reader->buf     = buf;
+	reader->buf_len = len;
+}
+
+/* Reads go front to back, so what was just read will not be wanted again
+ * and what follows will be. The advice is only ever a hint, failure of it
+ * changes nothing */
+static void adviseRead(struct sdc_context *ctx, struct sdcReader *reader,
+	const uint64_t offset, const size_t len)
+{
+#ifdef POSIX_FADV_DONTNEED
+	const int fd = fileno(reader->fhandle);
+
+	if (ctx->cache_friendly == SDC_FALSE)
+	{
+		return;
+	}
+
+	if (reader->advised == SDC_FALSE)
+	{
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+		reader->advised = SDC_TRUE;
+	}
+
+	posix_fadvise(fd, (off_t) offset, (off_t) len, POSIX_FADV_DONTNEED);
+	posix_fadvise(fd, (off_t) (offset + len), SDC_READ_AHEAD,
+		POSIX_FADV_WILLNEED);
+#else
+	(void) ctx;
+	(void) reader;
+	(void) offset;
+	(void) len;
+#endif
+}
+
+#ifdef O_DIRECT
+/* Reads the aligned span around the range a chunk at a time, copying out
+ * the wanted part. EINVAL means the file system wants none of it, the
+ * reader is then put back to buffered and the caller carries on from the
+ * *done bytes already read and reported */
+static SDC_STAT readDirect(struct sdc_context *ctx, struct sdcReader *reader,
+	const uint64_t offset, void *dst, const size_t len, size_t *done)
+{
+	const int fd = fileno(reader->fhandle);
+	const uint64_t end = offset + len;
+	uint64_t pos = offset;
+
+	*done = 0;
+
+	if ((reader->bounce == NULL) && ((reader->bounce = alignedAlloc(ctx,
+		SDC_READ_CHUNK, &reader->bounce_base)) == NULL))
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	while (pos < end)
+	{
+		const uint64_t span_off = SDC_ALIGN_DOWN(pos);
+		const uint64_t span_len = SDC_ALIGN_UP(end) - span_off;
+		const size_t want = (span_len < SDC_READ_CHUNK)
+			? (size_t) span_len : SDC_READ_CHUNK;
+		const ssize_t got = pread(fd, reader->bounce, want,
+			(off_t) span_off);
+		size_t take;
+
+		if ((got < 0) && (errno == EINTR))
+		{
+			continue;
+		}
+
+		if ((got < 0) && (errno == EINVAL))
+		{
+			verbosePrintf(ctx, "Input refused direct I/O, "
+				"buffering\n");
+			setDirect(reader->fhandle, SDC_FALSE);
+			reader->direct = SDC_FALSE;
+
+			return SDC_FAILURE;
+		}
+
+		if ((got < 0) || (span_off + (uint64_t) got <= pos))
+		{
+			errorPrintf(ctx, "%s: Bad read from file\n", __func__);
+
+			return SDC_FAILURE;
+		}
+
+		take = (size_t) (((span_off + (uint64_t) got < end)
+			? span_off + (uint64_t) got : end) - pos);
+		memcpy((char *) dst + (pos - offset),
+			reader->bounce + (pos - span_off), take);
+		adviseRead(ctx, reader, pos, take);
+		progressAdvance(ctx, take);
+		pos += take;
+		*done = (size_t) (pos - offset);
+	}
+
+	return SDC_SUCCESS;
+}
+#endif
+
+SDC_STAT readerReadAt(struct sdc_context *ctx, struct sdcReader *reader,
+	const uint64_t offset, void *dst, const size_t len)
+{
+	const size_t chunk = ((ctx->progress.active == SDC_TRUE)
+		|| (ctx->cache_friendly == SDC_TRUE)) ? SDC_READ_CHUNK : len;
+	size_t done;
+
+	if (reader->fhandle == NULL)
+	{
+		if ((offset > reader->buf_len)
+		|| (len > reader->buf_len - offset))
+		{
+			errorPrintf(ctx, "%s: Read past end of buffer\n",
+				__func__);
+
+			return SDC_FAILURE;
+		}
+
+		memcpy(dst, reader->buf + offset, len);
+		progressAdvance(ctx, len);
+
+		return SDC_SUCCESS;
+	}
+
+#ifdef O_DIRECT
+	if (reader->direct == SDC_TRUE)
+	{
+		size_t direct_done;
+		const SDC_STAT ret_code = readDirect(ctx, reader, offset, dst,
+			len, &direct_done);
+
+		/* Otherwise it fell back and the rest is read buffered */
+		if (reader->direct == SDC_TRUE)
+		{
+			return ret_code;
+		}
+
+		return readerReadAt(ctx, reader, offset + direct_done,
+			(char *) dst + direct_done, len - direct_done);
+	}
+#endif
+
+	if ((offset > LONG_MAX) && (ctx->large_seek_warned == SDC_FALSE))
+	{
+		sdcLog(ctx, SDC_LOG_WARNING, "%s: Attempting to seek to a "
+			"range outside of the historical capacity of fseek, "
+			"if output doesn't work this is the place to check "
+			"first\n", __func__);
+
+		ctx->large_seek_warned = SDC_TRUE;
+	}
+
+	if (fseek(reader->fhandle, (long) offset, SEEK_SET) != 0)
+	{
+		errorPrintf(ctx, "%s: Bad file seek\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	for (done = 0; done < len; done += chunk)
+	{
+		const size_t want = ((len - done) < chunk) ? len - done : chunk;
+
+		if (fread((char *) dst + done, sizeof(char), want,
+			reader->fhandle) != want)
+		{
+			errorPrintf(ctx, "%s: Bad read from file\n", __func__);
+
+			return SDC_FAILURE;
+		}
+
+		adviseRead(ctx, reader, offset + done, want);
+		progressAdvance(ctx, want);
+	}
+
+	return SDC_SUCCESS;
+}
+
+void writerToFile(struct sdcWriter *writer, FILE *fhandle)
+{
+	memset(writer, 0, sizeof(*writer));
+	writer->fhandle = fhandle;
+#ifdef __linux__
+	writer->write_behind = SDC_TRUE;
+#endif
+
+	/* The chunking below replaces stdio's buffering */
+	setvbuf(fhandle, NULL, _IONBF, 0);
+}
+
+void writerToMemory(struct sdcWriter *writer)
+{
+	memset(writer, 0, sizeof(*writer));
+}
+
+/* Starts writeback of what was just written and waits for the whole
+ * chunks from synced_to up to the window behind it, so dirty pages stay
+ * bounded instead of all landing on the final sync. However large the
+ * write, what it just issued is never waited on. The chunks waited on are
+ * clean afterwards and cache friendly output drops them. Pipes and the
+ * like refuse it all, after which it is dropped */
+static void writeBehind(struct sdc_context *ctx, struct sdcWriter *writer,
+	const uint64_t len)
+{
+#ifdef __linux__
+	const int fd = fileno(writer->fhandle);
+	const uint64_t window = (uint64_t) SDC_WRITE_CHUNK * SDC_WRITE_BEHIND;
+	uint64_t until;
+
+	if (writer->write_behind == SDC_FALSE)
+	{
+		return;
+	}
+
+	if (sync_file_range(fd, (off_t) (writer->file_pos - len), (off_t) len,
+		SYNC_FILE_RANGE_WRITE) != 0)
+	{
+		writer->write_behind = SDC_FALSE;
+
+		return;
+	}
+
+	until = (writer->file_pos > window) ? writer->file_pos - window : 0;
+	until -= until % SDC_WRITE_CHUNK;
+
+	if (until <= writer->synced_to)
+	{
+		return;
+	}
+
+	if ((sync_file_range(fd, (off_t) writer->synced_to,
+		(off_t) (until - writer->synced_to),
+		SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE
+		| SYNC_FILE_RANGE_WAIT_AFTER) == 0)
+	&& (ctx->cache_friendly == SDC_TRUE))
+	{
+		posix_fadvise(fd, (off_t) writer->synced_to,
+			(off_t) (until - writer->synced_to),
+			POSIX_FADV_DONTNEED);
+	}
+
+	writer->synced_to = until;
+#else
+	(void) ctx;
+	(void) writer;
+	(void) len;
+#endif
+}
+
+#ifdef O_DIRECT
+/* Straight to the descriptor as stdio would not say why a write failed.
+ * Should the file system refuse O_DIRECT, EINVAL, the rest goes buffered */
+static size_t writeDirect(struct sdc_context *ctx, struct sdcWriter *writer,
+	const char *src, const size_t len)
+{
+	const int fd = fileno(writer->fhandle);
+	size_t done = 0;
+
+	while (done < len)
+	{
+		const ssize_t put = write(fd, src + done, len - done);
+
+		if ((put < 0) && (errno == EINVAL)
+		&& (writer->direct == SDC_TRUE))
+		{
+			verbosePrintf(ctx, "Output refused direct I/O, "
+				"buffering\n");
+			setDirect(writer->fhandle, SDC_FALSE);
+			writer->direct = SDC_FALSE;
+		}
+		else if (put > 0)
+		{
+			done += (size_t) put;
+		}
+		else if (errno != EINTR)
+		{
+			break;
+		}
+	}
+
+	return done;
+}
+#endif
+
+static SDC_STAT writeOut(struct sdc_context *ctx, struct sdcWriter *writer,
+	const void *src, const size_t len)
+{
+	size_t bytes_out;
+
+#ifdef O_DIRECT
+	if (writer->direct == SDC_TRUE)
+	{
+		bytes_out = writeDirect(ctx, writer, src, len);
+	}
+	else
+#endif
+	{
+		bytes_out = fwrite(src, sizeof(char), len, writer->fhandle);
+	}
+
+	if (bytes_out != len)
+	{
+		errorPrintf(ctx, "%s: Incomplete write to file (%lu / %lu)\n",
+			__func__, bytes_out, len);
+
+		return SDC_FAILURE;
+	}
+
+	writer->file_pos += len;
+	writeBehind(ctx, writer, len);
+
+	return SDC_SUCCESS;
+}
+
+static SDC_STAT writeToMemory(struct sdc_context *ctx,
+	struct sdcWriter *writer, const void *src, const size_t len)
+{
+	if (len > writer->buf_cap - writer->buf_len)
+	{
+		size_t new_cap = (writer->buf_cap == 0)
+			? SDC_COPY_CHUNK : writer->buf_cap;
+		char *tmp;
+
+		while (new_cap - writer->buf_len < len)
+		{
+			new_cap *= 2;
+		}
+
+		if ((tmp = sdcRealloc(ctx, writer->buf, new_cap)) == NULL)
+		{
+			errorPrintf(ctx, "%s: Realloc failure\n", __func__);
+
+			return SDC_FAILURE;
+		}
+
+		writer->buf     = tmp;
+		writer->buf_cap = new_cap;
+	}
+
+	memcpy(writer->buf + writer->buf_len, src, len);
+	writer->buf_len += len;
+
+	return SDC_SUCCESS;
+}
+
+/* File writers use buf to gather whole chunks, anything that starts on a
+ * chunk boundary goes straight out of src without being copied */
+SDC_STAT writerWrite(struct sdc_context *ctx, struct sdcWriter *writer,
+	const void *src, const size_t len)
+{
+	const char *cursor = src;
+	size_t left = len;
+
+	if (writer->fhandle == NULL)
+	{
+		return writeToMemory(ctx, writer, src, len);
+	}
+
+	if ((writer->buf == NULL) && ((writer->buf = alignedAlloc(ctx,
+		SDC_WRITE_CHUNK, &writer->buf_base)) == NULL))
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	writer->buf_cap = SDC_WRITE_CHUNK;
+
+	while (left > 0)
+	{
+		size_t take;
+
+		if ((writer->buf_len == 0) && (left >= SDC_WRITE_CHUNK)
+		&& ((writer->direct == SDC_FALSE)
+			|| (((uintptr_t) cursor % SDC_DIRECT_ALIGN) == 0)))
+		{
+			take = left - (left % SDC_WRITE_CHUNK);
+
+			if (writeOut(ctx, writer, cursor, take) == SDC_FAILURE)
+			{
+				return SDC_FAILURE;
+			}
+
+			cursor += take;
+			left   -= take;
+
+			continue;
+		}
+
+		take = writer->buf_cap - writer->buf_len;
+		take = (left < take) ? left : take;
+		memcpy(writer->buf + writer->buf_len, cursor, take);
+		writer->buf_len += take;
+		cursor += take;
+		left   -= take;
+
+		if ((writer->buf_len == writer->buf_cap)
+		&& (writerFlush(ctx, writer) == SDC_FAILURE))
+		{
+			return SDC_FAILURE;
+		}
+	}
+
+	return SDC_SUCCESS;
+}
+
+/* Direct I/O can only write whole blocks, so the tail is padded out and
+ * the file cut back to size afterwards */
+SDC_STAT writerFlush(struct sdc_context *ctx, struct sdcWriter *writer)
+{
+	const size_t pending = writer->buf_len;
+	size_t padded = pending;
+
+	if ((writer->fhandle == NULL) || (pending == 0))
+	{
+		return SDC_SUCCESS;
+	}
+
+	writer->buf_len = 0;
+
+	if (writer->direct == SDC_TRUE)
+	{
+		padded = (size_t) SDC_ALIGN_UP(pending);
+		memset(writer->buf + pending, 0, padded - pending);
+	}
+
+	if (writeOut(ctx, writer, writer->buf, padded) == SDC_FAILURE)
+	{
+		return SDC_FAILURE;
+	}
+
+	if (padded == pending)
+	{
+		return SDC_SUCCESS;
+	}
+
+	writer->file_pos -= padded - pending;
+#ifndef _WIN32
+	if (ftruncate(fileno(writer->fhandle), (off_t) writer->file_pos) != 0)
+	{
+		errorPrintf(ctx, "%s: Cannot trim direct I/O padding\n",
+			__func__);
+
+		return SDC_FAILURE;
+	}
+#endif
+
+	return SDC_SUCCESS;
+}
+
+/* A memory writer gets its buffer at exactly len. Files are allocated on
+ * disk up front where supported, which keeps them from fragmenting and
+ * runs out of space before converting rather than part way through */
+SDC_STAT writerReserve(struct sdc_context *ctx, struct sdcWriter *writer,
+	const uint64_t len)
+{
+	if (writer->fhandle == NULL)
+	{
+		char *tmp;
+
+		if ((len > SIZE_MAX) || (len <= writer->buf_cap))
+		{
+			return SDC_SUCCESS;
+		}
+
+		if ((tmp = sdcRealloc(ctx, writer->buf, (size_t) len)) == NULL)
+		{
+			errorPrintf(ctx, "%s: Realloc failure\n", __func__);
+
+			return SDC_FAILURE;
+		}
+
+		writer->buf     = tmp;
+		writer->buf_cap = (size_t) len;
+
+		return SDC_SUCCESS;
+	}
+
+#ifdef __linux__
+	/* Unlike posix_fallocate this never falls back to writing zeros */
+	if ((len > 0) && (fallocate(fileno(writer->fhandle), 0, 0,
+		(off_t) len) != 0))
+	{
+		if (errno == ENOSPC)
+		{
+			errorPrintf(ctx, "%s: Not enough space for %lu bytes "
+				"of output\n", __func__, len);
+
+			return SDC_FAILURE;
+		}
+
+		verbosePrintf(ctx, "Output not preallocated: %s\n",
+			strerror(errno));
+	}
+#endif
+
+	return SDC_SUCCESS;
+}
+
+SDC_BOOL writerCanPatch(const struct sdcWriter *writer)
+{
+	struct stat st;
+
+	if (writer->fhandle == NULL)
+	{
+		return SDC_TRUE;
+	}
+
+	return ((fstat(fileno(writer->fhandle), &st) == 0)
+		&& ((st.st_mode & S_IFMT) == S_IFREG)) ? SDC_TRUE : SDC_FALSE;
+}
+
+/* The patch is neither aligned nor whole blocks, so direct I/O is dropped
+ * for it, the data being out by then */
+SDC_STAT writerPatch(struct sdc_context *ctx, struct sdcWriter *writer,
+	const uint64_t offset, const void *src, const size_t len)
+{
+	if (writer->fhandle == NULL)
+	{
+		if ((offset > writer->buf_len)
+		|| (len > writer->buf_len - offset))
+		{
+			errorPrintf(ctx, "%s: Patch past the end of the "
+				"output\n", __func__);
+
+			return SDC_FAILURE;
+		}
+
+		memcpy(writer->buf + offset, src, len);
+
+		return SDC_SUCCESS;
+	}
+
+#ifdef O_DIRECT
+	if (writer->direct == SDC_TRUE)
+	{
+		setDirect(writer->fhandle, SDC_FALSE);
+		writer->direct = SDC_FALSE;
+	}
+#endif
+
+	if ((offset > LONG_MAX)
+	|| (fseek(writer->fhandle, (long) offset, SEEK_SET) != 0)
+	|| (fwrite(src, sizeof(char), len, writer->fhandle) != len)
+	|| (fseek(writer->fhandle, 0, SEEK_END) != 0))
+	{
+		errorPrintf(ctx, "%s: Could not rewrite %lu bytes at %llu\n",
+			__func__, len, (unsigned long long) offset);
+
+		return SDC_FAILURE;
+	}
+
+	return SDC_SUCCESS;
+}
+
+void writerFreeMemory(struct sdc_context *ctx, struct sdcWriter *writer)
+{
+	sdcFree(ctx, (writer->buf_base != NULL) ? writer->buf_base
+		: writer->buf);
+	writer->buf      = NULL;
+	writer->buf_base = NULL;
+	writer->buf_len = 0;
+	writer->buf_cap = 0;
+}
+
+#ifdef _WIN32
+SDC_STAT mapFile(struct sdc_context *ctx, struct sdcMapping *map,
+	const char *path)
+{
+	FILE *fhandle;
+	long len;
+
+	memset(map, 0, sizeof(*map));
+
+	if ((fhandle = fopen(path, "rb")) == NULL)
+	{
+		errorPrintf(ctx, "%s: Could not open '%s'\n", __func__, path);
+		return SDC_FAILURE;
+	}
+
+	if ((fseek(fhandle, 0, SEEK_END) != 0)
+	|| ((len = ftell(fhandle)) < 0) || (fseek(fhandle, 0, SEEK_SET) != 0))
+	{
+		errorPrintf(ctx, "%s: Could not size '%s'\n", __func__, path);
+		fclose(fhandle);
+		return SDC_FAILURE;
+	}
+
+	if ((len > 0) && (((map->base = sdcMalloc(ctx, (size_t) len)) == NULL)
+		|| (fread(map->base, 1, (size_t) len, fhandle)
+		!= (size_t) len)))
+	{
+		errorPrintf(ctx, "%s: Could not read '%s'\n", __func__, path);
+		sdcFree(ctx, map->base);
+		map->base = NULL;
+		fclose(fhandle);
+		return SDC_FAILURE;
+	}
+
+	fclose(fhandle);
+	map->data = map->base;
+	map->len  = (uint64_t) len;
+
+	return SDC_SUCCESS;
+}
+#else
+SDC_STAT mapFile(struct sdc_context *ctx, struct sdcMapping *map,
+	const char *path)
+{
+	struct stat st;
+	int fd;
+
+	memset(map, 0, sizeof(*map));
+
+	if ((fd = open(path, O_RDONLY)) < 0)
+	{
+		errorPrintf(ctx, "%s: Could not open '%s'\n", __func__, path);
+		return SDC_FAILURE;
+	}
+
+	if ((fstat(fd, &st) != 0) || ((st.st_mode & S_IFMT) != S_IFREG))
+	{
+		errorPrintf(ctx, "%s: '%s' is not a regular file\n", __func__,
+			path);
+		close(fd);
+		return SDC_FAILURE;
+	}
+
+	/* mmap refuses zero lengths, an empty file is simply no data */
+	if ((st.st_size > 0) && ((map->base = mmap(NULL, (size_t) st.st_size,
+		PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED))
+	{
+		errorPrintf(ctx, "%s: Could not map '%s'\n", __func__, path);
+		map->base = NULL;
+		close(fd);
+		return SDC_FAILURE;
+	}
+
+	close(fd);
+	map->data = map->base;
+	map->len  = (uint64_t) st.st_size;
+
+#ifdef POSIX_MADV_SEQUENTIAL
+	if (map->base != NULL)
+	{
+		posix_madvise(map->base, (size_t) map->len,
+			POSIX_MADV_SEQUENTIAL);
+	}
+#endif
+
+	return SDC_SUCCESS;
+}
+#endif
+
+void unmapFile(struct sdc_context *ctx, struct sdcMapping *map)
+{
+#ifdef _WIN32
+	sdcFree(ctx, map->base);
+#else
+	(void) ctx;
+
+	if (map->base != NULL)
+	{
+		munmap(map->base, (size_t) map->len);
+	}
+#endif
+
+	memset(map, 0, sizeof(*map));
+}
+
+/* Temporary siblings are only worth it for regular files, anything else
+ * such as /dev/stdout or a pipe cannot be renamed over */
+static SDC_BOOL replaceable(const char *path)
+{
+	struct stat st;
+
+	if (stat(path, &st) != 0)
+	{
+		return (errno == ENOENT) ? SDC_TRUE : SDC_FALSE;
+	}
+
+	return ((st.st_mode & S_IFMT) == S_IFREG) ? SDC_TRUE : SDC_FALSE;
+}
+
+#ifdef _WIN32
+static FILE* openSibling(struct sdc_context *ctx, const char *path,
+	char *tmp_path, const size_t tmp_cap)
+{
+	(void) ctx;
+
+	snprintf(tmp_path, tmp_cap, "%s.sdc-tmp", path);
+
+	return fopen(tmp_path, "wb");
+}
+#else
+/* Created exclusively with the mode the target already has, otherwise
+ * with the usual 0666 less the umask */
+static FILE* openSibling(struct sdc_context *ctx, const char *path,
+	char *tmp_path, const size_t tmp_cap)
+{
+	struct stat st;
+	const SDC_BOOL exists = (stat(path, &st) == 0) ? SDC_TRUE : SDC_FALSE;
+	unsigned attempt;
+	FILE *fhandle;
+	int fd = -1;
+
+	for (attempt = 0; (fd < 0) && (attempt < 100); attempt++)
+	{
+		snprintf(tmp_path, tmp_cap, "%s.sdc-%ld-%u", path,
+			(long) getpid(), attempt);
+
+		if (((fd = open(tmp_path, O_WRONLY | O_CREAT | O_EXCL, 0666))
+			< 0) && (errno != EEXIST))
+		{
+			break;
+		}
+	}
+
+	if (fd < 0)
+	{
+		return NULL;
+	}
+
+	if ((exists == SDC_TRUE) && (fchmod(fd, st.st_mode & 07777) != 0))
+	{
+		sdcLog(ctx, SDC_LOG_WARNING, "%s: Could not carry the mode of "
+			"'%s' over\n", __func__, path);
+	}
+
+	if ((fhandle = fdopen(fd, "wb")) == NULL)
+	{
+		close(fd);
+		remove(tmp_path);
+	}
+
+	return fhandle;
+}
+
+/* A link is followed so the sibling goes next to, and is renamed over,
+ * the file it points at rather than the link. *direct is set should it
+ * point nowhere, writing through it then creating the file as fopen would */
+static SDC_STAT followLinks(struct sdc_context *ctx,
+	struct sdcOutputFile *out, SDC_BOOL *direct)
+{
+	struct stat st;
+	char *real;
+
+	*direct = SDC_FALSE;
+
+	if ((lstat(out->path, &st) != 0) || (S_ISLNK(st.st_mode) == 0))
+	{
+		return SDC_SUCCESS;
+	}
+
+	if ((real = realpath(out->path, NULL)) == NULL)
+	{
+		*direct = SDC_TRUE;
+
+		return SDC_SUCCESS;
+	}
+
+	if ((out->real_path = sdcMalloc(ctx, strlen(real) + 1)) == NULL)
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+		free(real);
+
+		return SDC_FAILURE;
+	}
+
+	strcpy(out->real_path, real);
+	free(real);
+	out->path = out->real_path;
+
+	return SDC_SUCCESS;
+}
+
+/* Makes the rename itself durable */
+static void syncParentDir(const char *path)
+{
+	const char *slash = strrchr(path, '/');
+	char dir[4096] = ".";
+	int fd;
+
+	if ((slash != NULL) && ((size_t) (slash - path) < sizeof(dir)))
+	{
+		memcpy(dir, path, (size_t) (slash - path));
+		dir[(slash == path) ? 1 : slash - path] = '\0';
+	}
+
+	if ((fd = open(dir, O_RDONLY)) >= 0)
+	{
+		fsync(fd);
+		close(fd);
+	}
+}
+#endif
+
+static SDC_STAT openDirect(struct sdc_context *ctx,
+	struct sdcOutputFile *out)
+{
+	if ((out->fhandle = fopen(out->path, "wb")) == NULL)
+	{
+		errorPrintf(ctx, "%s: Failure to open file '%s'\n", __func__,
+			out->path);
+
+		return SDC_FAILURE;
+	}
+
+	return SDC_SUCCESS;
+}
+
+SDC_STAT outputFileOpen(struct sdc_context *ctx, struct sdcOutputFile *out,
+	const char *path, const SDC_BOOL replacing)
+{
+	SDC_BOOL direct = SDC_FALSE;
+	size_t tmp_cap;
+
+	memset(out, 0, sizeof(*out));
+	out->path = path;
+
+#ifndef _WIN32
+	if (followLinks(ctx, out, &direct) == SDC_FAILURE)
+	{
+		return SDC_FAILURE;
+	}
+#endif
+
+	if ((direct == SDC_TRUE) || (replaceable(out->path) == SDC_FALSE))
+	{
+		return openDirect(ctx, out);
+	}
+
+	tmp_cap = strlen(out->path) + 32;
+
+	if ((out->tmp_path = sdcMalloc(ctx, tmp_cap)) == NULL)
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	if ((out->fhandle = openSibling(ctx, out->path, out->tmp_path,
+		tmp_cap)) != NULL)
+	{
+		return SDC_SUCCESS;
+	}
+
+	sdcFree(ctx, out->tmp_path);
+	out->tmp_path = NULL;
+
+	if (replacing == SDC_TRUE)
+	{
+		errorPrintf(ctx, "%s: Failure to create a temporary file "
+			"next to '%s'\n", __func__, out->path);
+
+		return SDC_FAILURE;
+	}
+
+	sdcLog(ctx, SDC_LOG_WARNING, "%s: No temporary file can be created "
+		"next to '%s', writing to it directly\n", __func__, out->path);
+
+	return openDirect(ctx, out);
+}
+
+/* rename will not replace an existing file on Windows, MoveFileEx does so
+ * without a moment where neither is in place */
+static SDC_BOOL replaceFile(const char *from, const char *to)
+{
+#ifdef _WIN32
+	return (MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING
+		| MOVEFILE_WRITE_THROUGH) != 0) ? SDC_TRUE : SDC_FALSE;
+#else
+	return (rename(from, to) == 0) ? SDC_TRUE : SDC_FALSE;
+#endif
+}
+
+SDC_STAT outputFileCommit(struct sdc_context *ctx, struct sdcOutputFile *out)
+{
+	SDC_STAT ret_code = SDC_SUCCESS;
+
+	if (fflush(out->fhandle) != 0)
+	{
+		errorPrintf(ctx, "%s: Bad flush of '%s'\n", __func__,
+			out->path);
+		ret_code = SDC_FAILURE;
+	}
+#ifndef _WIN32
+	else if ((out->tmp_path != NULL) && (fsync(fileno(out->fhandle)) != 0))
+	{
+		errorPrintf(ctx, "%s: Bad sync of '%s'\n", __func__,
+			out->path);
+		ret_code = SDC_FAILURE;
+	}
+#endif
+#ifdef POSIX_FADV_DONTNEED
+	/* Everything is on disk now, whatever write-behind left included */
+	if ((ret_code == SDC_SUCCESS) && (ctx->cache_friendly == SDC_TRUE))
+	{
+		posix_fadvise(fileno(out->fhandle), 0, 0,
+			POSIX_FADV_DONTNEED);
+	}
+#endif
+
+	if (fclose(out->fhandle) == EOF)
+	{
+		errorPrintf(ctx, "%s: Bad close on output file\n", __func__);
+		ret_code = SDC_FAILURE;
+	}
+
+	out->fhandle = NULL;
+
+	if (out->tmp_path == NULL)
+	{
+		return ret_code;
+	}
+
+	if (ret_code == SDC_FAILURE)
+	{
+		outputFileDiscard(ctx, out);
+
+		return SDC_FAILURE;
+	}
+
+	if (replaceFile(out->tmp_path, out->path) == SDC_FALSE)
+	{
+		errorPrintf(ctx, "%s: Failure to rename '%s' to '%s'\n",
+			__func__, out->tmp_path, out->path);
+		outputFileDiscard(ctx, out);
+
+		return SDC_FAILURE;
+	}
+
+#ifndef _WIN32
+	syncParentDir(out->path);
+#endif
+	sdcFree(ctx, out->tmp_path);
+	out->tmp_path = NULL;
+
+	return SDC_SUCCESS;
+}
+
+void outputFileDiscard(struct sdc_context *ctx, struct sdcOutputFile *out)
+{
+	if (out->fhandle != NULL)
+	{
+		fclose(out->fhandle);
+		out->fhandle = NULL;
+	}
+
+	if (out->tmp_path != NULL)
+	{
+		remove(out->tmp_path);
+		sdcFree(ctx, out->tmp_path);
+		out->tmp_path = NULL;
+	}
+
+	sdcFree(ctx, out->real_path);
+	out->real_path = NULL;
+}
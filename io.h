@@ -0,0 +1,116 @@
+#ifndef IO_H
+#define IO_H
+
+#include <stdio.h>
+
+#include "main.h"
+
+/* Conversion reads and writes through these so that the same code serves
+ * both files and in-memory buffers. Exactly one of fhandle or buf is set */
+
+/* Memory writers start out this large, doubling as they fill */
+#define SDC_COPY_CHUNK (1 << 20)
+
+/* File output goes out in chunks of this size at offsets that are a
+ * multiple of it, the page cache then never sees partial pages */
+#define SDC_WRITE_CHUNK (8 << 20)
+
+/* O_DIRECT transfers need their memory, file offset and length aligned
+ * to the device's logical block size, which this covers on anything used
+ * today */
+#define SDC_DIRECT_ALIGN 4096
+
+/* With direct I/O the file is read through bounce, aligned within the
+ * allocation at bounce_base */
+struct sdcReader
+{
+	FILE *fhandle;
+	const char *buf;
+	uint64_t buf_len;
+	SDC_BOOL advised;
+	SDC_BOOL direct;
+	char *bounce;
+	void *bounce_base;
+};
+
+/* For files buf only gathers the next chunk, see writerFlush, and is kept
+ * aligned within the allocation at buf_base */
+struct sdcWriter
+{
+	FILE *fhandle;
+	char *buf;
+	void *buf_base;
+	size_t buf_len;
+	size_t buf_cap;
+	uint64_t file_pos;
+	uint64_t synced_to;    /* written back and waited on up to here */
+	SDC_BOOL write_behind;
+	SDC_BOOL direct;
+};
+
+void readerFromFile(struct sdcReader *reader, FILE *fhandle);
+void readerFromMemory(struct sdcReader *reader, const void *buf,
+	const uint64_t len);
+SDC_STAT readerReadAt(struct sdc_context *ctx, struct sdcReader *reader,
+	const uint64_t offset, void *dst, const size_t len);
+/* Bytes the reader holds, UINT64_MAX for anything but a regular file or
+ * memory as there is no telling short of reading it all */
+uint64_t readerSize(const struct sdcReader *reader);
+void readerRelease(struct sdc_context *ctx, struct sdcReader *reader);
+
+void writerToFile(struct sdcWriter *writer, FILE *fhandle);
+void writerToMemory(struct sdcWriter *writer);
+
+/* Switch a file reader or writer over to O_DIRECT, staying buffered where
+ * the system or file system will not have it. Filesystems that only
+ * refuse the first transfer, eg: older tmpfs, are dropped back from then */
+void readerDirect(struct sdc_context *ctx, struct sdcReader *reader);
+void writerDirect(struct sdc_context *ctx, struct sdcWriter *writer);
+SDC_STAT writerWrite(struct sdc_context *ctx, struct sdcWriter *writer,
+	const void *src, const size_t len);
+/* Writes out whatever a file writer still holds, to be called once all
+ * is written. A no-op for memory */
+SDC_STAT writerFlush(struct sdc_context *ctx, struct sdcWriter *writer);
+SDC_STAT writerReserve(struct sdc_context *ctx, struct sdcWriter *writer,
+	const uint64_t len);
+void writerFreeMemory(struct sdc_context *ctx, struct sdcWriter *writer);
+/* Rewrites len bytes already written at offset, for files only once all
+ * is flushed. Patching needs memory or a regular file */
+SDC_BOOL writerCanPatch(const struct sdcWriter *writer);
+SDC_STAT writerPatch(struct sdc_context *ctx, struct sdcWriter *writer,
+	const uint64_t offset, const void *src, const size_t len);
+
+/* A whole file read-only in memory, mapped where the system can and read
+ * into base otherwise. data is NULL for an empty file */
+struct sdcMapping
+{
+	const char *data;
+	uint64_t len;
+	void *base;
+};
+
+SDC_STAT mapFile(struct sdc_context *ctx, struct sdcMapping *map,
+	const char *path);
+void unmapFile(struct sdc_context *ctx, struct sdcMapping *map);
+
+/* Regular files are written to a temporary sibling, synced and renamed
+ * over path on commit, so an interrupted conversion leaves whatever was
+ * there before untouched. A symlink has the file it points at replaced.
+ * Anything else, eg: /dev/stdout, is written to directly, as is a file
+ * whose directory takes no sibling unless replacing, where the input is
+ * still being read. Discarding closes and removes the sibling */
+struct sdcOutputFile
+{
+	FILE *fhandle;
+	const char *path;
+	char *tmp_path;
+	char *real_path;  /* path with its links followed, if it has any */
+};
+
+SDC_STAT outputFileOpen(struct sdc_context *ctx, struct sdcOutputFile *out,
+	const char *path, const SDC_BOOL replacing);
+SDC_STAT outputFileCommit(struct sdc_context *ctx,
+	struct sdcOutputFile *out);
+void outputFileDiscard(struct sdc_context *ctx, struct sdcOutputFile *out);
+
+#endif /* IO_H */
@@ -0,0 +1,2164 @@
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "kernels.h"
+
+#ifdef SDC_X86_SIMD
+#include <immintrin.h>
+
+#define SDC_TARGET_AVX2   __attribute__((target("avx2,f16c")))
+#define SDC_TARGET_AVX512 __attribute__((target("avx512f,avx512dq")))
+
+/* For the error measuring helpers, which GCC would otherwise leave as calls
+ * spilling their vector arguments through memory every block */
+#define SDC_ALWAYS_INLINE __attribute__((always_inline)) __inline__
+#endif /* SDC_X86_SIMD */
+
+/* Helper function to get around strict aliasing */
+uint32_t asU32(const float in)
+{
+	uint32_t out = 0;
+
+	memcpy(&out, &in, sizeof(float));
+
+	return out;
+}
+
+float asF32(const uint32_t in)
+{
+	float out = 0;
+
+	memcpy(&out, &in, sizeof(float));
+
+	return out;
+}
+
+/* Adapted from Maratyszcza's FP16 header library, rounds to nearest even. 
+ * NaNs keep the top of their payload the same way F16C hardware does */
+uint16_t fltToHlf(const float in)
+{
+	const float scale_to_inf  = asF32(0x77800000);
+	const float scale_to_zero = asF32(0x08800000);
+	const uint32_t u32_in     = asU32(in);
+	const uint32_t shl1       = u32_in << 1;
+	const uint32_t sign       = u32_in & 0x80000000;
+	uint32_t bias             = (shl1 & 0xFF000000);
+	float base;
+	uint32_t nonsign;
+
+	bias = (bias > 0x71000000) ? bias : 0x71000000;
+	base = ((((in < 0.f) ? -in : in) * scale_to_inf) * scale_to_zero)
+		+ asF32((bias >> 1) + 0x07800000);
+	nonsign = ((asU32(base) >> 13) & 0x00007C00)
+		+ (asU32(base) & 0x00000FFF);
+
+	return (uint16_t) ((sign >> 16) | ((shl1 > 0xFF000000)
+		? (0x7E00 | ((u32_in >> 13) & 0x03FF)) : nonsign));
+}
+
+/* Also from Maratyszcza, every half value is exactly representable */
+float hlfToFlt(const uint16_t in)
+{
+	const uint32_t w           = (uint32_t) in << 16;
+	const uint32_t sign        = w & 0x80000000;
+	const uint32_t two_w       = w + w;
+	const float normalized     = asF32((two_w >> 4) + 0x70000000)
+		* asF32(0x07800000);
+	const float denormalized   = asF32((two_w >> 17) | 0x3F000000)
+		- 0.5f;
+
+	return asF32(sign | ((two_w < 0x08000000)
+		? asU32(denormalized) : asU32(normalized)));
+}
+
+/* Rounds to nearest even, NaNs are kept quiet rather than rounded into
+ * infinity */
+uint16_t fltToBft(const float in)
+{
+	const uint32_t u32_in = asU32(in);
+
+	if ((u32_in & 0x7FFFFFFF) > 0x7F800000)
+	{
+		return (uint16_t) ((u32_in >> 16) | 0x0040);
+	}
+
+	return (uint16_t) ((u32_in + 0x7FFF + ((u32_in >> 16) & 1)) >> 16);
+}
+
+float bftToFlt(const uint16_t in)
+{
+	return asF32((uint32_t) in << 16);
+}
+
+/* Clamps into [-max, max] without disturbing NaN */
+static float clampFlt(const float in, const float max)
+{
+	return (in > max) ? max : ((in < -max) ? -max : in);
+}
+
+/* Values beyond the range of the narrower type saturate to its largest 
+ * finite value rather than becoming infinities */
+static float dblToFltSat(const double in)
+{
+	return (in > FLT_MAX) ? FLT_MAX 
+		: ((in < -FLT_MAX) ? -FLT_MAX : (float) in);
+}
+
+static uint16_t fltToHlfSat(const float in)
+{
+	return fltToHlf(clampFlt(in, SDC_HLF_MAX));
+}
+
+static uint16_t fltToBftSat(const float in)
+{
+	return fltToBft(clampFlt(in, SDC_BFT_MAX));
+}
+
+static int32_t i64ToI32Sat(const int64_t in)
+{
+	return (in > INT32_MAX) ? INT32_MAX
+		: ((in < INT32_MIN) ? INT32_MIN : (int32_t) in);
+}
+
+static int16_t i64ToI16Sat(const int64_t in)
+{
+	return (in > INT16_MAX) ? INT16_MAX
+		: ((in < INT16_MIN) ? INT16_MIN : (int16_t) in);
+}
+
+static int8_t i64ToI8Sat(const int64_t in)
+{
+	return (in > INT8_MAX) ? INT8_MAX
+		: ((in < INT8_MIN) ? INT8_MIN : (int8_t) in);
+}
+
+void mergeConvError(struct sdcConvError *into,
+	const struct sdcConvError *from)
+{
+	into->max_abs = (from->max_abs > into->max_abs) 
+		? from->max_abs : into->max_abs;
+	into->max_rel = (from->max_rel > into->max_rel) 
+		? from->max_rel : into->max_rel;
+	into->overflow  += from->overflow;
+	into->underflow += from->underflow;
+	into->nan       += from->nan;
+}
+
+/* Folds one element into err, x being the exact input and y the converted 
+ * output widened back, the vectorized kernels do the same lane-wise */
+static void measureError(struct sdcConvError *err, const double x,
+	const double y, const double max)
+{
+	const double abs_x = (x < 0.0) ? -x : x;
+	const double diff  = (x < y) ? y - x : x - y;
+
+	if (x != x)
+	{
+		err->nan++;
+
+		return;
+	}
+
+	if (abs_x > max)
+	{
+		err->overflow++;
+
+		return;
+	}
+
+	if ((x != 0.0) && (y == 0.0))
+	{
+		err->underflow++;
+	}
+
+	if (diff > err->max_abs)
+	{
+		err->max_abs = diff;
+	}
+
+	if ((x != 0.0) && ((diff / abs_x) > err->max_rel))
+	{
+		err->max_rel = diff / abs_x;
+	}
+}
+
+static void measureFlt(struct sdcConvError *err, const double x,
+	const float y)
+{
+	measureError(err, x, (double) y, FLT_MAX);
+}
+
+static void measureHlf(struct sdcConvError *err, const double x,
+	const uint16_t y)
+{
+	measureError(err, x, (double) hlfToFlt(y), SDC_HLF_MAX);
+}
+
+static void measureBft(struct sdcConvError *err, const double x,
+	const uint16_t y)
+{
+	measureError(err, x, (double) bftToFlt(y), SDC_BFT_MAX);
+}
+
+/* Narrowed integers are either exact or saturated */
+static void measureInt(struct sdcConvError *err, const double x,
+	const int64_t y)
+{
+	err->overflow += ((double) y != x);
+}
+
+#define SDC_AS_FLT(x) ((float) (x))
+#define SDC_AS_DBL(x) ((double) (x))
+#define SDC_AS_IS(x)  (x)
+
+/* Every scalar kernel is an element-wise map through a float, or for the 
+ * integer narrowing a saturating cast, this is also what the vectorized 
+ * kernels fall back on for the tail of a buffer. The error is measured 
+ * against the input widened to a double by to_dbl */
+#define SDC_SCALAR_KERNEL(func, in_type, to_flt, to_dbl, out_type,     \
+	from_flt, measure)                                             \
+static void func(const void *in, void *out, const size_t len,          \
+	struct sdcConvError *err)                                      \
+{                                                                      \
+	const in_type *src = in;                                       \
+	out_type *dst      = out;                                      \
+	size_t sk_i;                                                   \
+	                                                               \
+	if (err == NULL)                                               \
+	{                                                              \
+		for (sk_i = 0; sk_i < len; sk_i++)                     \
+		{                                                      \
+			dst[sk_i] = from_flt(to_flt(src[sk_i]));       \
+		}                                                      \
+		                                                       \
+		return;                                                \
+	}                                                              \
+	                                                               \
+	for (sk_i = 0; sk_i < len; sk_i++)                             \
+	{                                                              \
+		dst[sk_i] = from_flt(to_flt(src[sk_i]));               \
+		measure(err, to_dbl(src[sk_i]), dst[sk_i]);            \
+	}                                                              \
+}
+
+SDC_SCALAR_KERNEL(doubleToFloat, double, dblToFltSat, SDC_AS_DBL,
+	float, SDC_AS_FLT, measureFlt)
+SDC_SCALAR_KERNEL(doubleToHalf, double, dblToFltSat, SDC_AS_DBL,
+	uint16_t, fltToHlfSat, measureHlf)
+SDC_SCALAR_KERNEL(doubleToBrain, double, dblToFltSat, SDC_AS_DBL,
+	uint16_t, fltToBftSat, measureBft)
+SDC_SCALAR_KERNEL(floatToHalf, float, SDC_AS_FLT, SDC_AS_DBL,
+	uint16_t, fltToHlfSat, measureHlf)
+SDC_SCALAR_KERNEL(floatToBrain, float, SDC_AS_FLT, SDC_AS_DBL,
+	uint16_t, fltToBftSat, measureBft)
+SDC_SCALAR_KERNEL(halfToBrain, uint16_t, hlfToFlt, hlfToFlt,
+	uint16_t, fltToBftSat, measureBft)
+SDC_SCALAR_KERNEL(brainToHalf, uint16_t, bftToFlt, bftToFlt,
+	uint16_t, fltToHlfSat, measureHlf)
+
+/* Integers never exceed FLT_MAX so the F32 target needs no clamping */
+SDC_SCALAR_KERNEL(signed64ToFloat, int64_t, SDC_AS_FLT, SDC_AS_DBL,
+	float, SDC_AS_FLT, measureFlt)
+SDC_SCALAR_KERNEL(signed64ToHalf, int64_t, SDC_AS_FLT, SDC_AS_DBL,
+	uint16_t, fltToHlfSat, measureHlf)
+SDC_SCALAR_KERNEL(signed64ToBrain, int64_t, SDC_AS_FLT, SDC_AS_DBL,
+	uint16_t, fltToBftSat, measureBft)
+SDC_SCALAR_KERNEL(signed32ToFloat, int32_t, SDC_AS_FLT, SDC_AS_DBL,
+	float, SDC_AS_FLT, measureFlt)
+SDC_SCALAR_KERNEL(signed32ToHalf, int32_t, SDC_AS_FLT, SDC_AS_DBL,
+	uint16_t, fltToHlfSat, measureHlf)
+SDC_SCALAR_KERNEL(signed32ToBrain, int32_t, SDC_AS_FLT, SDC_AS_DBL,
+	uint16_t, fltToBftSat, measureBft)
+SDC_SCALAR_KERNEL(signed16ToFloat, int16_t, SDC_AS_FLT, SDC_AS_DBL,
+	float, SDC_AS_FLT, measureFlt)
+SDC_SCALAR_KERNEL(signed16ToHalf, int16_t, SDC_AS_FLT, SDC_AS_DBL,
+	uint16_t, fltToHlfSat, measureHlf)
+SDC_SCALAR_KERNEL(signed16ToBrain, int16_t, SDC_AS_FLT, SDC_AS_DBL,
+	uint16_t, fltToBftSat, measureBft)
+SDC_SCALAR_KERNEL(signed8ToFloat, int8_t, SDC_AS_FLT, SDC_AS_DBL,
+	float, SDC_AS_FLT, measureFlt)
+SDC_SCALAR_KERNEL(signed8ToHalf, int8_t, SDC_AS_FLT, SDC_AS_DBL,
+	uint16_t, fltToHlfSat, measureHlf)
+SDC_SCALAR_KERNEL(signed8ToBrain, int8_t, SDC_AS_FLT, SDC_AS_DBL,
+	uint16_t, fltToBftSat, measureBft)
+SDC_SCALAR_KERNEL(unsigned8ToFloat, uint8_t, SDC_AS_FLT, SDC_AS_DBL,
+	float, SDC_AS_FLT, measureFlt)
+SDC_SCALAR_KERNEL(unsigned8ToHalf, uint8_t, SDC_AS_FLT, SDC_AS_DBL,
+	uint16_t, fltToHlfSat, measureHlf)
+SDC_SCALAR_KERNEL(unsigned8ToBrain, uint8_t, SDC_AS_FLT, SDC_AS_DBL,
+	uint16_t, fltToBftSat, measureBft)
+
+SDC_SCALAR_KERNEL(signed64ToSigned32, int64_t, i64ToI32Sat, SDC_AS_DBL,
+	int32_t, SDC_AS_IS, measureInt)
+SDC_SCALAR_KERNEL(signed64ToSigned16, int64_t, i64ToI16Sat, SDC_AS_DBL,
+	int16_t, SDC_AS_IS, measureInt)
+SDC_SCALAR_KERNEL(signed64ToSigned8, int64_t, i64ToI8Sat, SDC_AS_DBL,
+	int8_t, SDC_AS_IS, measureInt)
+
+void initRange(struct sdcRange *range)
+{
+	memset(range, 0, sizeof(*range));
+	range->min     = HUGE_VAL;
+	range->max     = -HUGE_VAL;
+	range->abs_min = HUGE_VAL;
+}
+
+static void mergeRange(struct sdcRange *range, const double min,
+	const double max, const double abs_min)
+{
+	range->min     = (min < range->min) ? min : range->min;
+	range->max     = (max > range->max) ? max : range->max;
+	range->abs_min = (abs_min < range->abs_min) ? abs_min : range->abs_min;
+}
+
+/* f is x as the F32 conversion would leave it, the half types are checked
+ * by converting f the same way the kernels do and back again */
+static void scanValue(struct sdcRange *range, const double x, const float f)
+{
+	const double abs_x = (x < 0.0) ? -x : x;
+
+	if (x != x)
+	{
+		range->nan++;
+
+		return;
+	}
+
+	mergeRange(range, x, x, (x != 0.0) ? abs_x : HUGE_VAL);
+	range->inexact[FLOAT_32]  += ((double) f != x);
+	range->inexact[FLOAT_16]  += ((double) hlfToFlt(fltToHlfSat(f)) != x);
+	range->inexact[BFLOAT_16] += ((double) bftToFlt(fltToBftSat(f)) != x);
+}
+
+static void scanDouble(const void *in, const size_t len,
+	struct sdcRange *range)
+{
+	const double *src = in;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		scanValue(range, src[i], dblToFltSat(src[i]));
+	}
+}
+
+static void scanFloat(const void *in, const size_t len,
+	struct sdcRange *range)
+{
+	const float *src = in;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		scanValue(range, (double) src[i], src[i]);
+	}
+}
+
+/* Integers only need their range, which settles what they fit in */
+static void scanSigned64(const void *in, const size_t len,
+	struct sdcRange *range)
+{
+	const int64_t *src = in;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		const double x = (double) src[i];
+
+		mergeRange(range, x, x, (x != 0.0)
+			? ((x < 0.0) ? -x : x) : HUGE_VAL);
+	}
+}
+
+/* --verify brings both sides of a tensor to doubles, which hold every 
+ * value of every dtype but I64 exactly */
+#define SDC_WIDEN_KERNEL(func, in_type, to_dbl)                       \
+static void func(const void *in, double *out, const size_t len)        \
+{                                                                      \
+	const in_type *src = in;                                       \
+	size_t wk_i;                                                   \
+	                                                               \
+	for (wk_i = 0; wk_i < len; wk_i++)                             \
+	{                                                              \
+		out[wk_i] = to_dbl(src[wk_i]);                         \
+	}                                                              \
+}
+
+SDC_WIDEN_KERNEL(widenDouble, double, SDC_AS_DBL)
+SDC_WIDEN_KERNEL(widenFloat, float, SDC_AS_DBL)
+SDC_WIDEN_KERNEL(widenHalf, uint16_t, hlfToFlt)
+SDC_WIDEN_KERNEL(widenBrain, uint16_t, bftToFlt)
+SDC_WIDEN_KERNEL(widenSigned64, int64_t, SDC_AS_DBL)
+SDC_WIDEN_KERNEL(widenSigned32, int32_t, SDC_AS_DBL)
+SDC_WIDEN_KERNEL(widenSigned16, int16_t, SDC_AS_DBL)
+SDC_WIDEN_KERNEL(widenSigned8, int8_t, SDC_AS_DBL)
+SDC_WIDEN_KERNEL(widenUnsigned8, uint8_t, SDC_AS_DBL)
+
+/* y is expected to be x clamped into [lo, hi] and then rounded, within the
+ * tolerance. NaNs must stay NaNs */
+static void compareValue(const double x, const double y,
+	const struct sdcTolerance *tol, struct sdcCompare *cmp)
+{
+	const double xc     = (x > tol->hi) ? tol->hi
+		: ((x < tol->lo) ? tol->lo : x);
+	const double abs_xc = (xc < 0.0) ? -xc : xc;
+	const double diff   = (y < xc) ? xc - y : y - xc;
+
+	if (x == y)
+	{
+		return;
+	}
+
+	if ((x != x) || (y != y))
+	{
+		cmp->violations += ((x == x) || (y == y));
+
+		return;
+	}
+
+	cmp->saturated  += (xc != x);
+	cmp->violations += ((diff > tol->abs) && (diff > tol->rel * abs_xc));
+	cmp->max_abs = (diff > cmp->max_abs) ? diff : cmp->max_abs;
+
+	if ((xc != 0.0) && ((diff / abs_xc) > cmp->max_rel))
+	{
+		cmp->max_rel = diff / abs_xc;
+	}
+}
+
+static void compareDoubles(const double *x, const double *y,
+	const size_t len, const struct sdcTolerance *tol,
+	struct sdcCompare *cmp)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		compareValue(x[i], y[i], tol, cmp);
+	}
+}
+
+/* XXH64 as specified, four lanes taking a 32 byte stripe at a time */
+#define SDC_XXH_P1 0x9E3779B185EBCA87ULL
+#define SDC_XXH_P2 0xC2B2AE3D27D4EB4FULL
+#define SDC_XXH_P3 0x165667B19E3779F9ULL
+#define SDC_XXH_P4 0x85EBCA77C2B2AE63ULL
+#define SDC_XXH_P5 0x27D4EB2F165667C5ULL
+#define SDC_XXH_STRIPE 32
+#define SDC_ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static uint64_t readLe64(const unsigned char *src)
+{
+	uint64_t val;
+
+	memcpy(&val, src, sizeof(val));
+
+	return PORTEGG_LE_TO_SYS(uint64_t, val);
+}
+
+static uint32_t readLe32(const unsigned char *src)
+{
+	uint32_t val;
+
+	memcpy(&val, src, sizeof(val));
+
+	return PORTEGG_LE_TO_SYS(uint32_t, val);
+}
+
+static uint64_t xxhRound(uint64_t acc, const uint64_t input)
+{
+	acc += input * SDC_XXH_P2;
+	acc  = SDC_ROTL64(acc, 31);
+
+	return acc * SDC_XXH_P1;
+}
+
+static uint64_t xxhMerge(uint64_t hash, const uint64_t acc)
+{
+	hash ^= xxhRound(0, acc);
+
+	return hash * SDC_XXH_P1 + SDC_XXH_P4;
+}
+
+static void xxhInit(uint64_t *lanes, const uint64_t seed)
+{
+	lanes[0] = seed + SDC_XXH_P1 + SDC_XXH_P2;
+	lanes[1] = seed + SDC_XXH_P2;
+	lanes[2] = seed;
+	lanes[3] = seed - SDC_XXH_P1;
+}
+
+/* Merges the lanes, if any stripe went through them, then takes in the
+ * tail of fewer than SDC_XXH_STRIPE bytes and mixes the result */
+static uint64_t xxhFinish(const uint64_t *lanes, const unsigned char *tail,
+	size_t len, const uint64_t total, const uint64_t seed)
+{
+	uint64_t hash = seed + SDC_XXH_P5;
+
+	if (total >= SDC_XXH_STRIPE)
+	{
+		hash = SDC_ROTL64(lanes[0], 1) + SDC_ROTL64(lanes[1], 7)
+			+ SDC_ROTL64(lanes[2], 12) + SDC_ROTL64(lanes[3], 18);
+		hash = xxhMerge(hash, lanes[0]);
+		hash = xxhMerge(hash, lanes[1]);
+		hash = xxhMerge(hash, lanes[2]);
+		hash = xxhMerge(hash, lanes[3]);
+	}
+
+	hash += total;
+
+	for (; len >= 8; len -= 8, tail += 8)
+	{
+		hash ^= xxhRound(0, readLe64(tail));
+		hash  = SDC_ROTL64(hash, 27) * SDC_XXH_P1 + SDC_XXH_P4;
+	}
+
+	if (len >= 4)
+	{
+		hash ^= (uint64_t) readLe32(tail) * SDC_XXH_P1;
+		hash  = SDC_ROTL64(hash, 23) * SDC_XXH_P2 + SDC_XXH_P3;
+		tail += 4;
+		len  -= 4;
+	}
+
+	for (; len > 0; len--, tail++)
+	{
+		hash ^= (uint64_t) *tail * SDC_XXH_P5;
+		hash  = SDC_ROTL64(hash, 11) * SDC_XXH_P1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= SDC_XXH_P2;
+	hash ^= hash >> 29;
+	hash *= SDC_XXH_P3;
+
+	return hash ^ (hash >> 32);
+}
+
+uint64_t xxh64(const void *in, const size_t len, const uint64_t seed)
+{
+	const unsigned char *src = in;
+	uint64_t lanes[4];
+	size_t i;
+
+	xxhInit(lanes, seed);
+
+	for (i = 0; i + SDC_XXH_STRIPE <= len; i += SDC_XXH_STRIPE)
+	{
+		lanes[0] = xxhRound(lanes[0], readLe64(src + i));
+		lanes[1] = xxhRound(lanes[1], readLe64(src + i + 8));
+		lanes[2] = xxhRound(lanes[2], readLe64(src + i + 16));
+		lanes[3] = xxhRound(lanes[3], readLe64(src + i + 24));
+	}
+
+	return xxhFinish(lanes, src + i, len - i, len, seed);
+}
+
+uint64_t foldDigests(uint64_t *digests, const size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		PORTEGG_SYS_TO_LE_RAW(sizeof(*digests), (char *) &digests[i]);
+	}
+
+	return xxh64(digests, len * sizeof(*digests), 0);
+}
+
+static void hashChunks(const void *in, const uint64_t len,
+	uint64_t *digests)
+{
+	const char *src = in;
+	uint64_t at;
+
+	for (at = 0; at < len; at += SDC_HASH_CHUNK)
+	{
+		*digests++ = xxh64(src + at, (size_t) ((len - at
+			< SDC_HASH_CHUNK) ? len - at : SDC_HASH_CHUNK), 0);
+	}
+}
+
+#ifdef SDC_X86_SIMD
+/* The vectorized kernels are built the same way from a loader widening a
+ * block of input into float lanes and a storer narrowing them to output, 
+ * the width being 8 lanes for AVX2 and 16 lanes for AVX-512. Measuring 
+ * the error the input is also widened into two halves of double lanes, 
+ * exactly so, and compared against the output just stored, read back */
+#define SDC_SIMD_KERNEL(target, width, isa, func, in_type, load, widen, \
+	out_type, store, measure, tail)                                \
+target                                                                 \
+static void func(const void *in, void *out, const size_t len,          \
+	struct sdcConvError *err)                                      \
+{                                                                      \
+	const in_type *src = in;                                       \
+	out_type *dst      = out;                                      \
+	struct errAcc##isa vk_acc;                                     \
+	size_t vk_i = 0;                                               \
+	                                                               \
+	if (err == NULL)                                               \
+	{                                                              \
+		for (; vk_i + (width) <= len; vk_i += (width))         \
+		{                                                      \
+			store(dst + vk_i, load(src + vk_i));           \
+		}                                                      \
+	}                                                              \
+	else                                                           \
+	{                                                              \
+		errInit##isa(&vk_acc);                                 \
+		                                                       \
+		for (; vk_i + (width) <= len; vk_i += (width))         \
+		{                                                      \
+			const flt##isa vk_x = load(src + vk_i);        \
+			dbl##isa vk_lo, vk_hi;                         \
+			                                               \
+			store(dst + vk_i, vk_x);                       \
+			widen(src + vk_i, vk_x, &vk_lo, &vk_hi);       \
+			measure(&vk_acc, dst + vk_i, vk_lo, vk_hi);    \
+		}                                                      \
+		                                                       \
+		errFlush##isa(&vk_acc, err);                           \
+	}                                                              \
+	                                                               \
+	tail(src + vk_i, dst + vk_i, len - vk_i, err);                 \
+}
+
+/* Note that the min/max operand order matters, x86 returns the second
+ * operand when either is NaN so x must come second to survive clamping */
+
+/* Out of range doubles become infinities here, which the saturating 
+ * storers then clamp just the same as the finite values */
+SDC_TARGET_AVX2
+static __m256 loadF64Avx2(const double *src)
+{
+	return _mm256_set_m128(_mm256_cvtpd_ps(_mm256_loadu_pd(src + 4)),
+		_mm256_cvtpd_ps(_mm256_loadu_pd(src)));
+}
+
+SDC_TARGET_AVX2
+static __m256 loadF32Avx2(const float *src)
+{
+	return _mm256_loadu_ps(src);
+}
+
+SDC_TARGET_AVX2
+static __m256 loadHlfAvx2(const uint16_t *src)
+{
+	return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *) src));
+}
+
+SDC_TARGET_AVX2
+static __m256 loadBftAvx2(const uint16_t *src)
+{
+	return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(
+		_mm_loadu_si128((const __m128i *) src)), 16));
+}
+
+SDC_TARGET_AVX2
+static __m256 loadI32Avx2(const int32_t *src)
+{
+	return _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *) src));
+}
+
+SDC_TARGET_AVX2
+static __m256 loadI16Avx2(const int16_t *src)
+{
+	return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(
+		_mm_loadu_si128((const __m128i *) src)));
+}
+
+SDC_TARGET_AVX2
+static __m256 loadI8Avx2(const int8_t *src)
+{
+	return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(
+		_mm_loadl_epi64((const __m128i *) src)));
+}
+
+SDC_TARGET_AVX2
+static __m256 loadU8Avx2(const uint8_t *src)
+{
+	return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+		_mm_loadl_epi64((const __m128i *) src)));
+}
+
+SDC_TARGET_AVX2
+static void storeFltAvx2(float *dst, const __m256 x)
+{
+	_mm256_storeu_ps(dst, x);
+}
+
+SDC_TARGET_AVX2
+static void storeFltSatAvx2(float *dst, const __m256 x)
+{
+	_mm256_storeu_ps(dst, _mm256_max_ps(_mm256_set1_ps(-FLT_MAX),
+		_mm256_min_ps(_mm256_set1_ps(FLT_MAX), x)));
+}
+
+SDC_TARGET_AVX2
+static void storeHlfAvx2(uint16_t *dst, const __m256 x)
+{
+	const __m256 clamped = _mm256_max_ps(_mm256_set1_ps(-SDC_HLF_MAX),
+		_mm256_min_ps(_mm256_set1_ps(SDC_HLF_MAX), x));
+
+	_mm_storeu_si128((__m128i *) dst,
+		_mm256_cvtps_ph(clamped, _MM_FROUND_TO_NEAREST_INT));
+}
+
+SDC_TARGET_AVX2
+static void storeBftAvx2(uint16_t *dst, const __m256 x)
+{
+	const __m256 clamped = _mm256_max_ps(_mm256_set1_ps(-SDC_BFT_MAX),
+		_mm256_min_ps(_mm256_set1_ps(SDC_BFT_MAX), x));
+	const __m256i u32_in = _mm256_castps_si256(clamped);
+	const __m256i lsb    = _mm256_and_si256(
+		_mm256_srli_epi32(u32_in, 16), _mm256_set1_epi32(1));
+	const __m256i round  = _mm256_srli_epi32(_mm256_add_epi32(
+		_mm256_add_epi32(u32_in, _mm256_set1_epi32(0x7FFF)), lsb), 16);
+	const __m256i quiet  = _mm256_or_si256(
+		_mm256_srli_epi32(u32_in, 16), _mm256_set1_epi32(0x0040));
+	const __m256i is_nan = _mm256_castps_si256(
+		_mm256_cmp_ps(clamped, clamped, _CMP_UNORD_Q));
+	const __m256i packed = _mm256_packus_epi32(
+		_mm256_blendv_epi8(round, quiet, is_nan), _mm256_setzero_si256());
+
+	/* packus interleaves 128-bit lanes, the permute restores order */
+	_mm_storeu_si128((__m128i *) dst, _mm256_castsi256_si128(
+		_mm256_permute4x64_epi64(packed, 0xD8)));
+}
+
+SDC_TARGET_AVX512
+static __m512 loadF64Avx512(const double *src)
+{
+	return _mm512_insertf32x8(_mm512_castps256_ps512(
+		_mm512_cvtpd_ps(_mm512_loadu_pd(src))),
+		_mm512_cvtpd_ps(_mm512_loadu_pd(src + 8)), 1);
+}
+
+SDC_TARGET_AVX512
+static __m512 loadF32Avx512(const float *src)
+{
+	return _mm512_loadu_ps(src);
+}
+
+SDC_TARGET_AVX512
+static __m512 loadHlfAvx512(const uint16_t *src)
+{
+	return _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i *) src));
+}
+
+SDC_TARGET_AVX512
+static __m512 loadBftAvx512(const uint16_t *src)
+{
+	return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(
+		_mm256_loadu_si256((const __m256i *) src)), 16));
+}
+
+/* vcvtqq2ps only yields eight lanes so two are stitched together */
+SDC_TARGET_AVX512
+static __m512 loadI64Avx512(const int64_t *src)
+{
+	return _mm512_insertf32x8(_mm512_castps256_ps512(
+		_mm512_cvtepi64_ps(_mm512_loadu_si512(src))), 
+		_mm512_cvtepi64_ps(_mm512_loadu_si512(src + 8)), 1);
+}
+
+SDC_TARGET_AVX512
+static __m512 loadI32Avx512(const int32_t *src)
+{
+	return _mm512_cvtepi32_ps(_mm512_loadu_si512(src));
+}
+
+SDC_TARGET_AVX512
+static __m512 loadI16Avx512(const int16_t *src)
+{
+	return _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(
+		_mm256_loadu_si256((const __m256i *) src)));
+}
+
+SDC_TARGET_AVX512
+static __m512 loadI8Avx512(const int8_t *src)
+{
+	return _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(
+		_mm_loadu_si128((const __m128i *) src)));
+}
+
+SDC_TARGET_AVX512
+static __m512 loadU8Avx512(const uint8_t *src)
+{
+	return _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(
+		_mm_loadu_si128((const __m128i *) src)));
+}
+
+SDC_TARGET_AVX512
+static void storeFltAvx512(float *dst, const __m512 x)
+{
+	_mm512_storeu_ps(dst, x);
+}
+
+SDC_TARGET_AVX512
+static void storeFltSatAvx512(float *dst, const __m512 x)
+{
+	_mm512_storeu_ps(dst, _mm512_max_ps(_mm512_set1_ps(-FLT_MAX),
+		_mm512_min_ps(_mm512_set1_ps(FLT_MAX), x)));
+}
+
+SDC_TARGET_AVX512
+static void storeHlfAvx512(uint16_t *dst, const __m512 x)
+{
+	const __m512 clamped = _mm512_max_ps(_mm512_set1_ps(-SDC_HLF_MAX),
+		_mm512_min_ps(_mm512_set1_ps(SDC_HLF_MAX), x));
+
+	_mm256_storeu_si256((__m256i *) dst, _mm512_cvtps_ph(clamped,
+		_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+
+SDC_TARGET_AVX512
+static void storeBftAvx512(uint16_t *dst, const __m512 x)
+{
+	const __m512 clamped = _mm512_max_ps(_mm512_set1_ps(-SDC_BFT_MAX),
+		_mm512_min_ps(_mm512_set1_ps(SDC_BFT_MAX), x));
+	const __m512i u32_in = _mm512_castps_si512(clamped);
+	const __m512i lsb    = _mm512_and_si512(
+		_mm512_srli_epi32(u32_in, 16), _mm512_set1_epi32(1));
+	const __m512i round  = _mm512_srli_epi32(_mm512_add_epi32(
+		_mm512_add_epi32(u32_in, _mm512_set1_epi32(0x7FFF)), lsb), 16);
+	const __m512i quiet  = _mm512_or_si512(
+		_mm512_srli_epi32(u32_in, 16), _mm512_set1_epi32(0x0040));
+
+	_mm256_storeu_si256((__m256i *) dst, _mm512_cvtepi32_epi16(
+		_mm512_mask_blend_epi32(_mm512_cmp_ps_mask(clamped, clamped,
+			_CMP_UNORD_Q),
+			round, quiet)));
+}
+
+/* Error accumulators, one lane each for the maxima and counts to be 
+ * reduced into the caller's sdcConvError at the end of a kernel. Lanes 
+ * mirror measureError, the masks keeping NaN and saturated lanes out of 
+ * the errors. Zero lanes never exceed the relative maximum scaled by their
+ * input so they are left out of it without a mask */
+typedef __m256  fltAvx2;
+typedef __m256d dblAvx2;
+
+struct errAccAvx2
+{
+	__m256d max_abs;
+	__m256d max_rel;
+	__m256i overflow;
+	__m256i underflow;
+	__m256i nan;
+};
+
+SDC_TARGET_AVX2
+static void errInitAvx2(struct errAccAvx2 *acc)
+{
+	acc->max_abs   = _mm256_setzero_pd();
+	acc->max_rel   = _mm256_setzero_pd();
+	acc->overflow  = _mm256_setzero_si256();
+	acc->underflow = _mm256_setzero_si256();
+	acc->nan       = _mm256_setzero_si256();
+}
+
+SDC_TARGET_AVX2
+static void errFlushAvx2(const struct errAccAvx2 *acc,
+	struct sdcConvError *err)
+{
+	double max_abs[4], max_rel[4];
+	uint64_t overflow[4], underflow[4], nan[4];
+	struct sdcConvError lane;
+	size_t i;
+
+	_mm256_storeu_pd(max_abs, acc->max_abs);
+	_mm256_storeu_pd(max_rel, acc->max_rel);
+	_mm256_storeu_si256((__m256i *) overflow, acc->overflow);
+	_mm256_storeu_si256((__m256i *) underflow, acc->underflow);
+	_mm256_storeu_si256((__m256i *) nan, acc->nan);
+
+	for (i = 0; i < 4; i++)
+	{
+		lane.max_abs   = max_abs[i];
+		lane.max_rel   = max_rel[i];
+		lane.overflow  = overflow[i];
+		lane.underflow = underflow[i];
+		lane.nan       = nan[i];
+		mergeConvError(err, &lane);
+	}
+}
+
+/* Compare masks are all ones, subtracting them counts a lane */
+SDC_TARGET_AVX2 SDC_ALWAYS_INLINE
+static void errAddAvx2(struct errAccAvx2 *acc, const __m256d x,
+	const __m256d y, const __m256d max)
+{
+	const __m256d sign    = _mm256_set1_pd(-0.0);
+	const __m256d zero    = _mm256_setzero_pd();
+	const __m256d abs_x   = _mm256_andnot_pd(sign, x);
+	const __m256d is_nan  = _mm256_cmp_pd(x, x, _CMP_UNORD_Q);
+	const __m256d is_over = _mm256_cmp_pd(abs_x, max, _CMP_GT_OQ);
+	const __m256d nonzero = _mm256_cmp_pd(x, zero, _CMP_NEQ_OQ);
+	const __m256d flushed = _mm256_and_pd(nonzero,
+		_mm256_cmp_pd(y, zero, _CMP_EQ_OQ));
+	const __m256d diff    = _mm256_andnot_pd(_mm256_or_pd(is_nan, is_over),
+		_mm256_andnot_pd(sign, _mm256_sub_pd(x, y)));
+	const __m256d grew    = _mm256_cmp_pd(diff,
+		_mm256_mul_pd(acc->max_rel, abs_x), _CMP_GT_OQ);
+
+	/* The division is only paid for once a lane's maximum grows */
+	if (_mm256_movemask_pd(grew) != 0)
+	{
+		acc->max_rel = _mm256_max_pd(acc->max_rel,
+			_mm256_and_pd(grew, _mm256_div_pd(diff, abs_x)));
+	}
+
+	acc->max_abs   = _mm256_max_pd(acc->max_abs, diff);
+	acc->overflow  = _mm256_sub_epi64(acc->overflow,
+		_mm256_castpd_si256(is_over));
+	acc->underflow = _mm256_sub_epi64(acc->underflow,
+		_mm256_castpd_si256(flushed));
+	acc->nan       = _mm256_sub_epi64(acc->nan,
+		_mm256_castpd_si256(is_nan));
+}
+
+SDC_TARGET_AVX2 SDC_ALWAYS_INLINE
+static void errPairAvx2(struct errAccAvx2 *acc, const __m256d lo,
+	const __m256d hi, const __m256 y, const double max)
+{
+	errAddAvx2(acc, lo, _mm256_cvtps_pd(_mm256_castps256_ps128(y)),
+		_mm256_set1_pd(max));
+	errAddAvx2(acc, hi, _mm256_cvtps_pd(_mm256_extractf128_ps(y, 1)),
+		_mm256_set1_pd(max));
+}
+
+/* Every float, half and 16-bit or narrower integer lane is already exact */
+SDC_TARGET_AVX2 SDC_ALWAYS_INLINE
+static void widenFltAvx2(const void *src, const __m256 x, __m256d *lo,
+	__m256d *hi)
+{
+	(void) src;
+	*lo = _mm256_cvtps_pd(_mm256_castps256_ps128(x));
+	*hi = _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1));
+}
+
+SDC_TARGET_AVX2 SDC_ALWAYS_INLINE
+static void widenF64Avx2(const double *src, const __m256 x, __m256d *lo,
+	__m256d *hi)
+{
+	(void) x;
+	*lo = _mm256_loadu_pd(src);
+	*hi = _mm256_loadu_pd(src + 4);
+}
+
+SDC_TARGET_AVX2 SDC_ALWAYS_INLINE
+static void widenI32Avx2(const int32_t *src, const __m256 x, __m256d *lo,
+	__m256d *hi)
+{
+	(void) x;
+	*lo = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *) src));
+	*hi = _mm256_cvtepi32_pd(_mm_loadu_si128(
+		(const __m128i *) (src + 4)));
+}
+
+SDC_TARGET_AVX2 SDC_ALWAYS_INLINE
+static void measureFltAvx2(struct errAccAvx2 *acc, const float *dst,
+	const __m256d lo, const __m256d hi)
+{
+	errPairAvx2(acc, lo, hi, loadF32Avx2(dst), FLT_MAX);
+}
+
+SDC_TARGET_AVX2 SDC_ALWAYS_INLINE
+static void measureHlfAvx2(struct errAccAvx2 *acc, const uint16_t *dst,
+	const __m256d lo, const __m256d hi)
+{
+	errPairAvx2(acc, lo, hi, loadHlfAvx2(dst), SDC_HLF_MAX);
+}
+
+SDC_TARGET_AVX2 SDC_ALWAYS_INLINE
+static void measureBftAvx2(struct errAccAvx2 *acc, const uint16_t *dst,
+	const __m256d lo, const __m256d hi)
+{
+	errPairAvx2(acc, lo, hi, loadBftAvx2(dst), SDC_BFT_MAX);
+}
+
+typedef __m512  fltAvx512;
+typedef __m512d dblAvx512;
+
+struct errAccAvx512
+{
+	__m512d max_abs;
+	__m512d max_rel;
+	__m512i overflow;
+	__m512i underflow;
+	__m512i nan;
+};
+
+SDC_TARGET_AVX512
+static void errInitAvx512(struct errAccAvx512 *acc)
+{
+	acc->max_abs   = _mm512_setzero_pd();
+	acc->max_rel   = _mm512_setzero_pd();
+	acc->overflow  = _mm512_setzero_si512();
+	acc->underflow = _mm512_setzero_si512();
+	acc->nan       = _mm512_setzero_si512();
+}
+
+SDC_TARGET_AVX512
+static void errFlushAvx512(const struct errAccAvx512 *acc,
+	struct sdcConvError *err)
+{
+	struct sdcConvError lanes;
+
+	lanes.max_abs   = _mm512_reduce_max_pd(acc->max_abs);
+	lanes.max_rel   = _mm512_reduce_max_pd(acc->max_rel);
+	lanes.overflow  = (uint64_t) _mm512_reduce_add_epi64(acc->overflow);
+	lanes.underflow = (uint64_t) _mm512_reduce_add_epi64(acc->underflow);
+	lanes.nan       = (uint64_t) _mm512_reduce_add_epi64(acc->nan);
+	mergeConvError(err, &lanes);
+}
+
+SDC_TARGET_AVX512 SDC_ALWAYS_INLINE
+static void errAddAvx512(struct errAccAvx512 *acc, const __m512d x,
+	const __m512d y, const __m512d max)
+{
+	const __m512d zero     = _mm512_setzero_pd();
+	const __m512i one      = _mm512_set1_epi64(1);
+	const __m512d abs_x    = _mm512_abs_pd(x);
+	const __mmask8 is_nan  = _mm512_cmp_pd_mask(x, x, _CMP_UNORD_Q);
+	const __mmask8 is_over = _mm512_cmp_pd_mask(abs_x, max, _CMP_GT_OQ);
+	const __mmask8 nonzero = _mm512_cmp_pd_mask(x, zero, _CMP_NEQ_OQ);
+	const __mmask8 flushed = _mm512_mask_cmp_pd_mask(nonzero, y, zero,
+		_CMP_EQ_OQ);
+	const __mmask8 valid   = (__mmask8) ~(is_nan | is_over);
+	const __m512d diff     = _mm512_mask_abs_pd(zero, valid,
+		_mm512_sub_pd(x, y));
+	const __mmask8 grew    = _mm512_cmp_pd_mask(diff,
+		_mm512_mul_pd(acc->max_rel, abs_x), _CMP_GT_OQ);
+
+	if (grew != 0)
+	{
+		acc->max_rel = _mm512_max_pd(acc->max_rel,
+			_mm512_maskz_div_pd(grew, diff, abs_x));
+	}
+
+	acc->max_abs   = _mm512_max_pd(acc->max_abs, diff);
+	acc->overflow  = _mm512_mask_add_epi64(acc->overflow, is_over,
+		acc->overflow, one);
+	acc->underflow = _mm512_mask_add_epi64(acc->underflow, flushed,
+		acc->underflow, one);
+	acc->nan       = _mm512_mask_add_epi64(acc->nan, is_nan, acc->nan, one);
+}
+
+SDC_TARGET_AVX512 SDC_ALWAYS_INLINE
+static void errPairAvx512(struct errAccAvx512 *acc, const __m512d lo,
+	const __m512d hi, const __m512 y, const double max)
+{
+	errAddAvx512(acc, lo, _mm512_cvtps_pd(_mm512_castps512_ps256(y)),
+		_mm512_set1_pd(max));
+	errAddAvx512(acc, hi, _mm512_cvtps_pd(_mm512_extractf32x8_ps(y, 1)),
+		_mm512_set1_pd(max));
+}
+
+SDC_TARGET_AVX512 SDC_ALWAYS_INLINE
+static void widenFltAvx512(const void *src, const __m512 x, __m512d *lo,
+	__m512d *hi)
+{
+	(void) src;
+	*lo = _mm512_cvtps_pd(_mm512_castps512_ps256(x));
+	*hi = _mm512_cvtps_pd(_mm512_extractf32x8_ps(x, 1));
+}
+
+SDC_TARGET_AVX512 SDC_ALWAYS_INLINE
+static void widenF64Avx512(const double *src, const __m512 x, __m512d *lo,
+	__m512d *hi)
+{
+	(void) x;
+	*lo = _mm512_loadu_pd(src);
+	*hi = _mm512_loadu_pd(src + 8);
+}
+
+SDC_TARGET_AVX512 SDC_ALWAYS_INLINE
+static void widenI64Avx512(const int64_t *src, const __m512 x, __m512d *lo,
+	__m512d *hi)
+{
+	(void) x;
+	*lo = _mm512_cvtepi64_pd(_mm512_loadu_si512(src));
+	*hi = _mm512_cvtepi64_pd(_mm512_loadu_si512(src + 8));
+}
+
+SDC_TARGET_AVX512 SDC_ALWAYS_INLINE
+static void widenI32Avx512(const int32_t *src, const __m512 x, __m512d *lo,
+	__m512d *hi)
+{
+	(void) x;
+	*lo = _mm512_cvtepi32_pd(_mm256_loadu_si256((const __m256i *) src));
+	*hi = _mm512_cvtepi32_pd(_mm256_loadu_si256(
+		(const __m256i *) (src + 8)));
+}
+
+SDC_TARGET_AVX512 SDC_ALWAYS_INLINE
+static void measureFltAvx512(struct errAccAvx512 *acc, const float *dst,
+	const __m512d lo, const __m512d hi)
+{
+	errPairAvx512(acc, lo, hi, loadF32Avx512(dst), FLT_MAX);
+}
+
+SDC_TARGET_AVX512 SDC_ALWAYS_INLINE
+static void measureHlfAvx512(struct errAccAvx512 *acc, const uint16_t *dst,
+	const __m512d lo, const __m512d hi)
+{
+	errPairAvx512(acc, lo, hi, loadHlfAvx512(dst), SDC_HLF_MAX);
+}
+
+SDC_TARGET_AVX512 SDC_ALWAYS_INLINE
+static void measureBftAvx512(struct errAccAvx512 *acc, const uint16_t *dst,
+	const __m512d lo, const __m512d hi)
+{
+	errPairAvx512(acc, lo, hi, loadBftAvx512(dst), SDC_BFT_MAX);
+}
+
+#define SDC_AVX2_KERNEL(func, in_type, load, widen, out_type, store,   \
+	measure, tail)                                                 \
+	SDC_SIMD_KERNEL(SDC_TARGET_AVX2, 8, Avx2, func, in_type, load, \
+		widen, out_type, store, measure, tail)
+#define SDC_AVX512_KERNEL(func, in_type, load, widen, out_type, store, \
+	measure, tail)                                                 \
+	SDC_SIMD_KERNEL(SDC_TARGET_AVX512, 16, Avx512, func, in_type,  \
+		load, widen, out_type, store, measure, tail)
+
+SDC_AVX2_KERNEL(doubleToFloatAvx2, double, loadF64Avx2, widenF64Avx2, float,
+	storeFltSatAvx2, measureFltAvx2, doubleToFloat)
+SDC_AVX2_KERNEL(doubleToHalfAvx2, double, loadF64Avx2, widenF64Avx2, uint16_t,
+	storeHlfAvx2, measureHlfAvx2, doubleToHalf)
+SDC_AVX2_KERNEL(doubleToBrainAvx2, double, loadF64Avx2, widenF64Avx2, uint16_t,
+	storeBftAvx2, measureBftAvx2, doubleToBrain)
+SDC_AVX2_KERNEL(floatToHalfAvx2, float, loadF32Avx2, widenFltAvx2, uint16_t,
+	storeHlfAvx2, measureHlfAvx2, floatToHalf)
+SDC_AVX2_KERNEL(floatToBrainAvx2, float, loadF32Avx2, widenFltAvx2, uint16_t,
+	storeBftAvx2, measureBftAvx2, floatToBrain)
+SDC_AVX2_KERNEL(halfToBrainAvx2, uint16_t, loadHlfAvx2, widenFltAvx2, uint16_t,
+	storeBftAvx2, measureBftAvx2, halfToBrain)
+SDC_AVX2_KERNEL(brainToHalfAvx2, uint16_t, loadBftAvx2, widenFltAvx2, uint16_t,
+	storeHlfAvx2, measureHlfAvx2, brainToHalf)
+SDC_AVX2_KERNEL(signed32ToFloatAvx2, int32_t, loadI32Avx2, widenI32Avx2, float,
+	storeFltAvx2, measureFltAvx2, signed32ToFloat)
+SDC_AVX2_KERNEL(signed32ToHalfAvx2, int32_t, loadI32Avx2, widenI32Avx2,
+	uint16_t, storeHlfAvx2, measureHlfAvx2, signed32ToHalf)
+SDC_AVX2_KERNEL(signed32ToBrainAvx2, int32_t, loadI32Avx2, widenI32Avx2,
+	uint16_t, storeBftAvx2, measureBftAvx2, signed32ToBrain)
+SDC_AVX2_KERNEL(signed16ToFloatAvx2, int16_t, loadI16Avx2, widenFltAvx2, float,
+	storeFltAvx2, measureFltAvx2, signed16ToFloat)
+SDC_AVX2_KERNEL(signed16ToHalfAvx2, int16_t, loadI16Avx2, widenFltAvx2,
+	uint16_t, storeHlfAvx2, measureHlfAvx2, signed16ToHalf)
+SDC_AVX2_KERNEL(signed16ToBrainAvx2, int16_t, loadI16Avx2, widenFltAvx2,
+	uint16_t, storeBftAvx2, measureBftAvx2, signed16ToBrain)
+SDC_AVX2_KERNEL(signed8ToFloatAvx2, int8_t, loadI8Avx2, widenFltAvx2, float,
+	storeFltAvx2, measureFltAvx2, signed8ToFloat)
+SDC_AVX2_KERNEL(signed8ToHalfAvx2, int8_t, loadI8Avx2, widenFltAvx2, uint16_t,
+	storeHlfAvx2, measureHlfAvx2, signed8ToHalf)
+SDC_AVX2_KERNEL(signed8ToBrainAvx2, int8_t, loadI8Avx2, widenFltAvx2, uint16_t,
+	storeBftAvx2, measureBftAvx2, signed8ToBrain)
+SDC_AVX2_KERNEL(unsigned8ToFloatAvx2, uint8_t, loadU8Avx2, widenFltAvx2, float,
+	storeFltAvx2, measureFltAvx2, unsigned8ToFloat)
+SDC_AVX2_KERNEL(unsigned8ToHalfAvx2, uint8_t, loadU8Avx2, widenFltAvx2,
+	uint16_t, storeHlfAvx2, measureHlfAvx2, unsigned8ToHalf)
+SDC_AVX2_KERNEL(unsigned8ToBrainAvx2, uint8_t, loadU8Avx2, widenFltAvx2,
+	uint16_t, storeBftAvx2, measureBftAvx2, unsigned8ToBrain)
+
+SDC_AVX512_KERNEL(doubleToFloatAvx512, double, loadF64Avx512, widenF64Avx512,
+	float, storeFltSatAvx512, measureFltAvx512, doubleToFloat)
+SDC_AVX512_KERNEL(doubleToHalfAvx512, double, loadF64Avx512, widenF64Avx512,
+	uint16_t, storeHlfAvx512, measureHlfAvx512, doubleToHalf)
+SDC_AVX512_KERNEL(doubleToBrainAvx512, double, loadF64Avx512, widenF64Avx512,
+	uint16_t, storeBftAvx512, measureBftAvx512, doubleToBrain)
+SDC_AVX512_KERNEL(floatToHalfAvx512, float, loadF32Avx512, widenFltAvx512,
+	uint16_t, storeHlfAvx512, measureHlfAvx512, floatToHalf)
+SDC_AVX512_KERNEL(floatToBrainAvx512, float, loadF32Avx512, widenFltAvx512,
+	uint16_t, storeBftAvx512, measureBftAvx512, floatToBrain)
+SDC_AVX512_KERNEL(halfToBrainAvx512, uint16_t, loadHlfAvx512, widenFltAvx512,
+	uint16_t, storeBftAvx512, measureBftAvx512, halfToBrain)
+SDC_AVX512_KERNEL(brainToHalfAvx512, uint16_t, loadBftAvx512, widenFltAvx512,
+	uint16_t, storeHlfAvx512, measureHlfAvx512, brainToHalf)
+SDC_AVX512_KERNEL(signed64ToFloatAvx512, int64_t, loadI64Avx512,
+	widenI64Avx512, float, storeFltAvx512, measureFltAvx512,
+	signed64ToFloat)
+SDC_AVX512_KERNEL(signed64ToHalfAvx512, int64_t, loadI64Avx512, widenI64Avx512,
+	uint16_t, storeHlfAvx512, measureHlfAvx512, signed64ToHalf)
+SDC_AVX512_KERNEL(signed64ToBrainAvx512, int64_t, loadI64Avx512,
+	widenI64Avx512, uint16_t, storeBftAvx512, measureBftAvx512,
+	signed64ToBrain)
+SDC_AVX512_KERNEL(signed32ToFloatAvx512, int32_t, loadI32Avx512,
+	widenI32Avx512, float, storeFltAvx512, measureFltAvx512,
+	signed32ToFloat)
+SDC_AVX512_KERNEL(signed32ToHalfAvx512, int32_t, loadI32Avx512, widenI32Avx512,
+	uint16_t, storeHlfAvx512, measureHlfAvx512, signed32ToHalf)
+SDC_AVX512_KERNEL(signed32ToBrainAvx512, int32_t, loadI32Avx512,
+	widenI32Avx512, uint16_t, storeBftAvx512, measureBftAvx512,
+	signed32ToBrain)
+SDC_AVX512_KERNEL(signed16ToFloatAvx512, int16_t, loadI16Avx512,
+	widenFltAvx512, float, storeFltAvx512, measureFltAvx512,
+	signed16ToFloat)
+SDC_AVX512_KERNEL(signed16ToHalfAvx512, int16_t, loadI16Avx512, widenFltAvx512,
+	uint16_t, storeHlfAvx512, measureHlfAvx512, signed16ToHalf)
+SDC_AVX512_KERNEL(signed16ToBrainAvx512, int16_t, loadI16Avx512,
+	widenFltAvx512, uint16_t, storeBftAvx512, measureBftAvx512,
+	signed16ToBrain)
+SDC_AVX512_KERNEL(signed8ToFloatAvx512, int8_t, loadI8Avx512, widenFltAvx512,
+	float, storeFltAvx512, measureFltAvx512, signed8ToFloat)
+SDC_AVX512_KERNEL(signed8ToHalfAvx512, int8_t, loadI8Avx512, widenFltAvx512,
+	uint16_t, storeHlfAvx512, measureHlfAvx512, signed8ToHalf)
+SDC_AVX512_KERNEL(signed8ToBrainAvx512, int8_t, loadI8Avx512, widenFltAvx512,
+	uint16_t, storeBftAvx512, measureBftAvx512, signed8ToBrain)
+SDC_AVX512_KERNEL(unsigned8ToFloatAvx512, uint8_t, loadU8Avx512,
+	widenFltAvx512, float, storeFltAvx512, measureFltAvx512,
+	unsigned8ToFloat)
+SDC_AVX512_KERNEL(unsigned8ToHalfAvx512, uint8_t, loadU8Avx512, widenFltAvx512,
+	uint16_t, storeHlfAvx512, measureHlfAvx512, unsigned8ToHalf)
+SDC_AVX512_KERNEL(unsigned8ToBrainAvx512, uint8_t, loadU8Avx512,
+	widenFltAvx512, uint16_t, storeBftAvx512, measureBftAvx512,
+	unsigned8ToBrain)
+
+/* Integer narrowing saturates as it stores, lanes outside of the target's
+ * range being those that overflow */
+#define SDC_NARROW_AVX512(func, out_type, store, min, max, tail)      \
+SDC_TARGET_AVX512                                                      \
+static void func(const void *in, void *out, const size_t len,          \
+	struct sdcConvError *err)                                      \
+{                                                                      \
+	const int64_t *src    = in;                                    \
+	out_type *dst         = out;                                   \
+	const __m512i nk_min  = _mm512_set1_epi64(min);                \
+	const __m512i nk_max  = _mm512_set1_epi64(max);                \
+	uint64_t nk_over      = 0;                                     \
+	size_t nk_i;                                                   \
+	                                                               \
+	for (nk_i = 0; nk_i + 8 <= len; nk_i += 8)                     \
+	{                                                              \
+		const __m512i nk_x = _mm512_loadu_si512(src + nk_i);   \
+		                                                       \
+		store(dst + nk_i, (__mmask8) 0xFF, nk_x);              \
+		nk_over += (uint64_t) __builtin_popcount(              \
+			_mm512_cmpgt_epi64_mask(nk_x, nk_max)          \
+			| _mm512_cmplt_epi64_mask(nk_x, nk_min));      \
+	}                                                              \
+	                                                               \
+	if (err != NULL)                                               \
+	{                                                              \
+		err->overflow += nk_over;                              \
+	}                                                              \
+	                                                               \
+	tail(src + nk_i, dst + nk_i, len - nk_i, err);                 \
+}
+
+SDC_NARROW_AVX512(signed64ToSigned32Avx512, int32_t,
+	_mm512_mask_cvtsepi64_storeu_epi32, INT32_MIN, INT32_MAX,
+	signed64ToSigned32)
+SDC_NARROW_AVX512(signed64ToSigned16Avx512, int16_t,
+	_mm512_mask_cvtsepi64_storeu_epi16, INT16_MIN, INT16_MAX,
+	signed64ToSigned16)
+SDC_NARROW_AVX512(signed64ToSigned8Avx512, int8_t,
+	_mm512_mask_cvtsepi64_storeu_epi8, INT8_MIN, INT8_MAX,
+	signed64ToSigned8)
+
+/* The scans keep the range in lanes and count with mask population counts.
+ * The brain float check truncates rather than rounds, either gives back x
+ * only when its low 16 bits are clear. Clamping first sends infinities, 
+ * which saturate when converted, to a finite value they do not equal */
+SDC_TARGET_AVX2
+static __m256 clampAvx2(const __m256 x, const float max)
+{
+	return _mm256_max_ps(_mm256_set1_ps(-max),
+		_mm256_min_ps(_mm256_set1_ps(max), x));
+}
+
+SDC_TARGET_AVX2
+static __m128 dblToFltSatAvx2(const __m256d x)
+{
+	return _mm256_cvtpd_ps(_mm256_max_pd(_mm256_set1_pd(-FLT_MAX),
+		_mm256_min_pd(_mm256_set1_pd(FLT_MAX), x)));
+}
+
+SDC_TARGET_AVX2
+static __m256 roundTripHlfAvx2(const __m256 x)
+{
+	return _mm256_cvtph_ps(_mm256_cvtps_ph(clampAvx2(x, SDC_HLF_MAX),
+		_MM_FROUND_TO_NEAREST_INT));
+}
+
+SDC_TARGET_AVX2
+static __m256 truncBftAvx2(const __m256 x)
+{
+	return _mm256_castsi256_ps(_mm256_and_si256(_mm256_castps_si256(
+		clampAvx2(x, SDC_BFT_MAX)), _mm256_set1_epi32(
+		(int) 0xFFFF0000)));
+}
+
+/* Lanes of v equal to the matching double lanes of lo and hi */
+SDC_TARGET_AVX2
+static uint64_t countEqualAvx2(const __m256 v, const __m256d lo,
+	const __m256d hi)
+{
+	return (uint64_t) (__builtin_popcount(_mm256_movemask_pd(
+		_mm256_cmp_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)), lo,
+		_CMP_EQ_OQ))) + __builtin_popcount(_mm256_movemask_pd(
+		_mm256_cmp_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)),
+		hi, _CMP_EQ_OQ))));
+}
+
+SDC_TARGET_AVX2
+static void flushRangeAvx2(struct sdcRange *range, const __m256d min,
+	const __m256d max, const __m256d abs_min)
+{
+	double lanes_min[4], lanes_max[4], lanes_abs[4];
+	size_t i;
+
+	_mm256_storeu_pd(lanes_min, min);
+	_mm256_storeu_pd(lanes_max, max);
+	_mm256_storeu_pd(lanes_abs, abs_min);
+
+	for (i = 0; i < 4; i++)
+	{
+		mergeRange(range, lanes_min[i], lanes_max[i], lanes_abs[i]);
+	}
+}
+
+/* Zero lanes are made infinite to keep them out of the smallest magnitude,
+ * the min/max operand order again lets NaN lanes through untouched */
+SDC_TARGET_AVX2
+static void rangeAvx2(const __m256d x, __m256d *min, __m256d *max,
+	__m256d *abs_min)
+{
+	const __m256d abs_x = _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+
+	*min     = _mm256_min_pd(x, *min);
+	*max     = _mm256_max_pd(x, *max);
+	*abs_min = _mm256_min_pd(_mm256_blendv_pd(abs_x,
+		_mm256_set1_pd(HUGE_VAL), _mm256_cmp_pd(abs_x,
+		_mm256_setzero_pd(), _CMP_EQ_OQ)), *abs_min);
+}
+
+SDC_TARGET_AVX2
+static void scanDoubleAvx2(const void *in, const size_t len,
+	struct sdcRange *range)
+{
+	const double *src = in;
+	__m256d min     = _mm256_set1_pd(HUGE_VAL);
+	__m256d max     = _mm256_set1_pd(-HUGE_VAL);
+	__m256d abs_min = _mm256_set1_pd(HUGE_VAL);
+	uint64_t nan = 0, flt_ok = 0, hlf_ok = 0, bft_ok = 0;
+	size_t i;
+
+	for (i = 0; i + 8 <= len; i += 8)
+	{
+		const __m256d lo = _mm256_loadu_pd(src + i);
+		const __m256d hi = _mm256_loadu_pd(src + i + 4);
+		const __m256 f   = _mm256_set_m128(dblToFltSatAvx2(hi),
+			dblToFltSatAvx2(lo));
+
+		rangeAvx2(lo, &min, &max, &abs_min);
+		rangeAvx2(hi, &min, &max, &abs_min);
+		nan    += (uint64_t) __builtin_popcount(_mm256_movemask_pd(
+			_mm256_cmp_pd(lo, lo, _CMP_UNORD_Q))
+			| (_mm256_movemask_pd(_mm256_cmp_pd(hi, hi,
+			_CMP_UNORD_Q)) << 4));
+		flt_ok += countEqualAvx2(f, lo, hi);
+		hlf_ok += countEqualAvx2(roundTripHlfAvx2(f), lo, hi);
+		bft_ok += countEqualAvx2(truncBftAvx2(f), lo, hi);
+	}
+
+	flushRangeAvx2(range, min, max, abs_min);
+	range->nan                += nan;
+	range->inexact[FLOAT_32]  += i - nan - flt_ok;
+	range->inexact[FLOAT_16]  += i - nan - hlf_ok;
+	range->inexact[BFLOAT_16] += i - nan - bft_ok;
+	scanDouble(src + i, len - i, range);
+}
+
+SDC_TARGET_AVX2
+static void scanFloatAvx2(const void *in, const size_t len,
+	struct sdcRange *range)
+{
+	const float *src = in;
+	__m256d min     = _mm256_set1_pd(HUGE_VAL);
+	__m256d max     = _mm256_set1_pd(-HUGE_VAL);
+	__m256d abs_min = _mm256_set1_pd(HUGE_VAL);
+	uint64_t nan = 0, hlf_ok = 0, bft_ok = 0;
+	size_t i;
+
+	for (i = 0; i + 8 <= len; i += 8)
+	{
+		const __m256 x = _mm256_loadu_ps(src + i);
+
+		rangeAvx2(_mm256_cvtps_pd(_mm256_castps256_ps128(x)), &min,
+			&max, &abs_min);
+		rangeAvx2(_mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)), &min,
+			&max, &abs_min);
+		nan    += (uint64_t) __builtin_popcount(_mm256_movemask_ps(
+			_mm256_cmp_ps(x, x, _CMP_UNORD_Q)));
+		hlf_ok += (uint64_t) __builtin_popcount(_mm256_movemask_ps(
+			_mm256_cmp_ps(roundTripHlfAvx2(x), x, _CMP_EQ_OQ)));
+		bft_ok += (uint64_t) __builtin_popcount(_mm256_movemask_ps(
+			_mm256_cmp_ps(truncBftAvx2(x), x, _CMP_EQ_OQ)));
+	}
+
+	flushRangeAvx2(range, min, max, abs_min);
+	range->nan                += nan;
+	range->inexact[FLOAT_16]  += i - nan - hlf_ok;
+	range->inexact[BFLOAT_16] += i - nan - bft_ok;
+	scanFloat(src + i, len - i, range);
+}
+
+SDC_TARGET_AVX512
+static __m512 clampAvx512(const __m512 x, const float max)
+{
+	return _mm512_max_ps(_mm512_set1_ps(-max),
+		_mm512_min_ps(_mm512_set1_ps(max), x));
+}
+
+SDC_TARGET_AVX512
+static __m256 dblToFltSatAvx512(const __m512d x)
+{
+	return _mm512_cvtpd_ps(_mm512_max_pd(_mm512_set1_pd(-FLT_MAX),
+		_mm512_min_pd(_mm512_set1_pd(FLT_MAX), x)));
+}
+
+SDC_TARGET_AVX512
+static __m512 roundTripHlfAvx512(const __m512 x)
+{
+	return _mm512_cvtph_ps(_mm512_cvtps_ph(clampAvx512(x, SDC_HLF_MAX),
+		_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+
+SDC_TARGET_AVX512
+static __m512 truncBftAvx512(const __m512 x)
+{
+	return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(
+		clampAvx512(x, SDC_BFT_MAX)), _mm512_set1_epi32(
+		(int) 0xFFFF0000)));
+}
+
+SDC_TARGET_AVX512
+static uint64_t countEqualAvx512(const __m512 v, const __m512d lo,
+	const __m512d hi)
+{
+	return (uint64_t) __builtin_popcount(_mm512_cmp_pd_mask(
+		_mm512_cvtps_pd(_mm512_castps512_ps256(v)), lo, _CMP_EQ_OQ)
+		| (_mm512_cmp_pd_mask(_mm512_cvtps_pd(
+		_mm512_extractf32x8_ps(v, 1)), hi, _CMP_EQ_OQ) << 8));
+}
+
+SDC_TARGET_AVX512
+static void rangeAvx512(const __m512d x, __m512d *min, __m512d *max,
+	__m512d *abs_min)
+{
+	const __m512d abs_x = _mm512_abs_pd(x);
+
+	*min     = _mm512_min_pd(x, *min);
+	*max     = _mm512_max_pd(x, *max);
+	*abs_min = _mm512_min_pd(_mm512_mask_blend_pd(_mm512_cmp_pd_mask(
+		abs_x, _mm512_setzero_pd(), _CMP_EQ_OQ), abs_x,
+		_mm512_set1_pd(HUGE_VAL)), *abs_min);
+}
+
+SDC_TARGET_AVX512
+static void flushRangeAvx512(struct sdcRange *range, const __m512d min,
+	const __m512d max, const __m512d abs_min)
+{
+	mergeRange(range, _mm512_reduce_min_pd(min),
+		_mm512_reduce_max_pd(max), _mm512_reduce_min_pd(abs_min));
+}
+
+SDC_TARGET_AVX512
+static void scanDoubleAvx512(const void *in, const size_t len,
+	struct sdcRange *range)
+{
+	const double *src = in;
+	__m512d min     = _mm512_set1_pd(HUGE_VAL);
+	__m512d max     = _mm512_set1_pd(-HUGE_VAL);
+	__m512d abs_min = _mm512_set1_pd(HUGE_VAL);
+	uint64_t nan = 0, flt_ok = 0, hlf_ok = 0, bft_ok = 0;
+	size_t i;
+
+	for (i = 0; i + 16 <= len; i += 16)
+	{
+		const __m512d lo = _mm512_loadu_pd(src + i);
+		const __m512d hi = _mm512_loadu_pd(src + i + 8);
+		const __m512 f   = _mm512_insertf32x8(_mm512_castps256_ps512(
+			dblToFltSatAvx512(lo)), dblToFltSatAvx512(hi), 1);
+
+		rangeAvx512(lo, &min, &max, &abs_min);
+		rangeAvx512(hi, &min, &max, &abs_min);
+		nan    += (uint64_t) __builtin_popcount(_mm512_cmp_pd_mask(lo,
+			lo, _CMP_UNORD_Q) | (_mm512_cmp_pd_mask(hi, hi,
+			_CMP_UNORD_Q) << 8));
+		flt_ok += countEqualAvx512(f, lo, hi);
+		hlf_ok += countEqualAvx512(roundTripHlfAvx512(f), lo, hi);
+		bft_ok += countEqualAvx512(truncBftAvx512(f), lo, hi);
+	}
+
+	flushRangeAvx512(range, min, max, abs_min);
+	range->nan                += nan;
+	range->inexact[FLOAT_32]  += i - nan - flt_ok;
+	range->inexact[FLOAT_16]  += i - nan - hlf_ok;
+	range->inexact[BFLOAT_16] += i - nan - bft_ok;
+	scanDouble(src + i, len - i, range);
+}
+
+SDC_TARGET_AVX512
+static void scanFloatAvx512(const void *in, const size_t len,
+	struct sdcRange *range)
+{
+	const float *src = in;
+	__m512d min     = _mm512_set1_pd(HUGE_VAL);
+	__m512d max     = _mm512_set1_pd(-HUGE_VAL);
+	__m512d abs_min = _mm512_set1_pd(HUGE_VAL);
+	uint64_t nan = 0, hlf_ok = 0, bft_ok = 0;
+	size_t i;
+
+	for (i = 0; i + 16 <= len; i += 16)
+	{
+		const __m512 x = _mm512_loadu_ps(src + i);
+
+		rangeAvx512(_mm512_cvtps_pd(_mm512_castps512_ps256(x)), &min,
+			&max, &abs_min);
+		rangeAvx512(_mm512_cvtps_pd(_mm512_extractf32x8_ps(x, 1)),
+			&min, &max, &abs_min);
+		nan    += (uint64_t) __builtin_popcount(_mm512_cmp_ps_mask(x,
+			x, _CMP_UNORD_Q));
+		hlf_ok += (uint64_t) __builtin_popcount(_mm512_cmp_ps_mask(
+			roundTripHlfAvx512(x), x, _CMP_EQ_OQ));
+		bft_ok += (uint64_t) __builtin_popcount(_mm512_cmp_ps_mask(
+			truncBftAvx512(x), x, _CMP_EQ_OQ));
+	}
+
+	flushRangeAvx512(range, min, max, abs_min);
+	range->nan                += nan;
+	range->inexact[FLOAT_16]  += i - nan - hlf_ok;
+	range->inexact[BFLOAT_16] += i - nan - bft_ok;
+	scanFloat(src + i, len - i, range);
+}
+
+/* Magnitudes are compared unsigned so that INT64_MIN's fits, zero lanes 
+ * are masked out and all ones stands in for none found */
+SDC_TARGET_AVX512
+static void scanSigned64Avx512(const void *in, const size_t len,
+	struct sdcRange *range)
+{
+	const int64_t *src = in;
+	__m512i min     = _mm512_set1_epi64(INT64_MAX);
+	__m512i max     = _mm512_set1_epi64(INT64_MIN);
+	__m512i abs_min = _mm512_set1_epi64(-1);
+	uint64_t abs_lane;
+	size_t i;
+
+	for (i = 0; i + 8 <= len; i += 8)
+	{
+		const __m512i x = _mm512_loadu_si512(src + i);
+
+		min     = _mm512_min_epi64(x, min);
+		max     = _mm512_max_epi64(x, max);
+		abs_min = _mm512_mask_min_epu64(abs_min, _mm512_test_epi64_mask(
+			x, x), _mm512_abs_epi64(x), abs_min);
+	}
+
+	if (i > 0)
+	{
+		abs_lane = _mm512_reduce_min_epu64(abs_min);
+		mergeRange(range, (double) _mm512_reduce_min_epi64(min),
+			(double) _mm512_reduce_max_epi64(max),
+			(abs_lane == UINT64_MAX) ? HUGE_VAL
+			: (double) abs_lane);
+	}
+
+	scanSigned64(src + i, len - i, range);
+}
+
+#define SDC_WIDEN_AVX2(func, in_type, load, tail)                     \
+SDC_TARGET_AVX2                                                        \
+static void func(const void *in, double *out, const size_t len)        \
+{                                                                      \
+	const in_type *src = in;                                       \
+	size_t wk_i;                                                   \
+	                                                               \
+	for (wk_i = 0; wk_i + 4 <= len; wk_i += 4)                     \
+	{                                                              \
+		_mm256_storeu_pd(out + wk_i, load(src + wk_i));        \
+	}                                                              \
+	                                                               \
+	tail(src + wk_i, out + wk_i, len - wk_i);                      \
+}
+
+/* Four lanes of each, the narrow loads taking no more than that */
+SDC_TARGET_AVX2
+static __m256d wideF32Avx2(const float *src)
+{
+	return _mm256_cvtps_pd(_mm_loadu_ps(src));
+}
+
+SDC_TARGET_AVX2
+static __m256d wideHlfAvx2(const uint16_t *src)
+{
+	return _mm256_cvtps_pd(_mm_cvtph_ps(_mm_loadl_epi64(
+		(const __m128i *) src)));
+}
+
+SDC_TARGET_AVX2
+static __m256d wideBftAvx2(const uint16_t *src)
+{
+	return _mm256_cvtps_pd(_mm_castsi128_ps(_mm_slli_epi32(
+		_mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *) src)),
+		16)));
+}
+
+SDC_TARGET_AVX2
+static __m256d wideI32Avx2(const int32_t *src)
+{
+	return _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *) src));
+}
+
+SDC_TARGET_AVX2
+static __m256d wideI16Avx2(const int16_t *src)
+{
+	return _mm256_cvtepi32_pd(_mm_cvtepi16_epi32(_mm_loadl_epi64(
+		(const __m128i *) src)));
+}
+
+SDC_TARGET_AVX2
+static __m256d wideI8Avx2(const int8_t *src)
+{
+	int32_t four;
+
+	memcpy(&four, src, sizeof(four));
+
+	return _mm256_cvtepi32_pd(_mm_cvtepi8_epi32(_mm_cvtsi32_si128(four)));
+}
+
+SDC_TARGET_AVX2
+static __m256d wideU8Avx2(const uint8_t *src)
+{
+	int32_t four;
+
+	memcpy(&four, src, sizeof(four));
+
+	return _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(four)));
+}
+
+SDC_WIDEN_AVX2(widenFloatAvx2, float, wideF32Avx2, widenFloat)
+SDC_WIDEN_AVX2(widenHalfAvx2, uint16_t, wideHlfAvx2, widenHalf)
+SDC_WIDEN_AVX2(widenBrainAvx2, uint16_t, wideBftAvx2, widenBrain)
+SDC_WIDEN_AVX2(widenSigned32Avx2, int32_t, wideI32Avx2, widenSigned32)
+SDC_WIDEN_AVX2(widenSigned16Avx2, int16_t, wideI16Avx2, widenSigned16)
+SDC_WIDEN_AVX2(widenSigned8Avx2, int8_t, wideI8Avx2, widenSigned8)
+SDC_WIDEN_AVX2(widenUnsigned8Avx2, uint8_t, wideU8Avx2, widenUnsigned8)
+
+/* I64 needs AVX-512DQ, rounding as the scalar cast does */
+SDC_TARGET_AVX512
+static void widenSigned64Avx512(const void *in, double *out,
+	const size_t len)
+{
+	const int64_t *src = in;
+	size_t i;
+
+	for (i = 0; i + 8 <= len; i += 8)
+	{
+		_mm512_storeu_pd(out + i, _mm512_cvtepi64_pd(
+			_mm512_loadu_si512(src + i)));
+	}
+
+	widenSigned64(src + i, out + i, len - i);
+}
+
+/* As compareValue lane-wise, NaN lanes of x surviving the clamp by coming
+ * second. A NaN diff fails every ordered compare so is a violation unless
+ * both sides are NaN, and is dropped from the maxima by coming first */
+SDC_TARGET_AVX2
+static void compareDoublesAvx2(const double *x, const double *y,
+	const size_t len, const struct sdcTolerance *tol,
+	struct sdcCompare *cmp)
+{
+	const __m256d sign = _mm256_set1_pd(-0.0);
+	const __m256d zero = _mm256_setzero_pd();
+	const __m256d lo   = _mm256_set1_pd(tol->lo);
+	const __m256d hi   = _mm256_set1_pd(tol->hi);
+	const __m256d rel_tol = _mm256_set1_pd(tol->rel);
+	const __m256d abs_tol = _mm256_set1_pd(tol->abs);
+	__m256d max_abs    = _mm256_setzero_pd();
+	__m256d max_rel    = _mm256_setzero_pd();
+	double lanes_abs[4], lanes_rel[4];
+	uint64_t violations = 0, saturated = 0;
+	size_t i, j;
+
+	for (i = 0; i + 4 <= len; i += 4)
+	{
+		const __m256d vx     = _mm256_loadu_pd(x + i);
+		const __m256d vy     = _mm256_loadu_pd(y + i);
+		const __m256d xc     = _mm256_max_pd(lo, _mm256_min_pd(hi, vx));
+		const __m256d abs_xc = _mm256_andnot_pd(sign, xc);
+		const __m256d same   = _mm256_cmp_pd(vx, vy, _CMP_EQ_OQ);
+		const __m256d diff   = _mm256_andnot_pd(_mm256_or_pd(sign,
+			same), _mm256_sub_pd(vy, xc));
+		const __m256d ok     = _mm256_or_pd(_mm256_or_pd(
+			_mm256_cmp_pd(diff, abs_tol, _CMP_LE_OQ),
+			_mm256_cmp_pd(diff, _mm256_mul_pd(rel_tol, abs_xc),
+			_CMP_LE_OQ)), _mm256_and_pd(_mm256_cmp_pd(vx, vx,
+			_CMP_UNORD_Q), _mm256_cmp_pd(vy, vy, _CMP_UNORD_Q)));
+		const __m256d grew   = _mm256_and_pd(_mm256_cmp_pd(diff,
+			_mm256_mul_pd(max_rel, abs_xc), _CMP_GT_OQ),
+			_mm256_cmp_pd(abs_xc, zero, _CMP_NEQ_OQ));
+
+		if (_mm256_movemask_pd(grew) != 0)
+		{
+			max_rel = _mm256_max_pd(max_rel, _mm256_and_pd(grew,
+				_mm256_div_pd(diff, abs_xc)));
+		}
+
+		max_abs     = _mm256_max_pd(diff, max_abs);
+		violations += (uint64_t) __builtin_popcount(
+			~_mm256_movemask_pd(ok) & 0xF);
+		saturated  += (uint64_t) __builtin_popcount(_mm256_movemask_pd(
+			_mm256_andnot_pd(same, _mm256_and_pd(_mm256_cmp_pd(vy,
+			vy, _CMP_ORD_Q), _mm256_cmp_pd(vx, xc,
+			_CMP_NEQ_OQ)))));
+	}
+
+	_mm256_storeu_pd(lanes_abs, max_abs);
+	_mm256_storeu_pd(lanes_rel, max_rel);
+
+	for (j = 0; j < 4; j++)
+	{
+		cmp->max_abs = (lanes_abs[j] > cmp->max_abs)
+			? lanes_abs[j] : cmp->max_abs;
+		cmp->max_rel = (lanes_rel[j] > cmp->max_rel)
+			? lanes_rel[j] : cmp->max_rel;
+	}
+
+	cmp->violations += violations;
+	cmp->saturated  += saturated;
+	compareDoubles(x + i, y + i, len - i, tol, cmp);
+}
+
+SDC_TARGET_AVX512
+static void compareDoublesAvx512(const double *x, const double *y,
+	const size_t len, const struct sdcTolerance *tol,
+	struct sdcCompare *cmp)
+{
+	const __m512d zero = _mm512_setzero_pd();
+	const __m512d lo   = _mm512_set1_pd(tol->lo);
+	const __m512d hi   = _mm512_set1_pd(tol->hi);
+	const __m512d rel_tol = _mm512_set1_pd(tol->rel);
+	const __m512d abs_tol = _mm512_set1_pd(tol->abs);
+	__m512d max_abs    = _mm512_setzero_pd();
+	__m512d max_rel    = _mm512_setzero_pd();
+	uint64_t violations = 0, saturated = 0;
+	double lane;
+	size_t i;
+
+	for (i = 0; i + 8 <= len; i += 8)
+	{
+		const __m512d vx     = _mm512_loadu_pd(x + i);
+		const __m512d vy     = _mm512_loadu_pd(y + i);
+		const __m512d xc     = _mm512_max_pd(lo, _mm512_min_pd(hi, vx));
+		const __m512d abs_xc = _mm512_abs_pd(xc);
+		const __mmask8 same  = _mm512_cmp_pd_mask(vx, vy, _CMP_EQ_OQ);
+		const __m512d diff   = _mm512_mask_abs_pd(zero,
+			(__mmask8) ~same, _mm512_sub_pd(vy, xc));
+		const __mmask8 ok    = _mm512_cmp_pd_mask(diff, abs_tol,
+			_CMP_LE_OQ) | _mm512_cmp_pd_mask(diff, _mm512_mul_pd(
+			rel_tol, abs_xc),
+			_CMP_LE_OQ) | (_mm512_cmp_pd_mask(vx, vx, _CMP_UNORD_Q)
+			& _mm512_cmp_pd_mask(vy, vy, _CMP_UNORD_Q));
+		const __mmask8 grew  = _mm512_mask_cmp_pd_mask(
+			_mm512_cmp_pd_mask(abs_xc, zero, _CMP_NEQ_OQ), diff,
+			_mm512_mul_pd(max_rel, abs_xc), _CMP_GT_OQ);
+
+		if (grew != 0)
+		{
+			max_rel = _mm512_mask_max_pd(max_rel, grew, max_rel,
+				_mm512_div_pd(diff, abs_xc));
+		}
+
+		max_abs     = _mm512_max_pd(diff, max_abs);
+		violations += (uint64_t) __builtin_popcount((__mmask8) ~ok);
+		saturated  += (uint64_t) __builtin_popcount(
+			_mm512_mask_cmp_pd_mask((__mmask8) ~same
+			& _mm512_cmp_pd_mask(vy, vy, _CMP_ORD_Q), vx, xc,
+			_CMP_NEQ_OQ));
+	}
+
+	lane = _mm512_reduce_max_pd(max_abs);
+	cmp->max_abs = (lane > cmp->max_abs) ? lane : cmp->max_abs;
+	lane = _mm512_reduce_max_pd(max_rel);
+	cmp->max_rel = (lane > cmp->max_rel) ? lane : cmp->max_rel;
+	cmp->violations += violations;
+	cmp->saturated  += saturated;
+	compareDoubles(x + i, y + i, len - i, tol, cmp);
+}
+
+/* Eight whole chunks at a time, two to a register with a lane each of
+ * theirs, four registers keeping the multiplier busy. What is left over,
+ * the short last chunk included, goes through the scalar kernel */
+#define SDC_HASH_WAYS 8
+
+SDC_TARGET_AVX512
+static void hashChunksAvx512(const void *in, const uint64_t len,
+	uint64_t *digests)
+{
+	const unsigned char *src = in;
+	const __m512i p1   = _mm512_set1_epi64((long long) SDC_XXH_P1);
+	const __m512i p2   = _mm512_set1_epi64((long long) SDC_XXH_P2);
+	const uint64_t way = SDC_HASH_WAYS * (uint64_t) SDC_HASH_CHUNK;
+	uint64_t lanes[8];
+	__m512i init;
+	__m512i acc[SDC_HASH_WAYS / 2];
+	uint64_t at;
+	size_t off, k;
+
+	xxhInit(lanes, 0);
+	xxhInit(lanes + 4, 0);
+	init = _mm512_loadu_si512((const void *) lanes);
+
+	for (at = 0; at + way <= len; at += way)
+	{
+		for (k = 0; k < SDC_HASH_WAYS / 2; k++)
+		{
+			acc[k] = init;
+		}
+
+		for (off = 0; off < SDC_HASH_CHUNK; off += SDC_XXH_STRIPE)
+		{
+			for (k = 0; k < SDC_HASH_WAYS / 2; k++)
+			{
+				const unsigned char *pair = src + at + off
+					+ 2 * k * SDC_HASH_CHUNK;
+				const __m256i lo = _mm256_loadu_si256(
+					(const void *) pair);
+				const __m256i hi = _mm256_loadu_si256(
+					(const void *) (pair + SDC_HASH_CHUNK));
+				const __m512i x = _mm512_inserti64x4(
+					_mm512_castsi256_si512(lo), hi, 1);
+
+				acc[k] = _mm512_mullo_epi64(_mm512_rol_epi64(
+					_mm512_add_epi64(acc[k],
+					_mm512_mullo_epi64(x, p2)), 31), p1);
+			}
+		}
+
+		for (k = 0; k < SDC_HASH_WAYS / 2; k++)
+		{
+			_mm512_storeu_si512((void *) lanes, acc[k]);
+			digests[2 * k] = xxhFinish(lanes, NULL, 0,
+				SDC_HASH_CHUNK, 0);
+			digests[2 * k + 1] = xxhFinish(lanes + 4, NULL, 0,
+				SDC_HASH_CHUNK, 0);
+		}
+
+		digests += SDC_HASH_WAYS;
+	}
+
+	hashChunks(src + at, len - at, digests);
+}
+#endif /* SDC_X86_SIMD */
+
+#define SDC_KERNEL_ENTRY(in_type, out_type, isa, func) \
+	{in_type, out_type, isa, #func, func}
+
+static const struct sdcKernelEntry kernel_table[] =
+{
+	SDC_KERNEL_ENTRY(FLOAT_64,   FLOAT_32,  ISA_SCALAR, doubleToFloat),
+	SDC_KERNEL_ENTRY(FLOAT_64,   FLOAT_16,  ISA_SCALAR, doubleToHalf),
+	SDC_KERNEL_ENTRY(FLOAT_64,   BFLOAT_16, ISA_SCALAR, doubleToBrain),
+	SDC_KERNEL_ENTRY(FLOAT_32,   FLOAT_16,  ISA_SCALAR, floatToHalf),
+	SDC_KERNEL_ENTRY(FLOAT_32,   BFLOAT_16, ISA_SCALAR, floatToBrain),
+	SDC_KERNEL_ENTRY(FLOAT_16,   BFLOAT_16, ISA_SCALAR, halfToBrain),
+	SDC_KERNEL_ENTRY(BFLOAT_16,  FLOAT_16,  ISA_SCALAR, brainToHalf),
+	SDC_KERNEL_ENTRY(SIGNED_64,  FLOAT_32,  ISA_SCALAR, signed64ToFloat),
+	SDC_KERNEL_ENTRY(SIGNED_64,  FLOAT_16,  ISA_SCALAR, signed64ToHalf),
+	SDC_KERNEL_ENTRY(SIGNED_64,  BFLOAT_16, ISA_SCALAR, signed64ToBrain),
+	SDC_KERNEL_ENTRY(SIGNED_32,  FLOAT_32,  ISA_SCALAR, signed32ToFloat),
+	SDC_KERNEL_ENTRY(SIGNED_32,  FLOAT_16,  ISA_SCALAR, signed32ToHalf),
+	SDC_KERNEL_ENTRY(SIGNED_32,  BFLOAT_16, ISA_SCALAR, signed32ToBrain),
+	SDC_KERNEL_ENTRY(SIGNED_16,  FLOAT_32,  ISA_SCALAR, signed16ToFloat),
+	SDC_KERNEL_ENTRY(SIGNED_16,  FLOAT_16,  ISA_SCALAR, signed16ToHalf),
+	SDC_KERNEL_ENTRY(SIGNED_16,  BFLOAT_16, ISA_SCALAR, signed16ToBrain),
+	SDC_KERNEL_ENTRY(SIGNED_8,   FLOAT_32,  ISA_SCALAR, signed8ToFloat),
+	SDC_KERNEL_ENTRY(SIGNED_8,   FLOAT_16,  ISA_SCALAR, signed8ToHalf),
+	SDC_KERNEL_ENTRY(SIGNED_8,   BFLOAT_16, ISA_SCALAR, signed8ToBrain),
+	SDC_KERNEL_ENTRY(UNSIGNED_8, FLOAT_32,  ISA_SCALAR, unsigned8ToFloat),
+	SDC_KERNEL_ENTRY(UNSIGNED_8, FLOAT_16,  ISA_SCALAR, unsigned8ToHalf),
+	SDC_KERNEL_ENTRY(UNSIGNED_8, BFLOAT_16, ISA_SCALAR, unsigned8ToBrain),
+	SDC_KERNEL_ENTRY(SIGNED_64,  SIGNED_32, ISA_SCALAR, signed64ToSigned32),
+	SDC_KERNEL_ENTRY(SIGNED_64,  SIGNED_16, ISA_SCALAR, signed64ToSigned16),
+	SDC_KERNEL_ENTRY(SIGNED_64,  SIGNED_8,  ISA_SCALAR, signed64ToSigned8),
+#ifdef SDC_X86_SIMD
+	SDC_KERNEL_ENTRY(FLOAT_64,   FLOAT_32,  ISA_AVX2, doubleToFloatAvx2),
+	SDC_KERNEL_ENTRY(FLOAT_64,   FLOAT_16,  ISA_AVX2, doubleToHalfAvx2),
+	SDC_KERNEL_ENTRY(FLOAT_64,   BFLOAT_16, ISA_AVX2, doubleToBrainAvx2),
+	SDC_KERNEL_ENTRY(FLOAT_32,   FLOAT_16,  ISA_AVX2, floatToHalfAvx2),
+	SDC_KERNEL_ENTRY(FLOAT_32,   BFLOAT_16, ISA_AVX2, floatToBrainAvx2),
+	SDC_KERNEL_ENTRY(FLOAT_16,   BFLOAT_16, ISA_AVX2, halfToBrainAvx2),
+	SDC_KERNEL_ENTRY(BFLOAT_16,  FLOAT_16,  ISA_AVX2, brainToHalfAvx2),
+	SDC_KERNEL_ENTRY(SIGNED_32,  FLOAT_32,  ISA_AVX2, signed32ToFloatAvx2),
+	SDC_KERNEL_ENTRY(SIGNED_32,  FLOAT_16,  ISA_AVX2, signed32ToHalfAvx2),
+	SDC_KERNEL_ENTRY(SIGNED_32,  BFLOAT_16, ISA_AVX2, signed32ToBrainAvx2),
+	SDC_KERNEL_ENTRY(SIGNED_16,  FLOAT_32,  ISA_AVX2, signed16ToFloatAvx2),
+	SDC_KERNEL_ENTRY(SIGNED_16,  FLOAT_16,  ISA_AVX2, signed16ToHalfAvx2),
+	SDC_KERNEL_ENTRY(SIGNED_16,  BFLOAT_16, ISA_AVX2, signed16ToBrainAvx2),
+	SDC_KERNEL_ENTRY(SIGNED_8,   FLOAT_32,  ISA_AVX2, signed8ToFloatAvx2),
+	SDC_KERNEL_ENTRY(SIGNED_8,   FLOAT_16,  ISA_AVX2, signed8ToHalfAvx2),
+	SDC_KERNEL_ENTRY(SIGNED_8,   BFLOAT_16, ISA_AVX2, signed8ToBrainAvx2),
+	SDC_KERNEL_ENTRY(UNSIGNED_8, FLOAT_32,  ISA_AVX2, unsigned8ToFloatAvx2),
+	SDC_KERNEL_ENTRY(UNSIGNED_8, FLOAT_16,  ISA_AVX2, unsigned8ToHalfAvx2),
+	SDC_KERNEL_ENTRY(UNSIGNED_8, BFLOAT_16, ISA_AVX2, unsigned8ToBrainAvx2),
+	SDC_KERNEL_ENTRY(FLOAT_64,   FLOAT_32,  ISA_AVX512,
+		doubleToFloatAvx512),
+	SDC_KERNEL_ENTRY(FLOAT_64,   FLOAT_16,  ISA_AVX512, doubleToHalfAvx512),
+	SDC_KERNEL_ENTRY(FLOAT_64,   BFLOAT_16, ISA_AVX512,
+		doubleToBrainAvx512),
+	SDC_KERNEL_ENTRY(FLOAT_32,   FLOAT_16,  ISA_AVX512, floatToHalfAvx512),
+	SDC_KERNEL_ENTRY(FLOAT_32,   BFLOAT_16, ISA_AVX512,
+		floatToBrainAvx512),
+	SDC_KERNEL_ENTRY(FLOAT_16,   BFLOAT_16, ISA_AVX512, halfToBrainAvx512),
+	SDC_KERNEL_ENTRY(BFLOAT_16,  FLOAT_16,  ISA_AVX512, brainToHalfAvx512),
+	SDC_KERNEL_ENTRY(SIGNED_64,  FLOAT_32,  ISA_AVX512,
+		signed64ToFloatAvx512),
+	SDC_KERNEL_ENTRY(SIGNED_64,  FLOAT_16,  ISA_AVX512,
+		signed64ToHalfAvx512),
+	SDC_KERNEL_ENTRY(SIGNED_64,  BFLOAT_16, ISA_AVX512,
+		signed64ToBrainAvx512),
+	SDC_KERNEL_ENTRY(SIGNED_32,  FLOAT_32,  ISA_AVX512,
+		signed32ToFloatAvx512),
+	SDC_KERNEL_ENTRY(SIGNED_32,  FLOAT_16,  ISA_AVX512,
+		signed32ToHalfAvx512),
+	SDC_KERNEL_ENTRY(SIGNED_32,  BFLOAT_16, ISA_AVX512,
+		signed32ToBrainAvx512),
+	SDC_KERNEL_ENTRY(SIGNED_16,  FLOAT_32,  ISA_AVX512,
+		signed16ToFloatAvx512),
+	SDC_KERNEL_ENTRY(SIGNED_16,  FLOAT_16,  ISA_AVX512,
+		signed16ToHalfAvx512),
+	SDC_KERNEL_ENTRY(SIGNED_16,  BFLOAT_16, ISA_AVX512,
+		signed16ToBrainAvx512),
+	SDC_KERNEL_ENTRY(SIGNED_8,   FLOAT_32,  ISA_AVX512,
+		signed8ToFloatAvx512),
+	SDC_KERNEL_ENTRY(SIGNED_8,   FLOAT_16,  ISA_AVX512,
+		signed8ToHalfAvx512),
+	SDC_KERNEL_ENTRY(SIGNED_8,   BFLOAT_16, ISA_AVX512,
+		signed8ToBrainAvx512),
+	SDC_KERNEL_ENTRY(UNSIGNED_8, FLOAT_32,  ISA_AVX512,
+		unsigned8ToFloatAvx512),
+	SDC_KERNEL_ENTRY(UNSIGNED_8, FLOAT_16,  ISA_AVX512,
+		unsigned8ToHalfAvx512),
+	SDC_KERNEL_ENTRY(UNSIGNED_8, BFLOAT_16, ISA_AVX512,
+		unsigned8ToBrainAvx512),
+	SDC_KERNEL_ENTRY(SIGNED_64,  SIGNED_32, ISA_AVX512,
+		signed64ToSigned32Avx512),
+	SDC_KERNEL_ENTRY(SIGNED_64,  SIGNED_16, ISA_AVX512,
+		signed64ToSigned16Avx512),
+	SDC_KERNEL_ENTRY(SIGNED_64,  SIGNED_8,  ISA_AVX512,
+		signed64ToSigned8Avx512),
+#endif /* SDC_X86_SIMD */
+};
+
+static const size_t kernel_table_len
+	= sizeof(kernel_table) / sizeof(kernel_table[0]);
+
+struct sdcScanEntry
+{
+	const enum dataType in_type;
+	const enum sdcIsa isa;
+	const sdcScanKernel func;
+};
+
+static const struct sdcScanEntry scan_table[] =
+{
+	{FLOAT_64,  ISA_SCALAR, scanDouble},
+	{FLOAT_32,  ISA_SCALAR, scanFloat},
+	{SIGNED_64, ISA_SCALAR, scanSigned64},
+#ifdef SDC_X86_SIMD
+	{FLOAT_64,  ISA_AVX2,   scanDoubleAvx2},
+	{FLOAT_32,  ISA_AVX2,   scanFloatAvx2},
+	{FLOAT_64,  ISA_AVX512, scanDoubleAvx512},
+	{FLOAT_32,  ISA_AVX512, scanFloatAvx512},
+	{SIGNED_64, ISA_AVX512, scanSigned64Avx512},
+#endif /* SDC_X86_SIMD */
+};
+
+static const size_t scan_table_len
+	= sizeof(scan_table) / sizeof(scan_table[0]);
+
+struct sdcWidenEntry
+{
+	const enum dataType in_type;
+	const enum sdcIsa isa;
+	const sdcWidenKernel func;
+};
+
+static const struct sdcWidenEntry widen_table[] =
+{
+	{FLOAT_64,   ISA_SCALAR, widenDouble},
+	{FLOAT_32,   ISA_SCALAR, widenFloat},
+	{FLOAT_16,   ISA_SCALAR, widenHalf},
+	{BFLOAT_16,  ISA_SCALAR, widenBrain},
+	{SIGNED_64,  ISA_SCALAR, widenSigned64},
+	{SIGNED_32,  ISA_SCALAR, widenSigned32},
+	{SIGNED_16,  ISA_SCALAR, widenSigned16},
+	{SIGNED_8,   ISA_SCALAR, widenSigned8},
+	{UNSIGNED_8, ISA_SCALAR, widenUnsigned8},
+#ifdef SDC_X86_SIMD
+	{FLOAT_32,   ISA_AVX2,   widenFloatAvx2},
+	{FLOAT_16,   ISA_AVX2,   widenHalfAvx2},
+	{BFLOAT_16,  ISA_AVX2,   widenBrainAvx2},
+	{SIGNED_32,  ISA_AVX2,   widenSigned32Avx2},
+	{SIGNED_16,  ISA_AVX2,   widenSigned16Avx2},
+	{SIGNED_8,   ISA_AVX2,   widenSigned8Avx2},
+	{UNSIGNED_8, ISA_AVX2,   widenUnsigned8Avx2},
+	{SIGNED_64,  ISA_AVX512, widenSigned64Avx512},
+#endif /* SDC_X86_SIMD */
+};
+
+static const size_t widen_table_len
+	= sizeof(widen_table) / sizeof(widen_table[0]);
+
+static enum sdcIsa cpu_isa = NUM_ISA;
+
+static void detectCpuIsa(void)
+{
+	enum sdcIsa isa = ISA_SCALAR;
+#ifdef SDC_X86_SIMD
+	__builtin_cpu_init();
+
+	if ((__builtin_cpu_supports("avx2"))
+	&& (__builtin_cpu_supports("f16c")))
+	{
+		isa = ISA_AVX2;
+
+		if ((__builtin_cpu_supports("avx512f"))
+		&& (__builtin_cpu_supports("avx512dq")))
+		{
+			isa = ISA_AVX512;
+		}
+	}
+#endif /* SDC_X86_SIMD */
+	cpu_isa = isa;
+}
+
+/* Detected once however many threads ask at the same time. Without
+ * pthreads, on Windows, by creating the first context */
+enum sdcIsa getCpuIsa(void)
+{
+#ifndef _WIN32
+	static pthread_once_t detected = PTHREAD_ONCE_INIT;
+
+	pthread_once(&detected, detectCpuIsa);
+#else
+	if (cpu_isa == NUM_ISA)
+	{
+		detectCpuIsa();
+	}
+#endif
+
+	return cpu_isa;
+}
+
+/* Returns the best kernel the running CPU supports, or NULL should there be
+ * no kernel for the given pair */
+sdcKernel getConversionKernel(const enum dataType in_type,
+	const enum dataType out_type)
+{
+	const enum sdcIsa cpu_isa = getCpuIsa();
+	const struct sdcKernelEntry *best = NULL;
+	size_t i;
+
+	for (i = 0; i < kernel_table_len; i++)
+	{
+		if ((kernel_table[i].in_type == in_type)
+		&& (kernel_table[i].out_type == out_type)
+		&& (kernel_table[i].isa <= cpu_isa)
+		&& ((best == NULL) || (kernel_table[i].isa > best->isa)))
+		{
+			best = &kernel_table[i];
+		}
+	}
+
+	return (best != NULL) ? best->func : NULL;
+}
+
+sdcScanKernel getScanKernel(const enum dataType in_type)
+{
+	const enum sdcIsa cpu_isa = getCpuIsa();
+	const struct sdcScanEntry *best = NULL;
+	size_t i;
+
+	for (i = 0; i < scan_table_len; i++)
+	{
+		if ((scan_table[i].in_type == in_type)
+		&& (scan_table[i].isa <= cpu_isa)
+		&& ((best == NULL) || (scan_table[i].isa > best->isa)))
+		{
+			best = &scan_table[i];
+		}
+	}
+
+	return (best != NULL) ? best->func : NULL;
+}
+
+sdcWidenKernel getWidenKernel(const enum dataType in_type)
+{
+	const enum sdcIsa cpu_isa = getCpuIsa();
+	const struct sdcWidenEntry *best = NULL;
+	size_t i;
+
+	for (i = 0; i < widen_table_len; i++)
+	{
+		if ((widen_table[i].in_type == in_type)
+		&& (widen_table[i].isa <= cpu_isa)
+		&& ((best == NULL) || (widen_table[i].isa > best->isa)))
+		{
+			best = &widen_table[i];
+		}
+	}
+
+	return (best != NULL) ? best->func : NULL;
+}
+
+sdcCompareKernel getCompareKernel(void)
+{
+#ifdef SDC_X86_SIMD
+	switch (getCpuIsa())
+	{
+		case ISA_AVX512:
+			return compareDoublesAvx512;
+		case ISA_AVX2:
+			return compareDoublesAvx2;
+		default:
+			break;
+	}
+#endif /* SDC_X86_SIMD */
+
+	return compareDoubles;
+}
+
+sdcHashKernel getHashKernel(void)
+{
+#ifdef SDC_X86_SIMD
+	if (getCpuIsa() == ISA_AVX512)
+	{
+		return hashChunksAvx512;
+	}
+#endif /* SDC_X86_SIMD */
+
+	return hashChunks;
+}
+
+/* Every variant regardless of CPU support, mostly of use for benchmarking */
+const struct sdcKernelEntry* getKernelTable(size_t *len)
+{
+	if (len != NULL)
+	{
+		*len = kernel_table_len;
+	}
+
+	return kernel_table;
+}
@@ -0,0 +1,128 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "main.h"
+
+/* The vectorized kernels rely on GCC/Clang function target attributes and
+ * cpu feature builtins, anything else gets the portable scalar kernels */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+	&& !defined(SDC_NO_SIMD)
+#define SDC_X86_SIMD
+#endif
+
+/* Largest finite IEEE half-precision and brain float values */
+#define SDC_HLF_MAX 65504.0f
+#define SDC_BFT_MAX 3.38953139e38f
+
+/* Instruction set tiers a kernel variant may require, ordered such that a
+ * higher tier is preferred whenever the running CPU supports it */
+enum sdcIsa
+{
+	ISA_SCALAR = 0,
+	ISA_AVX2,   /* AVX2 + F16C */
+	ISA_AVX512, /* AVX-512F + AVX-512DQ */
+	NUM_ISA
+};
+
+static const char * const isa_strs[] =
+{
+	"scalar",
+	"avx2",
+	"avx512"
+};
+
+/* Converts len elements of in into out, both in system byte order. Given
+ * err the precision lost is measured in the same pass and folded into it,
+ * which should start out zeroed */
+typedef void (*sdcKernel)(const void *in, void *out, const size_t len,
+	struct sdcConvError *err);
+
+/* What -f auto and lossless decide on, gathered in a single pass over a 
+ * tensor. A float is inexact for a dtype when converting it there, 
+ * saturation included, would not give it back, NaNs only count towards 
+ * nan. Integers need only their range. Scans are made at most 
+ * SDC_SCAN_CHUNK bytes at a time */
+#define SDC_SCAN_CHUNK (4 << 20)
+
+struct sdcRange
+{
+	double min;
+	double max;
+	double abs_min;  /* smallest non-zero magnitude, +inf if none */
+	uint64_t nan;
+	uint64_t inexact[NUM_DATA_TYPE];
+};
+
+typedef void (*sdcScanKernel)(const void *in, const size_t len,
+	struct sdcRange *range);
+
+/* --verify widens both files' tensors to doubles, a block at a time, and
+ * compares them. Input beyond [lo, hi] should have saturated to it and
+ * what remains be within rel of it or abs of it, which covers rounding
+ * and the subnormals. Equal values, infinities among them, always pass
+ * and NaNs must stay NaNs */
+struct sdcTolerance
+{
+	double rel;
+	double abs;
+	double lo;
+	double hi;
+};
+
+struct sdcCompare
+{
+	uint64_t violations;
+	uint64_t saturated;
+	double max_abs;
+	double max_rel;  /* against the clamped input, zeros left out */
+};
+
+typedef void (*sdcWidenKernel)(const void *in, double *out,
+	const size_t len);
+typedef void (*sdcCompareKernel)(const double *x, const double *y,
+	const size_t len, const struct sdcTolerance *tol,
+	struct sdcCompare *cmp);
+
+/* --hash digests a tensor as a tree, each SDC_HASH_CHUNK bytes of it with
+ * XXH64 on its own, the last chunk short, and those digests together as
+ * little endian. Chunks being independent they go over threads and SIMD
+ * lanes alike */
+#define SDC_HASH_CHUNK (256 << 10)
+
+typedef void (*sdcHashKernel)(const void *in, const uint64_t len,
+	uint64_t *digests);
+
+struct sdcKernelEntry
+{
+	const enum dataType in_type;
+	const enum dataType out_type;
+	const enum sdcIsa isa;
+	const char *name;
+	const sdcKernel func;
+};
+
+uint32_t asU32(const float in);
+float asF32(const uint32_t in);
+uint16_t fltToHlf(const float in);
+float hlfToFlt(const uint16_t in);
+uint16_t fltToBft(const float in);
+float bftToFlt(const uint16_t in);
+void mergeConvError(struct sdcConvError *into,
+	const struct sdcConvError *from);
+
+enum sdcIsa getCpuIsa(void);
+sdcKernel getConversionKernel(const enum dataType in_type,
+	const enum dataType out_type);
+const struct sdcKernelEntry* getKernelTable(size_t *len);
+void initRange(struct sdcRange *range);
+/* Only F64, F32 and I64 tensors are scanned, NULL for anything else */
+sdcScanKernel getScanKernel(const enum dataType in_type);
+/* Every numeric dtype widens, NULL for BOOL and unknown ones */
+sdcWidenKernel getWidenKernel(const enum dataType in_type);
+sdcCompareKernel getCompareKernel(void);
+uint64_t xxh64(const void *in, const size_t len, const uint64_t seed);
+/* The tensor's hash from its chunks' digests, which are left little endian */
+uint64_t foldDigests(uint64_t *digests, const size_t len);
+sdcHashKernel getHashKernel(void);
+
+#endif /* KERNELS_H */
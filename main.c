@@ -1,71 +1,433 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <float.h>
+#include <string.h>
+#include <limits.h>
 
-#include "main.h"
-#include "fileLoading.h"
+#ifdef _WIN32
+#include <io.h>
+#define isatty _isatty
+#define fileno _fileno
+#define fdopen _fdopen
+#else
+#include <unistd.h>
+#endif
+
+#include "sdc.h"
 #include "portopt.h"
+#include "portegg.h"
+
+/* The replace option, -R, writes to a temporary file renamed over the input
+ * once synced, so a crash part way through leaves the input as it was */
 
-/* When using the replace option, -R, there is a possibility that if the 
- * program were to be terminated or crash during the overwriting of the input 
- * file data could be lost.  One could write out to a .swp file and then rename
- * it to the original but this would depend upon platform specific code */
+/* Seconds between progress updates for a terminal, a log and a progress
+ * file descriptor respectively */
+#define SDC_PROGRESS_TTY_SECS 0.2
+#define SDC_PROGRESS_LOG_SECS 5.0
+#define SDC_PROGRESS_FD_SECS  1.0
 
-extern SDC_BOOL      verbose_output;
-extern SDC_BOOL      inplace_conv;
-extern enum dataType float_out;
+struct cliProgress
+{
+	FILE *human;     /* stderr with --progress, else NULL */
+	SDC_BOOL is_tty;
+	FILE *machine;   /* --progress-fd, else NULL */
+	enum sdcProgressStage stage;
+	double human_last;
+	double machine_last;
+};
+
+static const char * const stage_strs[] =
+{
+	"convert",
+	"sync",
+	"scan"
+};
 
 void printHelp(void);
 
-static enum dataType getFloatType(const char *str)
+static void printHuman(struct cliProgress *cli, const struct sdcProgress *prog)
 {
-	if (strcmp(str, "F32") == 0)
+	const double pct = (prog->bytes_total > 0)
+		? ((double) prog->bytes_done * 100.0)
+			/ (double) prog->bytes_total
+		: 100.0;
+	const unsigned long eta = (prog->eta_secs >= 0.0)
+		? (unsigned long) prog->eta_secs : 0;
+
+	fprintf(cli->human, "%s%-7s %5.1f%% %9.1f / %.1f MB %8.1f MB/s ",
+		(cli->is_tty == SDC_TRUE) ? "\r" : "", stage_strs[prog->stage],
+		pct, (double) prog->bytes_done / 1e6,
+		(double) prog->bytes_total / 1e6, prog->mb_per_sec);
+
+	if (prog->eta_secs >= 0.0)
 	{
-		return FLOAT_32;
+		fprintf(cli->human, "ETA %lu:%02lu:%02lu", eta / 3600,
+			(eta / 60) % 60, eta % 60);
 	}
-	else if (strcmp(str, "F16") == 0)
+	else
 	{
-		return FLOAT_16;
+		fputs("ETA --:--:--", cli->human);
 	}
-	else if (strcmp(str, "BF16") == 0)
+
+	if (prog->stage != SDC_STAGE_SYNC)
 	{
-		return BFLOAT_16;
+		fprintf(cli->human, " [%lu/%lu] %.40s",
+			(unsigned long) prog->tensors_done,
+			(unsigned long) prog->tensors_total,
+			(prog->tensor != NULL) ? prog->tensor : "");
 	}
-	else
+
+	/* A terminal line is cleared to its end and only broken once the
+	 * stage is through, everything else gets a line per update */
+	fputs(((cli->is_tty == SDC_TRUE) && (prog->finished == SDC_FALSE))
+		? "\033[K" : ((cli->is_tty == SDC_TRUE) ? "\033[K\n" : "\n"),
+		cli->human);
+	fflush(cli->human);
+}
+
+static void printMachine(struct cliProgress *cli,
+	const struct sdcProgress *prog)
+{
+	const char *name = (prog->tensor != NULL) ? prog->tensor : "";
+
+	fprintf(cli->machine, "{\"stage\":\"%s\",\"bytes_done\":%llu,"
+		"\"bytes_total\":%llu,\"tensors_done\":%lu,"
+		"\"tensors_total\":%lu,\"tensor\":\"",
+		stage_strs[prog->stage], (unsigned long long) prog->bytes_done,
+		(unsigned long long) prog->bytes_total,
+		(unsigned long) prog->tensors_done,
+		(unsigned long) prog->tensors_total);
+
+	for (; *name != '\0'; name++)
+	{
+		if ((*name == '"') || (*name == '\\'))
+		{
+			fputc('\\', cli->machine);
+		}
+
+		if ((unsigned char) *name >= 0x20)
+		{
+			fputc(*name, cli->machine);
+		}
+	}
+
+	fprintf(cli->machine, "\",\"elapsed\":%.3f,\"mb_per_sec\":%.2f,"
+		"\"eta\":%.1f,\"finished\":%s}\n", prog->elapsed_secs,
+		prog->mb_per_sec, prog->eta_secs,
+		(prog->finished == SDC_TRUE) ? "true" : "false");
+	fflush(cli->machine);
+}
+
+/* The library rate-limits to the shortest interval of the two outputs,
+ * each of which then keeps to its own */
+static void reportProgress(void *user, const struct sdcProgress *prog)
+{
+	struct cliProgress *cli = user;
+	const double human_secs = (cli->is_tty == SDC_TRUE)
+		? SDC_PROGRESS_TTY_SECS : SDC_PROGRESS_LOG_SECS;
+
+	if (prog->stage != cli->stage)
 	{
-		return DTYPE_UNKNOWN;
+		cli->stage        = prog->stage;
+		cli->human_last   = 0.0;
+		cli->machine_last = 0.0;
+	}
+
+	if ((cli->human != NULL) && ((prog->finished == SDC_TRUE)
+		|| ((prog->elapsed_secs - cli->human_last) >= human_secs)))
+	{
+		cli->human_last = prog->elapsed_secs;
+		printHuman(cli, prog);
+	}
+
+	if ((cli->machine != NULL) && ((prog->finished == SDC_TRUE)
+		|| ((prog->elapsed_secs - cli->machine_last)
+			>= SDC_PROGRESS_FD_SECS)))
+	{
+		cli->machine_last = prog->elapsed_secs;
+		printMachine(cli, prog);
 	}
 }
 
+/* The whole argument must be a number, arg is NULL when it was missing */
+static SDC_STAT parseBudget(struct sdc_context *ctx, const char *arg)
+{
+	char *end     = NULL;
+	double budget = 0.0;
+
+	if (arg != NULL)
+	{
+		budget = strtod(arg, &end);
+	}
+
+	if ((arg == NULL) || (end == arg) || (*end != '\0'))
+	{
+		fputs("--auto-budget takes a relative error above zero, "
+			"eg: 0.004\n", stderr);
+
+		return SDC_FAILURE;
+	}
+
+	return sdcSetAutoBudget(ctx, budget);
+}
+
+/* Only plain non-negative integers up to max, strtoul alone would take
+ * signs, spaces and trailing garbage */
+static SDC_STAT parseNumber(const char *arg, const unsigned long max,
+	unsigned long *out)
+{
+	size_t i;
+
+	*out = 0;
+
+	for (i = 0; (arg != NULL) && (arg[i] >= '0') && (arg[i] <= '9'); i++)
+	{
+		*out = (*out > max / 10) ? ULONG_MAX
+			: *out * 10 + (unsigned long) (arg[i] - '0');
+	}
+
+	return ((arg == NULL) || (i == 0) || (arg[i] != '\0') || (*out > max))
+		? SDC_FAILURE : SDC_SUCCESS;
+}
+
+static SDC_STAT parseThreads(struct sdc_context *ctx, const char *arg)
+{
+	unsigned long threads;
+
+	if ((parseNumber(arg, UINT_MAX, &threads) == SDC_FAILURE)
+	|| (threads == 0))
+	{
+		fputs("--jobs takes a thread count above zero\n", stderr);
+
+		return SDC_FAILURE;
+	}
+
+	sdcSetThreads(ctx, (unsigned) threads);
+
+	return SDC_SUCCESS;
+}
+
+static SDC_STAT writeStats(struct sdc_context *ctx, const char *stats_path)
+{
+	FILE *fhandle = NULL;
+	char *json    = NULL;
+	SDC_STAT ret_code = SDC_SUCCESS;
+
+	if ((json = sdcStatsJson(ctx)) == NULL)
+	{
+		fputs("Failure to serialize statistics\n", stderr);
+
+		return SDC_FAILURE;
+	}
+
+	if ((fhandle = fopen(stats_path, "w")) == NULL)
+	{
+		fprintf(stderr, "Failure to open stats file '%s'\n",
+			stats_path);
+		sdcFree(ctx, json);
+
+		return SDC_FAILURE;
+	}
+
+	if ((fputs(json, fhandle) == EOF) || (fputc('\n', fhandle) == EOF))
+	{
+		fputs("Failure to write statistics\n", stderr);
+		ret_code = SDC_FAILURE;
+	}
+
+	if (fclose(fhandle) == EOF)
+	{
+		ret_code = SDC_FAILURE;
+	}
+
+	sdcFree(ctx, json);
+
+	return ret_code;
+}
+
+static void printDtypes(const char *key, const size_t *tensors,
+	const uint64_t *bytes)
+{
+	const char *sep = "";
+	int i;
+
+	printf(",\"%s\":{", key);
+
+	for (i = 0; i < NUM_DATA_TYPE; i++)
+	{
+		if (tensors[i] == 0)
+		{
+			continue;
+		}
+
+		printf("%s\"%s\":{\"tensors\":%lu,\"bytes\":%llu}", sep,
+			sdcDtypeName((enum dataType) i),
+			(unsigned long) tensors[i],
+			(unsigned long long) bytes[i]);
+		sep = ",";
+	}
+
+	putchar('}');
+}
+
+/* The whole estimate as a single JSON object on stdout */
+static SDC_STAT printEstimate(struct sdc_context *ctx, const char *file_path)
+{
+	struct sdcEstimate est;
+
+	if (sdcEstimateFile(ctx, file_path, &est) == SDC_FAILURE)
+	{
+		return SDC_FAILURE;
+	}
+
+	printf("{\"tensors\":%lu,\"output_bytes\":%llu,"
+		"\"header_bytes\":%llu,\"bytes_read\":%llu,"
+		"\"bytes_written\":%llu,\"peak_memory\":%llu",
+		(unsigned long) est.tensors,
+		(unsigned long long) est.output_bytes,
+		(unsigned long long) est.header_bytes,
+		(unsigned long long) est.bytes_read,
+		(unsigned long long) est.bytes_written,
+		(unsigned long long) est.peak_memory);
+	printDtypes("dtypes_in", est.tensors_in, est.bytes_in);
+	printDtypes("dtypes_out", est.tensors_out, est.bytes_out);
+	puts("}");
+
+	return (fflush(stdout) == EOF) ? SDC_FAILURE : SDC_SUCCESS;
+}
+
+/* A summary on stdout, failing should any tensor be bad */
+static SDC_STAT printVerify(struct sdc_context *ctx, const char *in_path,
+	const char *out_path)
+{
+	struct sdcVerifyReport report;
+
+	if (sdcVerifyFile(ctx, in_path, out_path, &report) == SDC_FAILURE)
+	{
+		return SDC_FAILURE;
+	}
+
+	printf("Verified %lu tensors, %llu elements, in %.3f s at %.1f MB/s "
+		"on %u threads\n", (unsigned long) report.tensors,
+		(unsigned long long) report.elements, report.seconds,
+		(report.seconds > 0.0)
+			? (double) report.bytes / 1e6 / report.seconds : 0.0,
+		report.threads);
+	printf("%llu violations, %llu saturated, worst abs %g rel %g\n",
+		(unsigned long long) report.violations,
+		(unsigned long long) report.saturated, report.max_abs,
+		report.max_rel);
+	printf("%lu bad tensors, %lu missing from the output\n",
+		(unsigned long) report.bad_tensors,
+		(unsigned long) report.missing);
+
+	if (fflush(stdout) == EOF)
+	{
+		return SDC_FAILURE;
+	}
+
+	return (report.bad_tensors > 0) ? SDC_FAILURE : SDC_SUCCESS;
+}
+
+/* A summary on stdout, failing should any tensor be unhashed or changed */
+static SDC_STAT printCheck(struct sdc_context *ctx, const char *path)
+{
+	struct sdcCheckReport report;
+
+	if (sdcCheckFile(ctx, path, &report) == SDC_FAILURE)
+	{
+		return SDC_FAILURE;
+	}
+
+	printf("Checked %lu tensors, %llu bytes, in %.3f s at %.1f MB/s on "
+		"%u threads\n", (unsigned long) report.tensors,
+		(unsigned long long) report.bytes, report.seconds,
+		(report.seconds > 0.0)
+			? (double) report.bytes / 1e6 / report.seconds : 0.0,
+		report.threads);
+	printf("%lu mismatched, %lu without a hash\n",
+		(unsigned long) report.mismatched,
+		(unsigned long) report.unhashed);
+
+	if (fflush(stdout) == EOF)
+	{
+		return SDC_FAILURE;
+	}
+
+	return ((report.mismatched > 0) || (report.unhashed > 0))
+		? SDC_FAILURE : SDC_SUCCESS;
+}
+
 int main(int argc, char **argv)
 {
 	const struct portoptVerboseOpt opts[] =
 	{
 		{'R', "replace",    PORTOPT_FALSE},
 		{'f', "float-type", PORTOPT_TRUE},
+		{'a', "auto-budget", PORTOPT_TRUE},
 		{'i', "input",      PORTOPT_TRUE},
 		{'o', "output",     PORTOPT_TRUE},
+		{'r', "rule",       PORTOPT_TRUE},
+		{'I', "include",    PORTOPT_TRUE},
+		{'X', "exclude",    PORTOPT_TRUE},
+		{'F', "rules-file", PORTOPT_TRUE},
+		{'s', "stats",      PORTOPT_TRUE},
+		{'p', "progress",   PORTOPT_FALSE},
+		{'P', "progress-fd", PORTOPT_TRUE},
+		{'t', "trace",      PORTOPT_TRUE},
+		{'c', "cache-friendly", PORTOPT_FALSE},
+		{'d', "direct-io",  PORTOPT_FALSE},
+		{'n', "dry-run",    PORTOPT_FALSE},
+		{'V', "verify",     PORTOPT_TRUE},
+		{'j', "jobs",       PORTOPT_TRUE},
+		{'H', "hash",       PORTOPT_FALSE},
+		{'C', "check",      PORTOPT_TRUE},
 		{'v', "verbose",    PORTOPT_FALSE},
 		{'h', "help",       PORTOPT_FALSE}
 	};
 	const size_t num_opts = sizeof(opts) / sizeof(opts[0]);
 	const size_t lenc = (size_t) argc;
-	char *file_path = NULL;
-	char *out_path  = "output.safetensors";
+	struct sdc_context *ctx = NULL;
+	char *file_path  = NULL;
+	char *out_path   = "output.safetensors";
+	char *float_type = "F32";
+	char *stats_path = NULL;
+	unsigned long progress_fd = ULONG_MAX;
+	char *trace_path  = NULL;
+	char *verify_in   = NULL;
+	char *verify_out  = NULL;
+	char *check_path  = NULL;
+	struct cliProgress cli = {0};
+	double interval;
+	SDC_BOOL verbose = SDC_FALSE;
+	SDC_BOOL inplace = SDC_FALSE;
+	SDC_BOOL cache_friendly = SDC_FALSE;
+	SDC_BOOL direct_io = SDC_FALSE;
+	SDC_BOOL dry_run   = SDC_FALSE;
+	SDC_BOOL hash      = SDC_FALSE;
 	size_t ind = 0;
+	SDC_STAT ret_code = SDC_SUCCESS;
 	int flag;
 
+	if ((ctx = sdcCreateContext(NULL)) == NULL)
+	{
+		fputs("Failure to create conversion context\n", stderr);
+
+		return SDC_FAILURE;
+	}
+
 	while ((flag = portoptVerbose(lenc, argv, opts, num_opts, &ind)) != -1)
 	{
 		switch (flag)
 		{
-			/* 'replace' instead of 'inplace' to avoid users 
-			 * inputting -I when they mean -i and losing data */
+			/* 'replace' instead of 'inplace', -I is --include */
 			case 'R':
-				inplace_conv = SDC_TRUE;
+				inplace = SDC_TRUE;
 				break;
 			case 'f':
-				float_out = getFloatType(portoptGetArg(lenc, 
+				float_type = portoptGetArg(lenc, argv, &ind);
+				break;
+			case 'a':
+				ret_code = parseBudget(ctx, portoptGetArg(lenc,
 					argv, &ind));
 				break;
 			case 'i':
@@ -74,34 +436,142 @@ int main(int argc, char **argv)
 			case 'o':
 				out_path = portoptGetArg(lenc, argv, &ind);
 				break;
+			case 'r':
+				ret_code = sdcAddRule(ctx, portoptGetArg(lenc,
+					argv, &ind));
+				break;
+			case 'F':
+				ret_code = sdcLoadRules(ctx, portoptGetArg(lenc,
+					argv, &ind));
+				break;
+			case 'I':
+				ret_code = sdcAddInclude(ctx, portoptGetArg(
+					lenc, argv, &ind));
+				break;
+			case 'X':
+				ret_code = sdcAddExclude(ctx, portoptGetArg(
+					lenc, argv, &ind));
+				break;
+			case 's':
+				stats_path = portoptGetArg(lenc, argv, &ind);
+				break;
+			case 'p':
+				cli.human = stderr;
+				break;
+			case 'P':
+				if (parseNumber(portoptGetArg(lenc, argv, &ind),
+					INT_MAX, &progress_fd) == SDC_FAILURE)
+				{
+					fputs("--progress-fd takes a file "
+						"descriptor, eg: 3\n", stderr);
+					ret_code = SDC_FAILURE;
+				}
+				break;
+			case 't':
+				trace_path = portoptGetArg(lenc, argv, &ind);
+				break;
+			case 'c':
+				cache_friendly = SDC_TRUE;
+				break;
+			case 'd':
+				direct_io = SDC_TRUE;
+				break;
+			case 'n':
+				dry_run = SDC_TRUE;
+				break;
+			case 'V':
+				verify_in = portoptGetArg(lenc, argv, &ind);
+				verify_out = (ind < lenc) ? portoptGetArg(lenc,
+					argv, &ind) : NULL;
+				break;
+			case 'j':
+				ret_code = parseThreads(ctx, portoptGetArg(
+					lenc, argv, &ind));
+				break;
+			case 'H':
+				hash = SDC_TRUE;
+				break;
+			case 'C':
+				check_path = portoptGetArg(lenc, argv, &ind);
+				break;
 			case 'v':
 				fputs("Enabling verbose output\n", stdout);
-				verbose_output = SDC_TRUE;
+				verbose = SDC_TRUE;
 				break;
 			case 'h':
 				printHelp();
+				sdcDestroyContext(ctx);
 				return SDC_SUCCESS;
 			case '?':
 			default: /* fallthrough */
 				fputs("Unknown switch\n", stderr);
 				break;
 		}
+
+		if (ret_code == SDC_FAILURE)
+		{
+			sdcDestroyContext(ctx);
+
+			return SDC_FAILURE;
+		}
 	}
 
-	if (float_out == DTYPE_UNKNOWN)
+	sdcSetVerbose(ctx, verbose);
+	sdcSetInplace(ctx, inplace);
+	sdcSetCacheFriendly(ctx, cache_friendly);
+	sdcSetDirectIO(ctx, direct_io);
+	sdcSetHash(ctx, hash);
+	sdcSetCollectStats(ctx, (stats_path != NULL) ? SDC_TRUE : SDC_FALSE);
+	sdcSetTrace(ctx, (trace_path != NULL) ? SDC_TRUE : SDC_FALSE);
+
+
+	if (sdcSetFloatOut(ctx, float_type) == SDC_FAILURE)
 	{
 		fputs("Invalid argument for --float-type, valid options are:\n"
-			"'F32'  : C language float type (default)\n"
-			"'F16'  : IEEE Specfication Half precision float\n"
-			"'BF16' : 'Brain' Half precision float\n", stdout);
+			"'F32'      : C language float type (default)\n"
+			"'F16'      : IEEE Specfication Half precision float\n"
+			"'BF16'     : 'Brain' Half precision float\n"
+			"'auto'     : Narrowest float within --auto-budget\n"
+			"'lossless' : Narrowest exact dtype, else kept\n",
+			stdout);
+		sdcDestroyContext(ctx);
 
 		return SDC_FAILURE;
 	}
-	else if (float_out != FLOAT_32)
+	else if ((verbose == SDC_TRUE) && (strcmp(float_type, "F32") != 0))
 	{
-		verbosePrintf("WARNING: conversion to half precision or brain"
+		fputs("WARNING: conversion to half precision or brain"
 			" floats relies on bit fiddling and as such may not "
-			"work as expected for non-IEEE compliant systems\n");
+			"work as expected for non-IEEE compliant systems\n",
+			stdout);
+	}
+
+	if ((verify_in != NULL) || (verify_out != NULL) || (check_path != NULL))
+	{
+		if (check_path != NULL)
+		{
+			ret_code = printCheck(ctx, check_path);
+		}
+		else if ((verify_in == NULL) || (verify_out == NULL))
+		{
+			fputs("--verify takes the input and then the output "
+				"of a conversion\n", stderr);
+			ret_code = SDC_FAILURE;
+		}
+		else
+		{
+			ret_code = printVerify(ctx, verify_in, verify_out);
+		}
+
+		if ((trace_path != NULL)
+		&& (sdcWriteTrace(ctx, trace_path) == SDC_FAILURE))
+		{
+			ret_code = SDC_FAILURE;
+		}
+
+		sdcDestroyContext(ctx);
+
+		return ret_code;
 	}
 
 	if (file_path == NULL)
@@ -109,6 +579,7 @@ int main(int argc, char **argv)
 		fputs("Please provide a valid safetensors file path "
 			"to act upon with -i or --input. Pass in -h or "
 			"--help for additional information\n", stderr);
+		sdcDestroyContext(ctx);
 
 		return SDC_FAILURE;
 	}
@@ -121,6 +592,7 @@ int main(int argc, char **argv)
 		fputs("input and output path are identical. If in-place "
 		"conversion is desired please run with the -R, --replace, "
 		"command line switch\n", stderr);
+		sdcDestroyContext(ctx);
 
 		return SDC_FAILURE;
 	}
@@ -134,7 +606,56 @@ int main(int argc, char **argv)
 			"endian systems", stdout);
 	}
 
-	return convertSafetensorFile(file_path, out_path);
+	if ((progress_fd != ULONG_MAX) && ((cli.machine = fdopen(
+		(int) progress_fd, "w")) == NULL))
+	{
+		fprintf(stderr, "Cannot write progress to fd %lu\n",
+			progress_fd);
+		sdcDestroyContext(ctx);
+
+		return SDC_FAILURE;
+	}
+
+	if ((cli.human != NULL) || (cli.machine != NULL))
+	{
+		cli.is_tty = ((cli.human != NULL)
+			&& (isatty(fileno(cli.human)) != 0))
+			? SDC_TRUE : SDC_FALSE;
+		interval = (cli.is_tty == SDC_TRUE) ? SDC_PROGRESS_TTY_SECS
+			: SDC_PROGRESS_LOG_SECS;
+
+		if ((cli.machine != NULL) && (SDC_PROGRESS_FD_SECS < interval))
+		{
+			interval = SDC_PROGRESS_FD_SECS;
+		}
+
+		sdcSetProgress(ctx, reportProgress, &cli,
+			(unsigned) (interval * 1e3));
+	}
+
+	ret_code = (dry_run == SDC_TRUE) ? printEstimate(ctx, file_path)
+		: sdcConvertFile(ctx, file_path, out_path);
+
+	if (cli.machine != NULL)
+	{
+		fclose(cli.machine);
+	}
+
+	if ((stats_path != NULL)
+	&& (writeStats(ctx, stats_path) == SDC_FAILURE))
+	{
+		ret_code = SDC_FAILURE;
+	}
+
+	if ((trace_path != NULL)
+	&& (sdcWriteTrace(ctx, trace_path) == SDC_FAILURE))
+	{
+		ret_code = SDC_FAILURE;
+	}
+
+	sdcDestroyContext(ctx);
+
+	return ret_code;
 }
 
 void printHelp(void)
@@ -142,17 +663,57 @@ void printHelp(void)
 	fputs("SDC, Safetensor Dtype Converter\n\n"
 		"-R, --replace                    :"
 			" Replaces input file with output\n"
-		"-f, --float-out {F32, F16, BF16} :"
-			" Float output type, default F32\n"
+		"-f, --float-out <TYPE>           :"
+			" F32, F16, BF16, auto or lossless\n"
+		"-a, --auto-budget <REL ERROR>    :"
+			" Error allowed by auto, default 2^-8\n"
 		"-i, --input  <FILE PATH>         :"
 			" Safetensor file to be converted\n"
 		"-o, --output <FILE PATH>         :"
 			" Desired output file name\n"
+		"-r, --rule <PATTERN=DTYPE>       :"
+			" Per-tensor output dtype, repeatable\n"
+		"-F, --rules-file <FILE PATH>     :"
+			" Reads --rule lines from a file\n"
+		"-I, --include <PATTERN>          :"
+			" Only converts matching tensors\n"
+		"-X, --exclude <PATTERN>          :"
+			" Leaves matching tensors out\n"
+		"-s, --stats <FILE PATH>          :"
+			" Writes timing statistics as JSON\n"
+		"-p, --progress                   :"
+			" Reports progress on stderr\n"
+		"-P, --progress-fd <FD>           :"
+			" Writes JSON progress lines to FD\n"
+		"-t, --trace <FILE PATH>          :"
+			" Writes a Chrome trace of the conversion\n"
+		"-c, --cache-friendly             :"
+			" Keeps files out of the page cache\n"
+		"-d, --direct-io                  :"
+			" Bypasses the page cache with O_DIRECT\n"
+		"-n, --dry-run                    :"
+			" Prints what converting would take\n"
+		"-V, --verify <IN> <OUT>          :"
+			" Checks OUT is a faithful conversion of IN\n"
+		"-H, --hash                       :"
+			" Stores a hash of every tensor written\n"
+		"-C, --check <FILE PATH>          :"
+			" Checks tensors against their hashes\n"
+		"-j, --jobs <THREADS>             :"
+			" Threads verifying or checking, default "
+			"one per CPU\n"
 		"-v, --verbose                    :"
 			" Enables additional logging\n"
 		"-h, --help                       :"
 			" Prints this help message\n\n"
 		"Example invocation:\n"
-		"./sdc -i ~/.models/foo.safetensors -o bar.safetensors\n",
+		"./sdc -i ~/.models/foo.safetensors -o bar.safetensors\n"
+		"./sdc -i foo.safetensors -f BF16 -r '*norm*=F32' "
+			"-r '*:numel<1M=F32'\n"
+		"./sdc -i foo.safetensors -o lm_head.safetensors "
+			"-I 'lm_head.*'\n"
+		"./sdc --verify foo.safetensors bar.safetensors\n"
+		"./sdc -i foo.safetensors -o bar.safetensors -H && "
+			"./sdc --check bar.safetensors\n",
 		stdout);
 }
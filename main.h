@@ -6,16 +6,10 @@
 #include <float.h>
 #include <string.h>
 
+#include "sdc.h"
 #include "cJSON.h"
 #include "portegg.h"
 
-#define SDC_BOOL    char
-#define SDC_STAT    char
-#define SDC_TRUE    1
-#define SDC_FALSE   0
-#define SDC_SUCCESS 0
-#define SDC_FAILURE 1
-
 /* Structure of a .safetensor file */
 /*
  * A UTF-8 encoded JSON file:
@@ -41,24 +35,6 @@
  * Note that .safetensors files are little-endian encoded 
  */
 
-/* All possible .safetensors dtypes according to the standard */
-enum dataType
-{
-	FLOAT_64 = 0,
-	FLOAT_32,
-	FLOAT_16,
-	BFLOAT_16,
-	SIGNED_64,
-	SIGNED_32,
-	SIGNED_16,
-	SIGNED_8,
-	UNSIGNED_8,
-	BOOLEAN,
-	DTYPE_UNKNOWN,
-	NUM_DATA_TYPE = DTYPE_UNKNOWN,
-	DTYPE_INT_OFF = SIGNED_64
-};
-
 static const char * const dtype_strs[] =
 {
 	"float_64",
@@ -0,0 +1,353 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include "memory.h"
+#include "context.h"
+#include "cJSON.h"
+
+/* The long double keeps what follows the header aligned as malloc's own
+ * blocks would be */
+union allocHeader
+{
+	struct
+	{
+		size_t size;
+		struct sdc_context *owner;
+	} info;
+	long double align;
+};
+
+/* Arena blocks hand out memory from just past themselves */
+struct arenaBlock
+{
+	struct arenaBlock *next;
+	size_t size;
+	long double align;
+};
+
+/* Stands in for the size of anything from an arena so frees skip it */
+#define SDC_ARENA_ITEM SIZE_MAX
+#define SDC_ARENA_MIN  (64 * 1024)
+
+static SDC_THREAD_LOCAL struct sdc_context *json_ctx;
+#ifndef _WIN32
+static pthread_once_t json_hooked = PTHREAD_ONCE_INIT;
+#else
+static SDC_BOOL json_hooked = SDC_FALSE;
+#endif
+
+static void accountAlloc(struct sdc_context *ctx, const size_t size)
+{
+	struct sdcStats *stats = &ctx->stats;
+	size_t name_len;
+
+	stats->mem_current += size;
+
+	if (stats->mem_current <= stats->mem_peak)
+	{
+		return;
+	}
+
+	stats->mem_peak = stats->mem_current;
+	stats->mem_peak_tensor[0] = '\0';
+
+	if (ctx->mem_tensor == NULL)
+	{
+		return;
+	}
+
+	if ((name_len = strlen(ctx->mem_tensor))
+		>= sizeof(stats->mem_peak_tensor))
+	{
+		name_len = sizeof(stats->mem_peak_tensor) - 1;
+	}
+
+	memcpy(stats->mem_peak_tensor, ctx->mem_tensor, name_len);
+	stats->mem_peak_tensor[name_len] = '\0';
+}
+
+void* sdcMalloc(struct sdc_context *ctx, const size_t size)
+{
+	union allocHeader *hdr;
+
+	if ((size > SIZE_MAX - sizeof(*hdr))
+	|| ((hdr = ctx->alloc.malloc_func(ctx->alloc.user,
+		sizeof(*hdr) + size)) == NULL))
+	{
+		return NULL;
+	}
+
+	hdr->info.size  = size;
+	hdr->info.owner = ctx;
+	ctx->stats.mem_allocs++;
+	accountAlloc(ctx, size);
+
+	return hdr + 1;
+}
+
+void* sdcRealloc(struct sdc_context *ctx, void *ptr, const size_t size)
+{
+	union allocHeader *hdr;
+	size_t old_size;
+
+	if (ptr == NULL)
+	{
+		return sdcMalloc(ctx, size);
+	}
+
+	hdr = (union allocHeader *) ptr - 1;
+	old_size = hdr->info.size;
+
+	if ((size > SIZE_MAX - sizeof(*hdr))
+	|| ((hdr = ctx->alloc.realloc_func(ctx->alloc.user, hdr,
+		sizeof(*hdr) + size)) == NULL))
+	{
+		return NULL;
+	}
+
+	hdr->info.size = size;
+	ctx->stats.mem_current -= old_size;
+	ctx->stats.mem_reallocs++;
+	accountAlloc(ctx, size);
+
+	return hdr + 1;
+}
+
+void sdcFree(struct sdc_context *ctx, void *ptr)
+{
+	union allocHeader *hdr;
+
+	if (ptr == NULL)
+	{
+		return;
+	}
+
+	hdr = (union allocHeader *) ptr - 1;
+	ctx->stats.mem_current -= hdr->info.size;
+	ctx->stats.mem_frees++;
+	ctx->alloc.free_func(ctx->alloc.user, hdr);
+}
+
+static SDC_STAT arenaGrow(struct sdc_context *ctx, const size_t size)
+{
+	struct memoryArena *arena = &ctx->json_arena;
+	struct arenaBlock *block;
+
+	if ((size > SIZE_MAX - sizeof(*block))
+	|| ((block = sdcMalloc(ctx, sizeof(*block) + size)) == NULL))
+	{
+		return SDC_FAILURE;
+	}
+
+	block->next   = arena->blocks;
+	block->size   = size;
+	arena->blocks = block;
+	arena->cursor = (char *) (block + 1);
+	arena->left   = size;
+
+	return SDC_SUCCESS;
+}
+
+/* Items keep a header like any other block, marking them as the arena's */
+static void* arenaAlloc(struct sdc_context *ctx, const size_t size)
+{
+	struct memoryArena *arena = &ctx->json_arena;
+	const size_t unit = sizeof(union allocHeader);
+	union allocHeader *hdr;
+	size_t need;
+
+	if (size > SIZE_MAX - (2 * unit))
+	{
+		return NULL;
+	}
+
+	need = unit + (((size + unit - 1) / unit) * unit);
+
+	if (need > arena->left)
+	{
+		const size_t grow = arena->blocks->size * 2;
+
+		if (arenaGrow(ctx, (need > grow) ? need : grow)
+			== SDC_FAILURE)
+		{
+			return NULL;
+		}
+	}
+
+	hdr = (union allocHeader *) arena->cursor;
+	hdr->info.size  = SDC_ARENA_ITEM;
+	hdr->info.owner = ctx;
+	arena->cursor += need;
+	arena->left   -= need;
+	arena->used   += need;
+
+	return hdr + 1;
+}
+
+static void* CJSON_CDECL jsonMalloc(size_t size)
+{
+	union allocHeader *hdr;
+
+	if ((json_ctx != NULL) && (json_ctx->json_arena.active == SDC_TRUE))
+	{
+		return arenaAlloc(json_ctx, size);
+	}
+
+	if (json_ctx != NULL)
+	{
+		return sdcMalloc(json_ctx, size);
+	}
+
+	if ((size > SIZE_MAX - sizeof(*hdr))
+	|| ((hdr = malloc(sizeof(*hdr) + size)) == NULL))
+	{
+		return NULL;
+	}
+
+	hdr->info.size  = size;
+	hdr->info.owner = NULL;
+
+	return hdr + 1;
+}
+
+/* Goes by the owner rather than json_ctx, the tree may outlive the call
+ * that built it */
+static void CJSON_CDECL jsonFree(void *ptr)
+{
+	union allocHeader *hdr;
+
+	if (ptr == NULL)
+	{
+		return;
+	}
+
+	hdr = (union allocHeader *) ptr - 1;
+
+	if (hdr->info.size == SDC_ARENA_ITEM)
+	{
+		return;
+	}
+
+	if (hdr->info.owner != NULL)
+	{
+		sdcFree(hdr->info.owner, ptr);
+	}
+	else
+	{
+		free(hdr);
+	}
+}
+
+static void installJsonHooks(void)
+{
+	struct cJSON_Hooks hooks;
+
+	hooks.malloc_fn = jsonMalloc;
+	hooks.free_fn   = jsonFree;
+	cJSON_InitHooks(&hooks);
+}
+
+/* Contexts may be created on several threads at once. Without pthreads,
+ * on Windows, the first must be created before any others are */
+void memoryInstallJsonHooks(void)
+{
+#ifndef _WIN32
+	pthread_once(&json_hooked, installJsonHooks);
+#else
+	if (json_hooked == SDC_FALSE)
+	{
+		installJsonHooks();
+		json_hooked = SDC_TRUE;
+	}
+#endif
+}
+
+struct sdc_context* memoryEnter(struct sdc_context *ctx)
+{
+	struct sdc_context *prev = json_ctx;
+
+	json_ctx = ctx;
+
+	return prev;
+}
+
+void memoryLeave(struct sdc_context *prev)
+{
+	json_ctx = prev;
+}
+
+SDC_STAT memoryArenaBegin(struct sdc_context *ctx, const size_t size_hint)
+{
+	struct memoryArena *arena = &ctx->json_arena;
+	size_t size = (size_hint > arena->used) ? size_hint : arena->used;
+
+	size = (size > SDC_ARENA_MIN) ? size : SDC_ARENA_MIN;
+
+	if ((arena->blocks != NULL)
+	&& ((arena->blocks->next != NULL) || (arena->blocks->size < size)))
+	{
+		memoryArenaFree(ctx);
+	}
+
+	if ((arena->blocks == NULL) && (arenaGrow(ctx, size) == SDC_FAILURE))
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	arena->cursor = (char *) (arena->blocks + 1);
+	arena->left   = arena->blocks->size;
+	arena->used   = 0;
+	arena->active = SDC_TRUE;
+
+	return SDC_SUCCESS;
+}
+
+/* Allocations go back to the heap, what is in the arena stays valid */
+void memoryArenaEnd(struct sdc_context *ctx)
+{
+	ctx->json_arena.active = SDC_FALSE;
+}
+
+/* Overflowing into more blocks means the next header gets one big enough
+ * for all of them, so they are not worth keeping */
+void memoryArenaRelease(struct sdc_context *ctx)
+{
+	struct memoryArena *arena = &ctx->json_arena;
+
+	arena->active = SDC_FALSE;
+
+	if ((arena->blocks != NULL) && (arena->blocks->next != NULL))
+	{
+		memoryArenaFree(ctx);
+	}
+}
+
+void memoryArenaFree(struct sdc_context *ctx)
+{
+	struct memoryArena *arena = &ctx->json_arena;
+
+	while (arena->blocks != NULL)
+	{
+		struct arenaBlock *next = arena->blocks->next;
+
+		sdcFree(ctx, arena->blocks);
+		arena->blocks = next;
+	}
+
+	arena->cursor = NULL;
+	arena->left   = 0;
+	arena->active = SDC_FALSE;
+}
+
+void memorySetTensor(struct sdc_context *ctx, const char *name)
+{
+	ctx->mem_tensor = name;
+}
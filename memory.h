@@ -0,0 +1,44 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include "main.h"
+
+/* Every block handed out by sdcMalloc and sdcRealloc carries its size and
+ * owning context ahead of it, so frees can be accounted for without a
+ * lookup. The current and peak byte counts live in the context's stats */
+void* sdcMalloc(struct sdc_context *ctx, const size_t size);
+void* sdcRealloc(struct sdc_context *ctx, void *ptr, const size_t size);
+
+/* cJSON only takes global hooks, they charge the context entered on the
+ * calling thread and fall back to malloc outside of one. Installed by
+ * sdcCreateContext, memoryEnter returns the context to pass memoryLeave */
+void memoryInstallJsonHooks(void);
+struct sdc_context* memoryEnter(struct sdc_context *ctx);
+void memoryLeave(struct sdc_context *prev);
+
+/* While active every cJSON allocation made within the context is bumped
+ * out of its arena and freeing one does nothing, the whole tree goes at
+ * once with memoryArenaRelease. A single block is kept for the next
+ * header, should it have taken more the next gets one sized for all of
+ * them, and is only freed along with the context. size_hint is what the
+ * first block should hold */
+struct arenaBlock;
+
+struct memoryArena
+{
+	struct arenaBlock *blocks;
+	char *cursor;
+	size_t left;
+	size_t used;
+	SDC_BOOL active;
+};
+
+SDC_STAT memoryArenaBegin(struct sdc_context *ctx, const size_t size_hint);
+void memoryArenaEnd(struct sdc_context *ctx);
+void memoryArenaRelease(struct sdc_context *ctx);
+void memoryArenaFree(struct sdc_context *ctx);
+
+/* Attributes a new peak to name, NULL outside of any tensor */
+void memorySetTensor(struct sdc_context *ctx, const char *name);
+
+#endif /* MEMORY_H */
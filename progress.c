@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "progress.h"
+#include "context.h"
+#include "stats.h"
+
+static void progressReport(struct sdc_context *ctx, const double now)
+{
+	struct progressState *prog = &ctx->progress;
+	struct sdcProgress *cur = &prog->cur;
+
+	cur->elapsed_secs = now - prog->start;
+	cur->mb_per_sec   = (cur->elapsed_secs > 0.0)
+		? ((double) cur->bytes_done / cur->elapsed_secs) / 1e6 : 0.0;
+	cur->eta_secs     = ((cur->bytes_done > 0)
+		&& (cur->bytes_total >= cur->bytes_done))
+		? ((double) (cur->bytes_total - cur->bytes_done)
+			* cur->elapsed_secs) / (double) cur->bytes_done
+		: -1.0;
+
+	prog->last = now;
+	prog->func(prog->user, cur);
+}
+
+void progressBegin(struct sdc_context *ctx, const enum sdcProgressStage stage,
+	const uint64_t bytes_total, const size_t tensors_total)
+{
+	struct progressState *prog = &ctx->progress;
+
+	if (prog->func == NULL)
+	{
+		return;
+	}
+
+	memset(&prog->cur, 0, sizeof(prog->cur));
+	prog->cur.stage         = stage;
+	prog->cur.bytes_total   = bytes_total;
+	prog->cur.tensors_total = tensors_total;
+	prog->active = SDC_TRUE;
+	prog->start  = monotonicSecs();
+	prog->last   = prog->start;
+}
+
+void progressAdvance(struct sdc_context *ctx, const uint64_t bytes)
+{
+	struct progressState *prog = &ctx->progress;
+	double now;
+
+	if ((prog->func == NULL) || (prog->active == SDC_FALSE))
+	{
+		return;
+	}
+
+	prog->cur.bytes_done += bytes;
+	now = monotonicSecs();
+
+	if ((now - prog->last) >= prog->interval)
+	{
+		progressReport(ctx, now);
+	}
+}
+
+void progressTensor(struct sdc_context *ctx, const char *name,
+	const SDC_BOOL done)
+{
+	struct progressState *prog = &ctx->progress;
+
+	if ((prog->func == NULL) || (prog->active == SDC_FALSE))
+	{
+		return;
+	}
+
+	prog->cur.tensor = name;
+	prog->cur.tensors_done += (done == SDC_TRUE) ? 1 : 0;
+}
+
+void progressEnd(struct sdc_context *ctx)
+{
+	struct progressState *prog = &ctx->progress;
+
+	if ((prog->func == NULL) || (prog->active == SDC_FALSE))
+	{
+		return;
+	}
+
+	prog->cur.tensor   = NULL;
+	prog->cur.finished = SDC_TRUE;
+	progressReport(ctx, monotonicSecs());
+	prog->active = SDC_FALSE;
+}
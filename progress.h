@@ -0,0 +1,27 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include "main.h"
+
+struct progressState
+{
+	sdcProgressFunc func;
+	void *user;
+	double interval;
+	double start;
+	double last;
+	SDC_BOOL active;
+	struct sdcProgress cur;
+};
+
+/* All of these return immediately without a progress callback set, and
+ * progressAdvance otherwise only reads the clock. Callers keep them to
+ * I/O chunk or tensor granularity so none of it lands in the kernels */
+void progressBegin(struct sdc_context *ctx, const enum sdcProgressStage stage,
+	const uint64_t bytes_total, const size_t tensors_total);
+void progressAdvance(struct sdc_context *ctx, const uint64_t bytes);
+void progressTensor(struct sdc_context *ctx, const char *name,
+	const SDC_BOOL done);
+void progressEnd(struct sdc_context *ctx);
+
+#endif /* PROGRESS_H */
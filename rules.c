@@ -0,0 +1,790 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+
+#include "rules.h"
+#include "context.h"
+#include "converting.h"
+
+#define SDC_RULE_LINE_MAX 4096
+
+static const struct
+{
+	const char *str;
+	const enum ruleOp op;
+} op_strs[] =
+{
+	/* Two character operators first so that '<' doesn't eat '<=' */
+	{"<=", OP_LE},
+	{">=", OP_GE},
+	{"==", OP_EQ},
+	{"!=", OP_NE},
+	{"<",  OP_LT},
+	{">",  OP_GT}
+};
+
+static const size_t op_strs_len = sizeof(op_strs) / sizeof(op_strs[0]);
+
+static enum dataType dtypeFromName(const char *str, const size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < dtype_info_len; i++)
+	{
+		if ((strlen(dtype_info[i].name) == len)
+		&& (strncmp(dtype_info[i].name, str, len) == 0))
+		{
+			return dtype_info[i].dtype;
+		}
+	}
+
+	return DTYPE_UNKNOWN;
+}
+
+static SDC_STAT parseCount(const char *str, const size_t len, uint64_t *out)
+{
+	char buf[32] = {0};
+	char *end    = NULL;
+	uint64_t mul = 1;
+
+	if ((len == 0) || (len >= sizeof(buf))
+	|| (isdigit((unsigned char) str[0]) == 0))
+	{
+		return SDC_FAILURE;
+	}
+
+	memcpy(buf, str, len);
+	errno = 0;
+	*out  = (uint64_t) strtoull(buf, &end, 10);
+
+	if (errno == ERANGE)
+	{
+		return SDC_FAILURE;
+	}
+
+	switch (*end)
+	{
+		case 'K': case 'k':
+			mul = 1000;
+			end++;
+			break;
+		case 'M': case 'm':
+			mul = 1000000;
+			end++;
+			break;
+		case 'G': case 'g':
+			mul = 1000000000;
+			end++;
+			break;
+		default:
+			break;
+	}
+
+	if (*out > UINT64_MAX / mul)
+	{
+		return SDC_FAILURE;
+	}
+
+	*out *= mul;
+
+	return (*end == '\0') ? SDC_SUCCESS : SDC_FAILURE;
+}
+
+static SDC_STAT parseCondition(const char *str, const size_t len,
+	struct ruleCondition *cond)
+{
+	const char *cur = str;
+	const char *end = str + len;
+	size_t i;
+
+	if ((len > 5) && (strncmp(cur, "numel", 5) == 0))
+	{
+		cond->field = FIELD_NUMEL;
+		cur += 5;
+	}
+	else if ((len > 4) && (strncmp(cur, "ndim", 4) == 0))
+	{
+		cond->field = FIELD_NDIM;
+		cur += 4;
+	}
+	else if ((len > 5) && (strncmp(cur, "dtype", 5) == 0))
+	{
+		cond->field = FIELD_DTYPE;
+		cur += 5;
+	}
+	else if ((len > 6) && (strncmp(cur, "shape[", 6) == 0))
+	{
+		const char *close = memchr(cur, ']', len);
+		uint64_t dim;
+
+		if ((close == NULL)
+		|| (parseCount(cur + 6, close - (cur + 6), &dim)
+			== SDC_FAILURE))
+		{
+			return SDC_FAILURE;
+		}
+
+		cond->field = FIELD_SHAPE;
+		cond->dim   = (size_t) dim;
+		cur = close + 1;
+	}
+	else
+	{
+		return SDC_FAILURE;
+	}
+
+	for (i = 0; i < op_strs_len; i++)
+	{
+		const size_t op_len = strlen(op_strs[i].str);
+
+		if (((size_t) (end - cur) > op_len)
+		&& (strncmp(cur, op_strs[i].str, op_len) == 0))
+		{
+			cond->op = op_strs[i].op;
+			cur += op_len;
+			break;
+		}
+	}
+
+	if (i == op_strs_len)
+	{
+		return SDC_FAILURE;
+	}
+
+	if (cond->field == FIELD_DTYPE)
+	{
+		const enum dataType dtype = dtypeFromName(cur, end - cur);
+
+		if ((dtype == DTYPE_UNKNOWN)
+		|| ((cond->op != OP_EQ) && (cond->op != OP_NE)))
+		{
+			return SDC_FAILURE;
+		}
+
+		cond->value = (uint64_t) dtype;
+
+		return SDC_SUCCESS;
+	}
+
+	return parseCount(cur, end - cur, &cond->value);
+}
+
+/* Splits out the comma separated conditions from between the pattern and
+ * the target dtype, none of which may be empty */
+static SDC_STAT parseConditions(struct sdc_context *ctx, const char *str,
+	const size_t len, struct dtypeRule *rule)
+{
+	const char *cur = str;
+	const char *end = str + len;
+	size_t count    = 1;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		count += (str[i] == ',') ? 1 : 0;
+	}
+
+	if ((rule->conds = sdcMalloc(ctx, 
+		count * sizeof(struct ruleCondition))) == NULL)
+	{
+		return SDC_FAILURE;
+	}
+
+	memset(rule->conds, 0, count * sizeof(struct ruleCondition));
+
+	while (len > 0)
+	{
+		const char *comma = memchr(cur, ',', end - cur);
+		const char *stop  = (comma != NULL) ? comma : end;
+
+		if (stop == cur)
+		{
+			errorPrintf(ctx, "Empty rule condition\n");
+
+			return SDC_FAILURE;
+		}
+
+		if (parseCondition(cur, stop - cur,
+			&rule->conds[rule->num_conds]) == SDC_FAILURE)
+		{
+			errorPrintf(ctx, "Bad rule condition '%.*s'\n",
+				(int) (stop - cur), cur);
+
+			return SDC_FAILURE;
+		}
+
+		rule->num_conds++;
+
+		if (comma == NULL)
+		{
+			break;
+		}
+
+		cur = comma + 1;
+	}
+
+	return SDC_SUCCESS;
+}
+
+/* Works out the literal prefix and suffix of the pattern which is all most
+ * names need checking against before being rejected */
+static void compilePattern(struct dtypeRule *rule)
+{
+	const char *first = strpbrk(rule->pattern, "*?");
+	size_t i;
+
+	rule->pattern_len = strlen(rule->pattern);
+
+	if (first == NULL)
+	{
+		rule->has_wildcard = SDC_FALSE;
+		rule->prefix_len   = rule->pattern_len;
+		rule->suffix_len   = 0;
+
+		return;
+	}
+
+	rule->has_wildcard = SDC_TRUE;
+	rule->prefix_len   = first - rule->pattern;
+
+	for (i = rule->pattern_len; i > 0; i--)
+	{
+		if ((rule->pattern[i - 1] == '*')
+		|| (rule->pattern[i - 1] == '?'))
+		{
+			break;
+		}
+	}
+
+	rule->suffix_len = rule->pattern_len - i;
+}
+
+/* Takes ownership of the rule's allocations, freeing them on failure */
+static SDC_STAT appendRule(struct sdc_context *ctx, struct ruleSet *set,
+	struct dtypeRule *rule)
+{
+	if (set->len == set->cap)
+	{
+		const size_t new_cap = (set->cap == 0) ? 8 : set->cap * 2;
+		struct dtypeRule *tmp = sdcRealloc(ctx, set->rules,
+			new_cap * sizeof(struct dtypeRule));
+
+		if (tmp == NULL)
+		{
+			errorPrintf(ctx, "%s: Realloc failure\n", __func__);
+			sdcFree(ctx, rule->pattern);
+			sdcFree(ctx, rule->conds);
+
+			return SDC_FAILURE;
+		}
+
+		set->rules = tmp;
+		set->cap   = new_cap;
+	}
+
+	set->rules[set->len++] = *rule;
+
+	return SDC_SUCCESS;
+}
+
+SDC_STAT addDtypeRule(struct sdc_context *ctx, struct ruleSet *set,
+	const char *rule_str)
+{
+	struct dtypeRule rule = {0};
+	const char *equals    = NULL;
+	const char *colon     = NULL;
+	const char *target    = NULL;
+	size_t pattern_len;
+
+	if ((set == NULL) || (rule_str == NULL)
+	|| ((equals = strrchr(rule_str, '=')) == NULL)
+	|| (equals == rule_str))
+	{
+		errorPrintf(ctx, "Bad rule '%s', expected PATTERN=DTYPE\n",
+			(rule_str != NULL) ? rule_str : "");
+
+		return SDC_FAILURE;
+	}
+
+	target = equals + 1;
+
+	if (strcmp(target, "keep") == 0)
+	{
+		rule.keep = SDC_TRUE;
+	}
+	else if (strcmp(target, "auto") == 0)
+	{
+		rule.automatic = AUTO_BUDGET;
+		rule.target    = FLOAT_32;
+	}
+	else if (strcmp(target, "lossless") == 0)
+	{
+		rule.automatic = AUTO_LOSSLESS;
+		rule.target    = FLOAT_32;
+	}
+	else if (((rule.target = dtypeFromName(target, strlen(target)))
+		!= FLOAT_32)
+	&& (rule.target != FLOAT_16) && (rule.target != BFLOAT_16))
+	{
+		errorPrintf(ctx, "Bad rule '%s', target must be one of F32, "
+			"F16, BF16, auto, lossless or keep\n", rule_str);
+
+		return SDC_FAILURE;
+	}
+
+	/* Conditions never contain a colon so the last one starts them, a 
+	 * pattern which itself contains colons can end in an empty ':' */
+	for (colon = equals; (colon > rule_str) && (*colon != ':'); colon--);
+
+	pattern_len = ((*colon == ':') ? colon : equals) - rule_str;
+
+	if ((rule.pattern = sdcMalloc(ctx, pattern_len + 1)) == NULL)
+	{
+		return SDC_FAILURE;
+	}
+
+	memcpy(rule.pattern, rule_str, pattern_len);
+	rule.pattern[pattern_len] = '\0';
+	compilePattern(&rule);
+
+	if ((*colon == ':')
+	&& (parseConditions(ctx, colon + 1, equals - (colon + 1), &rule)
+		== SDC_FAILURE))
+	{
+		errorPrintf(ctx, "Bad rule '%s'\n", rule_str);
+		sdcFree(ctx, rule.pattern);
+		sdcFree(ctx, rule.conds);
+
+		return SDC_FAILURE;
+	}
+
+	return appendRule(ctx, set, &rule);
+}
+
+/* One rule per line of up to SDC_RULE_LINE_MAX - 1 characters, blank lines
+ * and lines starting with '#' are skipped */
+SDC_STAT loadDtypeRules(struct sdc_context *ctx, struct ruleSet *set,
+	const char *file_path)
+{
+	char line[SDC_RULE_LINE_MAX];
+	SDC_STAT ret_code = SDC_SUCCESS;
+	size_t line_num   = 0;
+	FILE *fhandle;
+
+	if ((file_path == NULL) || ((fhandle = fopen(file_path, "r")) == NULL))
+	{
+		errorPrintf(ctx, "%s: Failure to open rules file '%s'\n",
+			__func__, (file_path != NULL) ? file_path : "");
+
+		return SDC_FAILURE;
+	}
+
+	while (fgets(line, sizeof(line), fhandle) != NULL)
+	{
+		char *start = line;
+		size_t len  = strlen(line);
+		int next;
+
+		line_num++;
+
+		/* A full buffer without its newline is only the start of a
+		 * line, the rest must not be taken for a line of its own */
+		if ((len == sizeof(line) - 1) && (line[len - 1] != '\n')
+		&& ((next = fgetc(fhandle)) != EOF) && (next != '\n'))
+		{
+			errorPrintf(ctx, "%s: '%s' line %lu is too long\n",
+				__func__, file_path, line_num);
+			ret_code = SDC_FAILURE;
+
+			break;
+		}
+
+		while (isspace((unsigned char) *start) != 0)
+		{
+			start++;
+		}
+
+		for (len = strlen(start);
+			(len > 0) && (isspace((unsigned char) start[len - 1]));
+			len--);
+
+		start[len] = '\0';
+
+		if ((len == 0) || (start[0] == '#'))
+		{
+			continue;
+		}
+
+		if (addDtypeRule(ctx, set, start) == SDC_FAILURE)
+		{
+			errorPrintf(ctx, "%s: '%s' line %lu\n", __func__,
+				file_path, line_num);
+			ret_code = SDC_FAILURE;
+
+			break;
+		}
+	}
+
+	fclose(fhandle);
+
+	return ret_code;
+}
+
+/* Iterative glob, on a mismatch it backtracks to just after the last '*'
+ * and lets that star swallow one more character */
+static SDC_BOOL globMatch(const char *pat, const char *str)
+{
+	const char *star_pat = NULL;
+	const char *star_str = NULL;
+
+	while (*str != '\0')
+	{
+		if ((*pat == '?') || ((*pat != '*') && (*pat == *str)))
+		{
+			pat++;
+			str++;
+		}
+		else if (*pat == '*')
+		{
+			star_pat = ++pat;
+			star_str = str;
+		}
+		else if (star_pat != NULL)
+		{
+			pat = star_pat;
+			str = ++star_str;
+		}
+		else
+		{
+			return SDC_FALSE;
+		}
+	}
+
+	while (*pat == '*')
+	{
+		pat++;
+	}
+
+	return (*pat == '\0') ? SDC_TRUE : SDC_FALSE;
+}
+
+static SDC_BOOL nameMatches(const struct dtypeRule *rule, const char *name,
+	const size_t name_len)
+{
+	if (rule->has_wildcard == SDC_FALSE)
+	{
+		return ((name_len == rule->pattern_len)
+			&& (memcmp(name, rule->pattern, name_len) == 0))
+			? SDC_TRUE : SDC_FALSE;
+	}
+
+	if ((name_len < rule->prefix_len + rule->suffix_len)
+	|| (memcmp(name, rule->pattern, rule->prefix_len) != 0)
+	|| (memcmp(name + name_len - rule->suffix_len,
+		rule->pattern + rule->pattern_len - rule->suffix_len,
+		rule->suffix_len) != 0))
+	{
+		return SDC_FALSE;
+	}
+
+	/* A lone '*' between the literals needs no further checking */
+	if (rule->prefix_len + rule->suffix_len + 1 == rule->pattern_len)
+	{
+		return ((rule->pattern[rule->prefix_len] == '*')
+			|| (name_len == rule->pattern_len))
+			? SDC_TRUE : SDC_FALSE;
+	}
+
+	return globMatch(rule->pattern, name);
+}
+
+static SDC_BOOL compare(const uint64_t left, const enum ruleOp op,
+	const uint64_t right)
+{
+	switch (op)
+	{
+		case OP_LT: return (left <  right) ? SDC_TRUE : SDC_FALSE;
+		case OP_LE: return (left <= right) ? SDC_TRUE : SDC_FALSE;
+		case OP_GT: return (left >  right) ? SDC_TRUE : SDC_FALSE;
+		case OP_GE: return (left >= right) ? SDC_TRUE : SDC_FALSE;
+		case OP_EQ: return (left == right) ? SDC_TRUE : SDC_FALSE;
+		case OP_NE: return (left != right) ? SDC_TRUE : SDC_FALSE;
+		default:    return SDC_FALSE;
+	}
+}
+
+static SDC_BOOL conditionsHold(const struct dtypeRule *rule,
+	const struct tensorDesc *desc)
+{
+	size_t i;
+
+	for (i = 0; i < rule->num_conds; i++)
+	{
+		const struct ruleCondition *cond = &rule->conds[i];
+		uint64_t value;
+
+		switch (cond->field)
+		{
+			case FIELD_NUMEL:
+				value = desc->numel;
+				break;
+			case FIELD_NDIM:
+				value = desc->ndim;
+				break;
+			case FIELD_SHAPE:
+				/* Missing dimensions never satisfy anything */
+				if (cond->dim >= desc->ndim)
+				{
+					return SDC_FALSE;
+				}
+
+				value = desc->shape[cond->dim];
+				break;
+			case FIELD_DTYPE:
+				value = (uint64_t) desc->dtype;
+				break;
+			default:
+				return SDC_FALSE;
+		}
+
+		if (compare(value, cond->op, cond->value) == SDC_FALSE)
+		{
+			return SDC_FALSE;
+		}
+	}
+
+	return SDC_TRUE;
+}
+
+/* Returns the first rule matching the tensor or NULL should none */
+const struct dtypeRule* matchDtypeRule(const struct ruleSet *set,
+	const struct tensorDesc *desc)
+{
+	size_t name_len;
+	size_t i;
+
+	if ((set == NULL) || (set->len == 0) || (desc == NULL))
+	{
+		return NULL;
+	}
+
+	name_len = strlen(desc->name);
+
+	for (i = 0; i < set->len; i++)
+	{
+		if ((nameMatches(&set->rules[i], desc->name, name_len)
+			== SDC_TRUE)
+		&& (conditionsHold(&set->rules[i], desc) == SDC_TRUE))
+		{
+			return &set->rules[i];
+		}
+	}
+
+	return NULL;
+}
+
+void freeDtypeRules(struct sdc_context *ctx, struct ruleSet *set)
+{
+	size_t i;
+
+	if (set == NULL)
+	{
+		return;
+	}
+
+	for (i = 0; i < set->len; i++)
+	{
+		sdcFree(ctx, set->rules[i].pattern);
+		sdcFree(ctx, set->rules[i].conds);
+	}
+
+	sdcFree(ctx, set->rules);
+	set->rules = NULL;
+	set->len   = 0;
+	set->cap   = 0;
+}
+
+SDC_STAT addNamePattern(struct sdc_context *ctx, struct ruleSet *set,
+	const char *pattern)
+{
+	struct dtypeRule rule = {0};
+	size_t len;
+
+	if ((set == NULL) || (pattern == NULL) || (*pattern == '\0'))
+	{
+		errorPrintf(ctx, "%s: Empty name pattern\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	len = strlen(pattern);
+
+	if ((rule.pattern = sdcMalloc(ctx, len + 1)) == NULL)
+	{
+		return SDC_FAILURE;
+	}
+
+	memcpy(rule.pattern, pattern, len + 1);
+	rule.keep = SDC_TRUE;
+	compilePattern(&rule);
+
+	return appendRule(ctx, set, &rule);
+}
+
+/* FNV-1a, tensor names are short and this is only run once per header */
+static uint64_t hashName(const char *name)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	for (; *name != '\0'; name++)
+	{
+		hash ^= (unsigned char) *name;
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+/* Open addressing over indices into names, at most half full */
+SDC_STAT buildNameIndex(struct sdc_context *ctx,
+	struct nameIndex *index, const char *const *names, const size_t len)
+{
+	size_t i;
+
+	index->names = names;
+	index->len   = len;
+
+	for (index->cap = 16; index->cap < len * 2; index->cap *= 2);
+
+	if ((index->slots = sdcMalloc(ctx, index->cap * sizeof(size_t)))
+		== NULL)
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	memset(index->slots, 0xff, index->cap * sizeof(size_t));
+
+	for (i = 0; i < len; i++)
+	{
+		size_t slot = hashName(names[i]) & (index->cap - 1);
+
+		while (index->slots[slot] != SIZE_MAX)
+		{
+			slot = (slot + 1) & (index->cap - 1);
+		}
+
+		index->slots[slot] = i;
+	}
+
+	return SDC_SUCCESS;
+}
+
+/* Marks every name equal to the pattern, duplicates included */
+static size_t lookupName(const struct nameIndex *index, const char *name,
+	SDC_BOOL *selected, const SDC_BOOL mark)
+{
+	size_t slot = hashName(name) & (index->cap - 1);
+	size_t hits = 0;
+
+	for (; index->slots[slot] != SIZE_MAX;
+		slot = (slot + 1) & (index->cap - 1))
+	{
+		if (strcmp(index->names[index->slots[slot]], name) == 0)
+		{
+			selected[index->slots[slot]] = mark;
+			hits++;
+		}
+	}
+
+	return hits;
+}
+
+/* The first of names equal to name, SIZE_MAX if there is none */
+size_t findName(const struct nameIndex *index, const char *name)
+{
+	size_t slot = hashName(name) & (index->cap - 1);
+	size_t found = SIZE_MAX;
+
+	for (; index->slots[slot] != SIZE_MAX;
+		slot = (slot + 1) & (index->cap - 1))
+	{
+		if ((strcmp(index->names[index->slots[slot]], name) == 0)
+		&& (index->slots[slot] < found))
+		{
+			found = index->slots[slot];
+		}
+	}
+
+	return found;
+}
+
+static void applyPatterns(struct sdc_context *ctx,
+	const struct ruleSet *set, const struct nameIndex *index,
+	SDC_BOOL *selected, const SDC_BOOL mark)
+{
+	size_t i, j;
+
+	for (i = 0; i < set->len; i++)
+	{
+		const struct dtypeRule *rule = &set->rules[i];
+		size_t hits = 0;
+
+		if (rule->has_wildcard == SDC_FALSE)
+		{
+			hits = lookupName(index, rule->pattern, selected, mark);
+		}
+		else
+		{
+			for (j = 0; j < index->len; j++)
+			{
+				if (nameMatches(rule, index->names[j],
+					strlen(index->names[j])) == SDC_TRUE)
+				{
+					selected[j] = mark;
+					hits++;
+				}
+			}
+		}
+
+		if (hits == 0)
+		{
+			sdcLog(ctx, SDC_LOG_WARNING, "Pattern '%s' matches no "
+				"tensor\n", rule->pattern);
+		}
+	}
+}
+
+/* Includes are applied before excludes whatever order they were given in,
+ * with no includes every name starts out selected */
+SDC_STAT selectNames(struct sdc_context *ctx, const struct nameFilter *filter,
+	const char *const *names, const size_t len, SDC_BOOL *selected)
+{
+	struct nameIndex index = {0};
+	size_t i;
+
+	if (buildNameIndex(ctx, &index, names, len) == SDC_FAILURE)
+	{
+		return SDC_FAILURE;
+	}
+
+	for (i = 0; i < len; i++)
+	{
+		selected[i] = (filter->include.len == 0) ? SDC_TRUE : SDC_FALSE;
+	}
+
+	applyPatterns(ctx, &filter->include, &index, selected, SDC_TRUE);
+	applyPatterns(ctx, &filter->exclude, &index, selected, SDC_FALSE);
+	sdcFree(ctx, index.slots);
+
+	return SDC_SUCCESS;
+}
+
+void freeNameFilter(struct sdc_context *ctx, struct nameFilter *filter)
+{
+	freeDtypeRules(ctx, &filter->include);
+	freeDtypeRules(ctx, &filter->exclude);
+}
@@ -0,0 +1,125 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include "main.h"
+
+/* Per-tensor output dtype rules of the form:
+ *
+ * 	PATTERN[:CONDITION[,CONDITION...]]=DTYPE
+ *
+ * 	PATTERN   : glob over the tensor name, '*' matches any run of
+ * 	            characters and '?' any single character
+ * 	CONDITION : FIELD OP VALUE, FIELD being one of numel, ndim,
+ * 	            shape[N] or dtype and OP one of <, <=, >, >=, ==, !=.
+ * 	            Numeric values may carry a K, M or G (10^3, 10^6, 10^9)
+ * 	            suffix while dtype is compared against a dtype name
+ * 	            using == or != only
+ * 	DTYPE     : F32, F16, BF16, auto or lossless as -f does them or
+ * 	            keep to leave the tensor untouched
+ *
+ * 	eg: '*norm*=F32', '*:numel<1M=F32', '*.weight:ndim==2=BF16'
+ *
+ * Rules are tried in the order given and the first match wins, tensors no
+ * rule matches fall back on the --float-type default */
+
+/* How a tensor's dtype is settled from a scan of its data, -f auto picks
+ * within a relative error budget while lossless only narrows exactly */
+enum autoMode
+{
+	AUTO_OFF = 0,
+	AUTO_BUDGET,
+	AUTO_LOSSLESS
+};
+
+enum ruleField
+{
+	FIELD_NUMEL = 0,
+	FIELD_NDIM,
+	FIELD_SHAPE,
+	FIELD_DTYPE
+};
+
+enum ruleOp
+{
+	OP_LT = 0,
+	OP_LE,
+	OP_GT,
+	OP_GE,
+	OP_EQ,
+	OP_NE
+};
+
+struct ruleCondition
+{
+	enum ruleField field;
+	enum ruleOp op;
+	size_t dim;      /* FIELD_SHAPE only */
+	uint64_t value;  /* dtype enum value for FIELD_DTYPE */
+};
+
+struct dtypeRule
+{
+	char *pattern;
+	size_t prefix_len;  /* literal characters before the first wildcard */
+	size_t suffix_len;  /* literal characters after the last wildcard */
+	size_t pattern_len;
+	SDC_BOOL has_wildcard;
+	struct ruleCondition *conds;
+	size_t num_conds;
+	SDC_BOOL keep;
+	enum autoMode automatic;  /* target is the F32 fallback */
+	enum dataType target;
+};
+
+struct ruleSet
+{
+	struct dtypeRule *rules;
+	size_t len;
+	size_t cap;
+};
+
+/* What the rules get to look at for each tensor */
+struct tensorDesc
+{
+	const char *name;
+	enum dataType dtype;
+	const size_t *shape;
+	size_t ndim;
+	size_t numel;
+};
+
+/* Tensor subset selection by --include and --exclude name patterns, which
+ * are globs as above without conditions. Names are hashed so patterns
+ * without wildcards are looked up rather than tried against every name */
+struct nameFilter
+{
+	struct ruleSet include;
+	struct ruleSet exclude;
+};
+
+struct nameIndex
+{
+	const char *const *names;
+	size_t *slots;  /* SIZE_MAX when empty */
+	size_t len;
+	size_t cap;     /* a power of two */
+};
+
+SDC_STAT addDtypeRule(struct sdc_context *ctx, struct ruleSet *set,
+	const char *rule);
+SDC_STAT loadDtypeRules(struct sdc_context *ctx, struct ruleSet *set,
+	const char *file_path);
+const struct dtypeRule* matchDtypeRule(const struct ruleSet *set,
+	const struct tensorDesc *desc);
+void freeDtypeRules(struct sdc_context *ctx, struct ruleSet *set);
+SDC_STAT addNamePattern(struct sdc_context *ctx, struct ruleSet *set,
+	const char *pattern);
+SDC_STAT selectNames(struct sdc_context *ctx, const struct nameFilter *filter,
+	const char *const *names, const size_t len, SDC_BOOL *selected);
+/* names must outlive the index, whose slots are freed with sdcFree */
+SDC_STAT buildNameIndex(struct sdc_context *ctx, struct nameIndex *index,
+	const char *const *names, const size_t len);
+size_t findName(const struct nameIndex *index, const char *name);
+void freeNameFilter(struct sdc_context *ctx, struct nameFilter *filter);
+
+#endif /* RULES_H */
@@ -0,0 +1,314 @@
+#ifndef SDC_H
+#define SDC_H
+
+/* Public interface of libsdc, everything else is internal to the library.
+ *
+ * A conversion context carries all the options, statistics, allocator and
+ * logging state of a conversion so any number of them may be used at once,
+ * one context must not be used by two threads at the same time however.
+ * On Windows the first context must be created before any others are */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Only what is declared here is exported from the shared library, the
+ * rest, the bundled cJSON included, is built with hidden visibility */
+#if defined(_WIN32) && defined(SDC_BUILD_DLL)
+#define SDC_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#define SDC_API __attribute__((visibility("default")))
+#else
+#define SDC_API
+#endif
+
+#define SDC_BOOL    char
+#define SDC_STAT    char
+#define SDC_TRUE    1
+#define SDC_FALSE   0
+#define SDC_SUCCESS 0
+#define SDC_FAILURE 1
+
+/* Longer tensor names are truncated in the statistics */
+#define SDC_PEAK_NAME_LEN 128
+
+/* All possible .safetensors dtypes according to the standard */
+enum dataType
+{
+	FLOAT_64 = 0,
+	FLOAT_32,
+	FLOAT_16,
+	BFLOAT_16,
+	SIGNED_64,
+	SIGNED_32,
+	SIGNED_16,
+	SIGNED_8,
+	UNSIGNED_8,
+	BOOLEAN,
+	DTYPE_UNKNOWN,
+	NUM_DATA_TYPE = DTYPE_UNKNOWN,
+	DTYPE_INT_OFF = SIGNED_64
+};
+
+enum sdcLogLevel
+{
+	SDC_LOG_ERROR = 0,
+	SDC_LOG_WARNING,
+	SDC_LOG_INFO  /* only delivered with verbose output enabled */
+};
+
+/* Receives each fully formatted message, the default logger prints errors
+ * and warnings to stderr and everything else to stdout */
+typedef void (*sdcLogFunc)(void *user, const enum sdcLogLevel level,
+	const char *msg);
+
+/* Used for every tensor buffer, the parsed header, the output of
+ * sdcConvertBuffer and the context itself. The functions behave like their
+ * stdlib namesakes. Only when linking the static library is the bundled
+ * cJSON shared with the program, whose global hooks sdcCreateContext then
+ * sets, so its cJSON objects must not be carried across the first call */
+struct sdcAllocator
+{
+	void* (*malloc_func)(void *user, size_t size);
+	void* (*realloc_func)(void *user, void *ptr, size_t size);
+	void  (*free_func)(void *user, void *ptr);
+	void *user;
+};
+
+/* Stages of a conversion timed when statistics collection is enabled, the
+ * data read through data write phases repeat for every tensor */
+enum sdcPhase
+{
+	SDC_PHASE_HEADER_READ = 0,
+	SDC_PHASE_JSON_PARSE,
+	SDC_PHASE_RANGE_SCAN,
+	SDC_PHASE_HEADER_SERIALIZE,
+	SDC_PHASE_DATA_READ,
+	SDC_PHASE_ENDIAN,
+	SDC_PHASE_CONVERT,
+	SDC_PHASE_HASH,
+	SDC_PHASE_DATA_WRITE,
+	SDC_PHASE_SYNC,
+	SDC_NUM_PHASES
+};
+
+/* Precision lost converting, measured against the input value. Values
+ * beyond the output's largest finite value saturate to it and are counted
+ * as overflow, which is left out of the errors as are NaNs. Those that
+ * came out as zero from a non-zero input are counted as underflow and are
+ * included, at a relative error of 1 */
+struct sdcConvError
+{
+	double max_abs;
+	double max_rel;
+	uint64_t overflow;
+	uint64_t underflow;
+	uint64_t nan;
+};
+
+struct sdcStats
+{
+	size_t tensors_total;
+	size_t tensors_loaded;
+	uint64_t bytes_read;
+	uint64_t bytes_written;
+	/* Number of tensors converted from, and to, each dtype */
+	size_t type_in[NUM_DATA_TYPE];
+	size_t type_out[NUM_DATA_TYPE];
+	/* Only filled in with statistics collection enabled */
+	double total_secs;
+	double phase_secs[SDC_NUM_PHASES];
+	/* Bytes held through the context allocator, the peak names the tensor
+	 * being converted when it was reached, empty if outside of one. The
+	 * predicted peak is worked out from the header before converting,
+	 * with statistics collection enabled */
+	uint64_t mem_current;
+	uint64_t mem_peak;
+	uint64_t mem_predicted_peak;
+	size_t mem_allocs;
+	size_t mem_reallocs;
+	size_t mem_frees;
+	char mem_peak_tensor[SDC_PEAK_NAME_LEN];
+	/* Worst over every converted tensor, counts summed, with statistics
+	 * collection enabled */
+	struct sdcConvError error;
+};
+
+/* What a conversion would take with the context's current options, worked
+ * out from the header and, with auto or lossless, a scan of the tensors
+ * those settle by their data. Direct I/O reads and writes whole blocks so
+ * those byte counts cover the padding. Files are written next to their
+ * destination first, so output_bytes must be free there, in-place too */
+struct sdcEstimate
+{
+	size_t tensors;
+	uint64_t output_bytes;   /* exact, the length prefix included */
+	uint64_t header_bytes;   /* of the output header */
+	uint64_t bytes_read;
+	uint64_t bytes_written;
+	uint64_t peak_memory;    /* as mem_predicted_peak of the stats */
+	/* Tensors and their data bytes by dtype, going in and coming out */
+	size_t tensors_in[NUM_DATA_TYPE];
+	uint64_t bytes_in[NUM_DATA_TYPE];
+	size_t tensors_out[NUM_DATA_TYPE];
+	uint64_t bytes_out[NUM_DATA_TYPE];
+};
+
+/* Tensors are counted over the output, those failing to match their
+ * input or with values out of tolerance being bad. Tensors of the input
+ * missing from the output are only counted, filtering drops them */
+struct sdcVerifyReport
+{
+	size_t tensors;
+	size_t missing;
+	size_t bad_tensors;
+	uint64_t elements;
+	uint64_t violations;
+	uint64_t saturated;
+	uint64_t bytes;         /* of tensor data compared, both files */
+	double max_abs;
+	double max_rel;
+	double seconds;
+	unsigned threads;
+};
+
+/* Tensors are counted over the file, those without a hash or whose data
+ * no longer matches it being bad */
+struct sdcCheckReport
+{
+	size_t tensors;
+	size_t unhashed;
+	size_t mismatched;
+	uint64_t bytes;         /* of tensor data hashed */
+	double seconds;
+	unsigned threads;
+};
+
+/* Every tensor is read, converted and written out in the convert stage,
+ * file output is then flushed to disk and moved into place. With -f auto
+ * the tensors being decided on are read through first in a scan stage */
+enum sdcProgressStage
+{
+	SDC_STAGE_CONVERT = 0,
+	SDC_STAGE_SYNC,
+	SDC_STAGE_SCAN
+};
+
+struct sdcProgress
+{
+	enum sdcProgressStage stage;
+	uint64_t bytes_done;
+	uint64_t bytes_total;
+	size_t tensors_done;
+	size_t tensors_total;
+	const char *tensor;    /* being worked on, NULL while syncing */
+	double elapsed_secs;   /* since the stage began */
+	double mb_per_sec;
+	double eta_secs;       /* negative until there is a rate to go by */
+	SDC_BOOL finished;     /* last report of the stage */
+};
+
+/* Called from the conversion thread at most once per interval, plus once
+ * as each stage finishes, the pointed to data only lives for the call */
+typedef void (*sdcProgressFunc)(void *user,
+	const struct sdcProgress *progress);
+
+struct sdc_context;
+
+/* Passing NULL for the allocator uses malloc, realloc and free */
+SDC_API struct sdc_context* sdcCreateContext(const struct sdcAllocator *alloc);
+SDC_API void sdcDestroyContext(struct sdc_context *ctx);
+
+/* Options, these persist across conversions made with the context */
+/* F32, F16, BF16 or auto, which scans each F64 and F32 tensor and picks
+ * the narrowest float dtype whose worst case relative error, saturation
+ * ruled out, is within the budget. Budgets must be positive. lossless
+ * narrows F64, F32 and I64 tensors only where every value converts 
+ * exactly, keeping everything else */
+SDC_API SDC_STAT sdcSetFloatOut(struct sdc_context *ctx,
+	const char *dtype_name);
+SDC_API SDC_STAT sdcSetAutoBudget(struct sdc_context *ctx,
+	const double max_rel);
+SDC_API void sdcSetVerbose(struct sdc_context *ctx, const SDC_BOOL verbose);
+SDC_API void sdcSetInplace(struct sdc_context *ctx, const SDC_BOOL inplace);
+/* Drops input pages from the page cache once read, and output pages once
+ * on disk, so converting does not evict everything else. Only has an
+ * effect on systems with posix_fadvise */
+SDC_API void sdcSetCacheFriendly(struct sdc_context *ctx,
+	const SDC_BOOL enabled);
+/* Reads and writes files with O_DIRECT, bypassing the page cache entirely
+ * for conversions larger than memory. Falls back to buffered I/O wherever
+ * O_DIRECT is unsupported */
+SDC_API void sdcSetDirectIO(struct sdc_context *ctx, const SDC_BOOL enabled);
+/* Stores a hash of every output tensor in __metadata__, for sdcCheckFile.
+ * The output must be a regular file or memory, as the hashes go into the
+ * header once the data is written */
+SDC_API void sdcSetHash(struct sdc_context *ctx, const SDC_BOOL enabled);
+/* Threads verifying or checking, 0 for one per online CPU, the default */
+SDC_API void sdcSetThreads(struct sdc_context *ctx, const unsigned threads);
+SDC_API void sdcSetLogger(struct sdc_context *ctx, const sdcLogFunc func,
+	void *user);
+SDC_API void sdcSetProgress(struct sdc_context *ctx, const sdcProgressFunc func,
+	void *user, const unsigned interval_ms);
+SDC_API SDC_STAT sdcAddRule(struct sdc_context *ctx, const char *rule);
+SDC_API SDC_STAT sdcLoadRules(struct sdc_context *ctx, const char *file_path);
+/* Only tensors matching an include pattern, or every tensor should there be
+ * none, and no exclude pattern are read and written out. Patterns are globs
+ * over the tensor name like those of the rules */
+SDC_API SDC_STAT sdcAddInclude(struct sdc_context *ctx, const char *pattern);
+SDC_API SDC_STAT sdcAddExclude(struct sdc_context *ctx, const char *pattern);
+
+/* With in-place conversion enabled out_path is ignored. Regular files are
+ * replaced atomically, a failed conversion leaves them as they were */
+SDC_API SDC_STAT sdcConvertFile(struct sdc_context *ctx, const char *in_path,
+	const char *out_path);
+
+/* On success *out holds the converted file, allocated through the
+ * context's allocator and to be released with sdcFree */
+SDC_API SDC_STAT sdcConvertBuffer(struct sdc_context *ctx, const void *in,
+	const size_t in_len, void **out, size_t *out_len);
+SDC_API void sdcFree(struct sdc_context *ctx, void *ptr);
+
+/* A dry run of sdcConvertFile or sdcConvertBuffer, nothing is written.
+ * Only auto and lossless read tensor data, to scan what they must */
+SDC_API SDC_STAT sdcEstimateFile(struct sdc_context *ctx, const char *in_path,
+	struct sdcEstimate *est);
+SDC_API SDC_STAT sdcEstimateBuffer(struct sdc_context *ctx, const void *in,
+	const size_t in_len, struct sdcEstimate *est);
+
+/* Checks a conversion's output against its input, both files mapped into
+ * memory. Tensors are matched by name and must keep their shape, values
+ * must be within a unit in the last place of the input, or a step of the
+ * subnormals, after saturating to the output dtype's range. Integers and
+ * tensors whose dtype is unchanged must be exact. Fails only on I/O or
+ * invalid headers, the report tells of anything else */
+SDC_API SDC_STAT sdcVerifyFile(struct sdc_context *ctx, const char *in_path,
+	const char *out_path, struct sdcVerifyReport *report);
+
+/* Checks every tensor of a file written with hashing enabled against its
+ * stored hash, mapped into memory and hashed in parallel. Fails only on
+ * I/O, invalid headers or there being no hashes at all, the report tells
+ * of anything else */
+SDC_API SDC_STAT sdcCheckFile(struct sdc_context *ctx, const char *path,
+	struct sdcCheckReport *report);
+
+/* Records when each tensor is read, converted and written, along with the
+ * whole-file phases, per thread. Enabling it drops anything previously
+ * recorded, disabling keeps the events for sdcWriteTrace which writes them
+ * out in the Chrome Trace Event format, viewable in Perfetto */
+SDC_API void sdcSetTrace(struct sdc_context *ctx, const SDC_BOOL enabled);
+SDC_API SDC_STAT sdcWriteTrace(struct sdc_context *ctx, const char *path);
+
+/* Statistics accumulate across conversions until reset. Enabling their
+ * collection adds per-phase timings and a record for every tensor */
+SDC_API void sdcSetCollectStats(struct sdc_context *ctx,
+	const SDC_BOOL collect);
+SDC_API const struct sdcStats* sdcGetStats(const struct sdc_context *ctx);
+SDC_API void sdcResetStats(struct sdc_context *ctx);
+
+/* The statistics, per-tensor records included, as a JSON document to be
+ * released with sdcFree, NULL on failure */
+SDC_API char* sdcStatsJson(struct sdc_context *ctx);
+
+SDC_API const char* sdcDtypeName(const enum dataType dtype);
+
+#endif /* SDC_H */
@@ -0,0 +1,283 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "stats.h"
+#include "context.h"
+#include "converting.h"
+#include "cJSON.h"
+
+static const char * const phase_strs[SDC_NUM_PHASES] =
+{
+	"header_read",
+	"json_parse",
+	"range_scan",
+	"header_serialize",
+	"data_read",
+	"endianness",
+	"convert",
+	"hash",
+	"data_write",
+	"sync"
+};
+
+double monotonicSecs(void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double) ts.tv_sec + ((double) ts.tv_nsec * 1e-9);
+#else
+	return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+double statsNow(const struct sdc_context *ctx)
+{
+	return (ctx->collect_stats == SDC_TRUE) ? monotonicSecs() : 0.0;
+}
+
+double statsLap(struct sdc_context *ctx, const enum sdcPhase phase,
+	struct tensorStats *rec, const double start)
+{
+	double now, elapsed;
+
+	if (ctx->collect_stats == SDC_FALSE)
+	{
+		return 0.0;
+	}
+
+	now = statsNow(ctx);
+	elapsed = now - start;
+	ctx->stats.phase_secs[phase] += elapsed;
+	ctx->stats.total_secs += elapsed;
+
+	if (rec != NULL)
+	{
+		rec->phase_secs[phase] += elapsed;
+	}
+
+	return now;
+}
+
+struct tensorStats* statsAddTensor(struct sdc_context *ctx,
+	const char *name, const enum dataType in_type)
+{
+	struct statsLog *log = &ctx->stats_log;
+	struct tensorStats *rec;
+	const size_t name_len = strlen(name) + 1;
+
+	if (ctx->collect_stats == SDC_FALSE)
+	{
+		return NULL;
+	}
+
+	if (log->len == log->cap)
+	{
+		const size_t new_cap = (log->cap == 0) ? 64 : log->cap * 2;
+		struct tensorStats *tmp = sdcRealloc(ctx, log->tensors,
+			new_cap * sizeof(*tmp));
+
+		if (tmp == NULL)
+		{
+			errorPrintf(ctx, "%s: Realloc failure\n", __func__);
+
+			return NULL;
+		}
+
+		log->tensors = tmp;
+		log->cap     = new_cap;
+	}
+
+	rec = &log->tensors[log->len];
+	memset(rec, 0, sizeof(*rec));
+
+	if ((rec->name = sdcMalloc(ctx, name_len)) == NULL)
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+
+		return NULL;
+	}
+
+	memcpy(rec->name, name, name_len);
+	rec->in_type  = in_type;
+	rec->out_type = in_type;
+	log->len++;
+
+	return rec;
+}
+
+void statsClear(struct sdc_context *ctx)
+{
+	struct statsLog *log = &ctx->stats_log;
+	size_t i;
+
+	for (i = 0; i < log->len; i++)
+	{
+		sdcFree(ctx, log->tensors[i].name);
+	}
+
+	sdcFree(ctx, log->tensors);
+	memset(log, 0, sizeof(*log));
+}
+
+static double mbPerSec(const uint64_t bytes, const double secs)
+{
+	return (secs > 0.0) ? ((double) bytes / secs) / 1e6 : 0.0;
+}
+
+static struct cJSON* phasesToJson(const double *phase_secs,
+	const double total)
+{
+	struct cJSON *phases = cJSON_CreateObject();
+	size_t i;
+
+	for (i = 0; (phases != NULL) && (i < SDC_NUM_PHASES); i++)
+	{
+		struct cJSON *phase = cJSON_AddObjectToObject(phases,
+			phase_strs[i]);
+
+		cJSON_AddNumberToObject(phase, "secs", phase_secs[i]);
+		cJSON_AddNumberToObject(phase, "share", (total > 0.0)
+			? phase_secs[i] / total : 0.0);
+	}
+
+	return phases;
+}
+
+static struct cJSON* errorToJson(const struct sdcConvError *err)
+{
+	struct cJSON *obj = cJSON_CreateObject();
+
+	cJSON_AddNumberToObject(obj, "max_abs", err->max_abs);
+	cJSON_AddNumberToObject(obj, "max_rel", err->max_rel);
+	cJSON_AddNumberToObject(obj, "overflow", (double) err->overflow);
+	cJSON_AddNumberToObject(obj, "underflow", (double) err->underflow);
+	cJSON_AddNumberToObject(obj, "nan", (double) err->nan);
+
+	return obj;
+}
+
+static struct cJSON* tensorToJson(const struct tensorStats *rec)
+{
+	struct cJSON *obj = cJSON_CreateObject();
+	double total = 0.0;
+	size_t i;
+
+	for (i = 0; i < SDC_NUM_PHASES; i++)
+	{
+		total += rec->phase_secs[i];
+	}
+
+	cJSON_AddStringToObject(obj, "name", rec->name);
+	cJSON_AddStringToObject(obj, "dtype_in", sdcDtypeName(rec->in_type));
+	cJSON_AddStringToObject(obj, "dtype_out",
+		sdcDtypeName(rec->out_type));
+	cJSON_AddNumberToObject(obj, "bytes_in", (double) rec->bytes_in);
+	cJSON_AddNumberToObject(obj, "bytes_out", (double) rec->bytes_out);
+	cJSON_AddNumberToObject(obj, "secs", total);
+	cJSON_AddNumberToObject(obj, "mb_per_sec",
+		mbPerSec(rec->bytes_in, total));
+	cJSON_AddItemToObject(obj, "phases",
+		phasesToJson(rec->phase_secs, total));
+
+	/* Tensors kept as they are lose nothing */
+	if (rec->out_type != rec->in_type)
+	{
+		cJSON_AddItemToObject(obj, "error", errorToJson(&rec->error));
+	}
+
+	return obj;
+}
+
+char* sdcStatsJson(struct sdc_context *ctx)
+{
+	const struct sdcStats *stats = &ctx->stats;
+	struct cJSON *root    = NULL;
+	struct cJSON *dtypes  = NULL;
+	struct cJSON *memory  = NULL;
+	struct cJSON *tensors = NULL;
+	char *printed         = NULL;
+	char *out             = NULL;
+	size_t i, out_len;
+
+	if ((root = cJSON_CreateObject()) == NULL)
+	{
+		return NULL;
+	}
+
+	cJSON_AddNumberToObject(root, "tensors_total",
+		(double) stats->tensors_total);
+	cJSON_AddNumberToObject(root, "tensors_loaded",
+		(double) stats->tensors_loaded);
+	cJSON_AddNumberToObject(root, "bytes_in", (double) stats->bytes_read);
+	cJSON_AddNumberToObject(root, "bytes_out",
+		(double) stats->bytes_written);
+	cJSON_AddNumberToObject(root, "secs", stats->total_secs);
+	cJSON_AddNumberToObject(root, "mb_per_sec_in",
+		mbPerSec(stats->bytes_read, stats->total_secs));
+	cJSON_AddNumberToObject(root, "mb_per_sec_out",
+		mbPerSec(stats->bytes_written, stats->total_secs));
+	cJSON_AddItemToObject(root, "phases",
+		phasesToJson(stats->phase_secs, stats->total_secs));
+	dtypes = cJSON_AddObjectToObject(root, "dtypes");
+
+	for (i = 0; i < dtype_info_len; i++)
+	{
+		struct cJSON *dtype;
+
+		if ((stats->type_in[i] == 0) && (stats->type_out[i] == 0))
+		{
+			continue;
+		}
+
+		dtype = cJSON_AddObjectToObject(dtypes, dtype_info[i].name);
+		cJSON_AddNumberToObject(dtype, "converted_from",
+			(double) stats->type_in[i]);
+		cJSON_AddNumberToObject(dtype, "converted_to",
+			(double) stats->type_out[i]);
+	}
+
+	cJSON_AddItemToObject(root, "error", errorToJson(&stats->error));
+	memory = cJSON_AddObjectToObject(root, "memory");
+	cJSON_AddNumberToObject(memory, "current_bytes",
+		(double) stats->mem_current);
+	cJSON_AddNumberToObject(memory, "peak_bytes", (double) stats->mem_peak);
+	cJSON_AddNumberToObject(memory, "predicted_peak_bytes",
+		(double) stats->mem_predicted_peak);
+	cJSON_AddStringToObject(memory, "peak_tensor", stats->mem_peak_tensor);
+	cJSON_AddNumberToObject(memory, "allocations",
+		(double) stats->mem_allocs);
+	cJSON_AddNumberToObject(memory, "reallocations",
+		(double) stats->mem_reallocs);
+	cJSON_AddNumberToObject(memory, "frees", (double) stats->mem_frees);
+	tensors = cJSON_AddArrayToObject(root, "tensors");
+
+	for (i = 0; i < ctx->stats_log.len; i++)
+	{
+		cJSON_AddItemToArray(tensors,
+			tensorToJson(&ctx->stats_log.tensors[i]));
+	}
+
+	/* Handed back through the context allocator so sdcFree applies */
+	if ((printed = cJSON_Print(root)) != NULL)
+	{
+		out_len = strlen(printed) + 1;
+
+		if ((out = sdcMalloc(ctx, out_len)) != NULL)
+		{
+			memcpy(out, printed, out_len);
+		}
+
+		cJSON_free(printed);
+	}
+
+	cJSON_Delete(root);
+
+	return out;
+}
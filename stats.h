@@ -0,0 +1,39 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "main.h"
+
+/* Per-tensor record kept with statistics collection enabled */
+struct tensorStats
+{
+	char *name;
+	enum dataType in_type;
+	enum dataType out_type;
+	uint64_t bytes_in;
+	uint64_t bytes_out;
+	double phase_secs[SDC_NUM_PHASES];
+	struct sdcConvError error;
+};
+
+struct statsLog
+{
+	struct tensorStats *tensors;
+	size_t len;
+	size_t cap;
+};
+
+double monotonicSecs(void);
+
+/* Both are free when collection is disabled, statsNow returning 0 and
+ * statsLap doing nothing. statsLap charges the time since start to phase,
+ * and to rec as well when given, returning the new start */
+double statsNow(const struct sdc_context *ctx);
+double statsLap(struct sdc_context *ctx, const enum sdcPhase phase,
+	struct tensorStats *rec, const double start);
+
+/* NULL when disabled or out of memory, only valid until the next call */
+struct tensorStats* statsAddTensor(struct sdc_context *ctx,
+	const char *name, const enum dataType in_type);
+void statsClear(struct sdc_context *ctx);
+
+#endif /* STATS_H */
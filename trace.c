@@ -0,0 +1,261 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+#include "context.h"
+#include "stats.h"
+
+#if defined(__GNUC__)
+#define SDC_ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define SDC_ATOMIC_INC(ptr) __atomic_add_fetch((ptr), 1, __ATOMIC_RELAXED)
+#define SDC_ATOMIC_PUSH(head, node) \
+	while (!__atomic_compare_exchange_n((head), &(node)->next, (node), \
+		0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+#endif
+
+/* Without atomics tracing is only safe from a single thread, which is all
+ * the conversion uses for now */
+#ifndef SDC_ATOMIC_LOAD
+#define SDC_ATOMIC_LOAD(ptr) (*(ptr))
+#define SDC_ATOMIC_INC(ptr) (++(*(ptr)))
+#define SDC_ATOMIC_PUSH(head, node) (*(head) = (node))
+#endif
+
+/* The address of thread_marker tells threads apart, the cached buffer
+ * saves walking the list on every event. Every recording gets a fresh
+ * generation so a cache can never outlive the buffers it points to, even
+ * should a new context turn up at the address of a destroyed one */
+static SDC_THREAD_LOCAL char thread_marker;
+static SDC_THREAD_LOCAL struct traceBuffer *cached_buf;
+static SDC_THREAD_LOCAL unsigned long cached_gen;
+static unsigned long trace_generation;
+
+static struct traceBuffer* threadBuffer(struct sdc_context *ctx)
+{
+	struct traceBuffer *buf;
+
+	if ((cached_gen == ctx->trace.generation) && (cached_buf != NULL))
+	{
+		return cached_buf;
+	}
+
+	for (buf = SDC_ATOMIC_LOAD(&ctx->trace.buffers); buf != NULL;
+		buf = buf->next)
+	{
+		if (buf->thread_key == &thread_marker)
+		{
+			break;
+		}
+	}
+
+	if (buf == NULL)
+	{
+		if ((buf = sdcMalloc(ctx, sizeof(*buf))) == NULL)
+		{
+			return NULL;
+		}
+
+		memset(buf, 0, sizeof(*buf));
+		buf->thread_key = &thread_marker;
+		buf->tid  = SDC_ATOMIC_INC(&ctx->trace.next_tid);
+		buf->next = SDC_ATOMIC_LOAD(&ctx->trace.buffers);
+		SDC_ATOMIC_PUSH(&ctx->trace.buffers, buf);
+	}
+
+	cached_gen = ctx->trace.generation;
+	cached_buf = buf;
+
+	return buf;
+}
+
+double traceStart(const struct sdc_context *ctx)
+{
+	return (ctx->trace.enabled == SDC_TRUE) ? monotonicSecs() : 0.0;
+}
+
+static SDC_STAT copyName(struct sdc_context *ctx, struct traceBuffer *buf,
+	const char *name, size_t *offset)
+{
+	const size_t len = strlen(name) + 1;
+
+	if (len > buf->names_cap - buf->names_len)
+	{
+		size_t new_cap = (buf->names_cap == 0) ? 4096 : buf->names_cap;
+		char *tmp;
+
+		while (new_cap - buf->names_len < len)
+		{
+			new_cap *= 2;
+		}
+
+		if ((tmp = sdcRealloc(ctx, buf->names, new_cap)) == NULL)
+		{
+			return SDC_FAILURE;
+		}
+
+		buf->names     = tmp;
+		buf->names_cap = new_cap;
+	}
+
+	memcpy(buf->names + buf->names_len, name, len);
+	*offset = buf->names_len;
+	buf->names_len += len;
+
+	return SDC_SUCCESS;
+}
+
+void traceSpan(struct sdc_context *ctx, const char *name,
+	const SDC_BOOL copy_name, const double start)
+{
+	struct traceBuffer *buf;
+	struct traceEvent *event;
+	double now;
+
+	if ((ctx->trace.enabled == SDC_FALSE)
+	|| ((buf = threadBuffer(ctx)) == NULL))
+	{
+		return;
+	}
+
+	now = monotonicSecs();
+
+	if (buf->len == buf->cap)
+	{
+		const size_t new_cap = (buf->cap == 0) ? 1024 : buf->cap * 2;
+		struct traceEvent *tmp = sdcRealloc(ctx, buf->events,
+			new_cap * sizeof(*tmp));
+
+		if (tmp == NULL)
+		{
+			return;
+		}
+
+		buf->events = tmp;
+		buf->cap    = new_cap;
+	}
+
+	event = &buf->events[buf->len];
+	event->name     = name;
+	event->start_us = (start - ctx->trace.epoch) * 1e6;
+	event->dur_us   = (now - start) * 1e6;
+
+	/* A name to be copied may not outlive the call, without its copy
+	 * the event is dropped rather than left pointing at it */
+	if (copy_name == SDC_TRUE)
+	{
+		if (copyName(ctx, buf, name, &event->name_off) == SDC_FAILURE)
+		{
+			return;
+		}
+
+		event->name = NULL;
+	}
+
+	buf->len++;
+}
+
+void traceClear(struct sdc_context *ctx)
+{
+	struct traceBuffer *buf = ctx->trace.buffers;
+
+	while (buf != NULL)
+	{
+		struct traceBuffer *next = buf->next;
+
+		sdcFree(ctx, buf->events);
+		sdcFree(ctx, buf->names);
+		sdcFree(ctx, buf);
+		buf = next;
+	}
+
+	ctx->trace.buffers    = NULL;
+	ctx->trace.next_tid   = 0;
+	ctx->trace.generation = SDC_ATOMIC_INC(&trace_generation);
+}
+
+void sdcSetTrace(struct sdc_context *ctx, const SDC_BOOL enabled)
+{
+	if ((enabled == SDC_TRUE) && (ctx->trace.enabled == SDC_FALSE))
+	{
+		traceClear(ctx);
+		ctx->trace.epoch = monotonicSecs();
+	}
+
+	ctx->trace.enabled = enabled;
+}
+
+static void writeEscaped(FILE *fhandle, const char *str)
+{
+	for (; *str != '\0'; str++)
+	{
+		if ((*str == '"') || (*str == '\\'))
+		{
+			fputc('\\', fhandle);
+			fputc(*str, fhandle);
+		}
+		else if ((unsigned char) *str < 0x20)
+		{
+			fprintf(fhandle, "\\u%04x", (unsigned) *str);
+		}
+		else
+		{
+			fputc(*str, fhandle);
+		}
+	}
+}
+
+SDC_STAT sdcWriteTrace(struct sdc_context *ctx, const char *path)
+{
+	const struct traceBuffer *buf = NULL;
+	FILE *fhandle = NULL;
+	const char *sep = "";
+	size_t i;
+	SDC_STAT ret_code = SDC_SUCCESS;
+
+	if ((path == NULL) || ((fhandle = fopen(path, "w")) == NULL))
+	{
+		errorPrintf(ctx, "%s: Failure to open trace file '%s'\n",
+			__func__, (path != NULL) ? path : "");
+
+		return SDC_FAILURE;
+	}
+
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", fhandle);
+
+	for (buf = ctx->trace.buffers; buf != NULL; buf = buf->next)
+	{
+		fprintf(fhandle, "%s{\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+			"\"name\":\"thread_name\",\"args\":{\"name\":"
+			"\"sdc-%u\"}}", sep, buf->tid, buf->tid);
+		sep = ",\n";
+
+		for (i = 0; i < buf->len; i++)
+		{
+			const struct traceEvent *event = &buf->events[i];
+
+			fprintf(fhandle, ",\n{\"ph\":\"X\",\"pid\":1,"
+				"\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+				"\"name\":\"",
+				buf->tid, event->start_us, event->dur_us);
+			writeEscaped(fhandle, (event->name != NULL)
+				? event->name : buf->names + event->name_off);
+			fputs("\"}", fhandle);
+		}
+	}
+
+	fputs("\n]}\n", fhandle);
+
+	if (ferror(fhandle) != 0)
+	{
+		errorPrintf(ctx, "%s: Failure writing trace file\n", __func__);
+		ret_code = SDC_FAILURE;
+	}
+
+	if (fclose(fhandle) == EOF)
+	{
+		ret_code = SDC_FAILURE;
+	}
+
+	return ret_code;
+}
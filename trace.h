@@ -0,0 +1,48 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "main.h"
+
+/* One complete ('X') Chrome trace event, name either points at a static
+ * string or, with name_off set, into the owning buffer's name arena */
+struct traceEvent
+{
+	const char *name;
+	size_t name_off;
+	double start_us;
+	double dur_us;
+};
+
+/* Each thread records into its own buffer so recording never contends,
+ * buffers are only ever pushed onto the context's list */
+struct traceBuffer
+{
+	const void *thread_key;
+	unsigned tid;
+	struct traceEvent *events;
+	size_t len;
+	size_t cap;
+	char *names;
+	size_t names_len;
+	size_t names_cap;
+	struct traceBuffer *next;
+};
+
+struct traceState
+{
+	SDC_BOOL enabled;
+	unsigned long generation;
+	double epoch;
+	unsigned next_tid;
+	struct traceBuffer *buffers;
+};
+
+/* traceStart is free and returns 0 with tracing disabled, traceSpan
+ * records the span from start until now under name, copying the name
+ * first when it is not a string literal */
+double traceStart(const struct sdc_context *ctx);
+void traceSpan(struct sdc_context *ctx, const char *name,
+	const SDC_BOOL copy_name, const double start);
+void traceClear(struct sdc_context *ctx);
+
+#endif /* TRACE_H */
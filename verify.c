@@ -0,0 +1,1095 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#else
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "verify.h"
+#include "context.h"
+#include "converting.h"
+#include "fileLoading.h"
+#include "kernels.h"
+#include "rules.h"
+#include "io.h"
+#include "stats.h"
+#include "trace.h"
+#include "cJSON.h"
+
+#define SDC_MAX(a, b) (((a) > (b)) ? (a) : (b))
+#define SDC_MIN(a, b) (((a) < (b)) ? (a) : (b))
+
+/* What a value converted to dtype may be off by, one unit in the last
+ * place or one step of the subnormals, and the range it saturates to.
+ * Integers must come out exact */
+static const struct
+{
+	const enum dataType dtype;
+	const struct sdcTolerance tol;
+} tolerances[] =
+{
+	{FLOAT_64,   {0x1p-52, 0x1p-1074, -DBL_MAX,     DBL_MAX}},
+	{FLOAT_32,   {0x1p-23, 0x1p-149,  -FLT_MAX,     FLT_MAX}},
+	{FLOAT_16,   {0x1p-10, 0x1p-24,   -SDC_HLF_MAX, SDC_HLF_MAX}},
+	{BFLOAT_16,  {0x1p-7,  0x1p-133,  -SDC_BFT_MAX, SDC_BFT_MAX}},
+	{SIGNED_64,  {0.0,     0.0,       -0x1p63,      0x1p63}},
+	{SIGNED_32,  {0.0,     0.0,       INT32_MIN,    INT32_MAX}},
+	{SIGNED_16,  {0.0,     0.0,       INT16_MIN,    INT16_MAX}},
+	{SIGNED_8,   {0.0,     0.0,       INT8_MIN,     INT8_MAX}},
+	{UNSIGNED_8, {0.0,     0.0,       0.0,          UINT8_MAX}}
+};
+
+/* A tensor present in both files. Those without widen kernels, of the
+ * same dtype or of one unknown to us, are compared byte for byte one
+ * element at a time, an element of an unknown dtype being a byte */
+struct verifyTensor
+{
+	const char *name;
+	const char *in;
+	const char *out;
+	size_t in_size;
+	size_t out_size;
+	uint64_t numel;
+	sdcWidenKernel widen_in;
+	sdcWidenKernel widen_out;
+	const struct sdcTolerance *tol;
+};
+
+struct verifyJob
+{
+	size_t tensor;
+	uint64_t first;
+	uint64_t count;
+	struct sdcCompare cmp;
+};
+
+/* What verify jobs run over */
+struct verifyWork
+{
+	const struct verifyTensor *tensors;
+	struct verifyJob *jobs;
+	sdcCompareKernel compare;
+};
+
+/* A tensor of a file being checked, its chunks' digests going at first
+ * onwards in the digests shared by all. hash is the one stored for it,
+ * NULL when it has none */
+struct checkTensor
+{
+	const char *name;
+	const char *data;
+	uint64_t len;
+	size_t first;
+	const char *hash;
+};
+
+struct checkJob
+{
+	size_t tensor;
+	uint64_t offset;
+	uint64_t len;
+};
+
+/* What check jobs run over, each writing only its own digests */
+struct checkWork
+{
+	const struct checkTensor *tensors;
+	const struct checkJob *jobs;
+	uint64_t *digests;
+	sdcHashKernel hash;
+};
+
+/* Threads take the next job under the lock until none are left, run(user,
+ * job) keeping each job's results apart so nothing else is shared. The
+ * lock is only there with more than the one thread */
+struct verifyPool
+{
+	void (*run)(void *user, const size_t job);
+	void *user;
+	size_t jobs_len;
+	size_t next;
+#ifndef _WIN32
+	pthread_mutex_t lock;
+	SDC_BOOL locked;
+#endif
+};
+
+static enum dataType dtypeFromName(const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < dtype_info_len; i++)
+	{
+		if (strcmp(dtype_info[i].name, name) == 0)
+		{
+			return dtype_info[i].dtype;
+		}
+	}
+
+	return DTYPE_UNKNOWN;
+}
+
+static const struct sdcTolerance* toleranceOf(const enum dataType dtype)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(tolerances) / sizeof(tolerances[0]); i++)
+	{
+		if (tolerances[i].dtype == dtype)
+		{
+			return &tolerances[i].tol;
+		}
+	}
+
+	return NULL;
+}
+
+static unsigned onlineCpus(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+	const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (cpus > 0) ? (unsigned) cpus : 1;
+#else
+	return 1;
+#endif
+}
+
+/* Kernels read elements in place, those that are misaligned or need their
+ * bytes swapped are copied into scratch first */
+static void widenBlock(const sdcWidenKernel widen, const char *src,
+	const size_t size, double *dst, const size_t len, double *scratch)
+{
+	size_t i;
+
+	if ((porteggIsLittle() == PORTEGG_FALSE)
+	|| (((uintptr_t) src % size) != 0))
+	{
+		memcpy(scratch, src, len * size);
+
+		for (i = 0; i < len; i++)
+		{
+			PORTEGG_LE_TO_SYS_RAW(size,
+				(char *) scratch + i * size);
+		}
+
+		src = (const char *) scratch;
+	}
+
+	widen(src, dst, len);
+}
+
+static void compareBytes(const struct verifyTensor *tensor,
+	struct verifyJob *job)
+{
+	const size_t size = tensor->in_size;
+	const char *in    = tensor->in + job->first * size;
+	const char *out   = tensor->out + job->first * size;
+	uint64_t i;
+
+	if (memcmp(in, out, (size_t) job->count * size) == 0)
+	{
+		return;
+	}
+
+	for (i = 0; i < job->count; i++)
+	{
+		job->cmp.violations += (memcmp(in + i * size, out + i * size,
+			size) != 0);
+	}
+}
+
+/* Runs on any thread, so touches neither the context nor the log */
+static void runJob(void *user, const size_t index)
+{
+	const struct verifyWork *work = user;
+	struct verifyJob *job = &work->jobs[index];
+	const struct verifyTensor *tensor = &work->tensors[job->tensor];
+	double x[SDC_VERIFY_BLOCK];
+	double y[SDC_VERIFY_BLOCK];
+	double scratch[SDC_VERIFY_BLOCK];
+	uint64_t done;
+
+	if (tensor->widen_in == NULL)
+	{
+		compareBytes(tensor, job);
+
+		return;
+	}
+
+	for (done = 0; done < job->count; done += SDC_VERIFY_BLOCK)
+	{
+		const uint64_t at = job->first + done;
+		const size_t len  = (size_t) SDC_MIN(job->count - done,
+			SDC_VERIFY_BLOCK);
+
+		widenBlock(tensor->widen_in, tensor->in + at * tensor->in_size,
+			tensor->in_size, x, len, scratch);
+		widenBlock(tensor->widen_out,
+			tensor->out + at * tensor->out_size, tensor->out_size,
+			y, len, scratch);
+		work->compare(x, y, len, tensor->tol, &job->cmp);
+	}
+}
+
+/* Jobs start on a chunk boundary, so their digests are those of the
+ * chunks of the whole tensor */
+static void runCheckJob(void *user, const size_t index)
+{
+	const struct checkWork *work   = user;
+	const struct checkJob *job     = &work->jobs[index];
+	const struct checkTensor *tensor = &work->tensors[job->tensor];
+
+	work->hash(tensor->data + job->offset, job->len, work->digests
+		+ tensor->first + (size_t) (job->offset / SDC_HASH_CHUNK));
+}
+
+/* SIZE_MAX once there are none left */
+static size_t takeJob(struct verifyPool *pool)
+{
+	size_t job = SIZE_MAX;
+
+#ifndef _WIN32
+	if (pool->locked == SDC_TRUE)
+	{
+		pthread_mutex_lock(&pool->lock);
+	}
+#endif
+
+	if (pool->next < pool->jobs_len)
+	{
+		job = pool->next++;
+	}
+
+#ifndef _WIN32
+	if (pool->locked == SDC_TRUE)
+	{
+		pthread_mutex_unlock(&pool->lock);
+	}
+#endif
+
+	return job;
+}
+
+static void* verifyWorker(void *arg)
+{
+	struct verifyPool *pool = arg;
+	size_t job;
+
+	while ((job = takeJob(pool)) != SIZE_MAX)
+	{
+		pool->run(pool->user, job);
+	}
+
+	return NULL;
+}
+
+/* The calling thread works through the jobs alongside threads - 1 others,
+ * going on with however many could be started. Returns the threads used.
+ * Without pthreads, on Windows, it is only ever the calling thread */
+static unsigned runPool(struct sdc_context *ctx, struct verifyPool *pool,
+	unsigned threads)
+{
+#ifndef _WIN32
+	pthread_t *workers = NULL;
+	unsigned started   = 0;
+	unsigned i;
+
+	if ((threads > 1)
+	&& ((workers = sdcMalloc(ctx, (threads - 1) * sizeof(*workers)))
+		!= NULL))
+	{
+		pool->locked = (pthread_mutex_init(&pool->lock, NULL) == 0)
+			? SDC_TRUE : SDC_FALSE;
+	}
+
+	if ((threads > 1) && (pool->locked == SDC_FALSE))
+	{
+		sdcLog(ctx, SDC_LOG_WARNING, "%s: Could not set up threads, "
+			"running on one\n", __func__);
+		sdcFree(ctx, workers);
+		workers = NULL;
+	}
+
+	for (i = 0; (workers != NULL) && (i < threads - 1); i++)
+	{
+		if (pthread_create(&workers[i], NULL, verifyWorker, pool) != 0)
+		{
+			sdcLog(ctx, SDC_LOG_WARNING, "%s: Only %u of %u "
+				"threads could be started\n", __func__,
+				started + 1, threads);
+			break;
+		}
+
+		started++;
+	}
+
+	verifyWorker(pool);
+
+	for (i = 0; i < started; i++)
+	{
+		pthread_join(workers[i], NULL);
+	}
+
+	if (pool->locked == SDC_TRUE)
+	{
+		pthread_mutex_destroy(&pool->lock);
+	}
+
+	sdcFree(ctx, workers);
+
+	return started + 1;
+#else
+	(void) ctx;
+	(void) threads;
+
+	verifyWorker(pool);
+
+	return 1;
+#endif
+}
+
+/* Both tensors must be of the same shape, and either both widen or be of
+ * the same dtype, for them to be compared at all */
+static SDC_STAT matchTensor(struct sdc_context *ctx,
+	const struct cJSON *in_json, const struct cJSON *out_json,
+	const char *in_data, const char *out_data,
+	struct verifyTensor *tensor)
+{
+	const struct cJSON *in_dtype = cJSON_GetObjectItemCaseSensitive(
+		in_json, "dtype");
+	const struct cJSON *out_dtype = cJSON_GetObjectItemCaseSensitive(
+		out_json, "dtype");
+	const struct cJSON *in_offsets = cJSON_GetObjectItemCaseSensitive(
+		in_json, "data_offsets");
+	const struct cJSON *out_offsets = cJSON_GetObjectItemCaseSensitive(
+		out_json, "data_offsets");
+	const enum dataType in_type  = dtypeFromName(in_dtype->valuestring);
+	const enum dataType out_type = dtypeFromName(out_dtype->valuestring);
+	const uint64_t in_start = (uint64_t) cJSON_GetArrayItem(in_offsets,
+		0)->valuedouble;
+	const uint64_t in_end   = (uint64_t) cJSON_GetArrayItem(in_offsets,
+		1)->valuedouble;
+	const uint64_t out_start = (uint64_t) cJSON_GetArrayItem(out_offsets,
+		0)->valuedouble;
+	const uint64_t out_end   = (uint64_t) cJSON_GetArrayItem(out_offsets,
+		1)->valuedouble;
+
+	memset(tensor, 0, sizeof(*tensor));
+	tensor->name = out_json->string;
+	tensor->in   = in_data + in_start;
+	tensor->out  = out_data + out_start;
+
+	if (cJSON_Compare(cJSON_GetObjectItemCaseSensitive(in_json, "shape"),
+		cJSON_GetObjectItemCaseSensitive(out_json, "shape"), 1) == 0)
+	{
+		errorPrintf(ctx, "%s: %s changed shape\n", __func__,
+			tensor->name);
+
+		return SDC_FAILURE;
+	}
+
+	if (strcmp(in_dtype->valuestring, out_dtype->valuestring) == 0)
+	{
+		tensor->in_size  = (in_type == DTYPE_UNKNOWN) ? 1
+			: dtype_info[in_type].size;
+		tensor->out_size = tensor->in_size;
+	}
+	else if (((tensor->widen_in = getWidenKernel(in_type)) == NULL)
+	|| ((tensor->widen_out = getWidenKernel(out_type)) == NULL))
+	{
+		errorPrintf(ctx, "%s: %s went from %s to %s, which cannot be "
+			"compared\n", __func__, tensor->name,
+			in_dtype->valuestring, out_dtype->valuestring);
+
+		return SDC_FAILURE;
+	}
+	else
+	{
+		tensor->in_size  = dtype_info[in_type].size;
+		tensor->out_size = dtype_info[out_type].size;
+		tensor->tol      = toleranceOf(out_type);
+	}
+
+	tensor->numel = (in_end - in_start) / tensor->in_size;
+
+	if (tensor->numel * tensor->out_size != out_end - out_start)
+	{
+		errorPrintf(ctx, "%s: %s holds %llu bytes where %llu were "
+			"expected\n", __func__, tensor->name,
+			(unsigned long long) (out_end - out_start),
+			(unsigned long long) (tensor->numel
+			* tensor->out_size));
+
+		return SDC_FAILURE;
+	}
+
+	return SDC_SUCCESS;
+}
+
+/* Pairs every output tensor up with its input by name, the output having
+ * no tensor the input does not. Input tensors left out of the output are
+ * only counted as missing, --include and --exclude drop them on purpose.
+ * Tensors failing to match are counted as bad and left out of *tensors */
+static SDC_STAT matchTensors(struct sdc_context *ctx,
+	const struct cJSON *in_tree, const struct cJSON *out_tree,
+	const char *in_data, const char *out_data,
+	struct verifyTensor **tensors, size_t *count,
+	struct sdcVerifyReport *report)
+{
+	const struct cJSON **in_jsons = NULL;
+	const char **in_names         = NULL;
+	SDC_BOOL *matched             = NULL;
+	const struct cJSON *cursor;
+	struct nameIndex index;
+	size_t in_len  = 0;
+	size_t out_len = 0;
+	size_t i;
+	SDC_STAT ret_code = SDC_SUCCESS;
+
+	memset(&index, 0, sizeof(index));
+	*tensors = NULL;
+	*count   = 0;
+
+	cJSON_ArrayForEach(cursor, in_tree)
+	{
+		in_len += (strcmp(cursor->string, "__metadata__") != 0);
+	}
+
+	cJSON_ArrayForEach(cursor, out_tree)
+	{
+		out_len += (strcmp(cursor->string, "__metadata__") != 0);
+	}
+
+	if (((in_jsons = sdcMalloc(ctx, (in_len + 1) * sizeof(*in_jsons)))
+		== NULL)
+	|| ((in_names = sdcMalloc(ctx, (in_len + 1) * sizeof(*in_names)))
+		== NULL)
+	|| ((matched = sdcMalloc(ctx, (in_len + 1) * sizeof(*matched)))
+		== NULL)
+	|| ((*tensors = sdcMalloc(ctx, (out_len + 1) * sizeof(**tensors)))
+		== NULL))
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	i = 0;
+
+	cJSON_ArrayForEach(cursor, in_tree)
+	{
+		if (strcmp(cursor->string, "__metadata__") != 0)
+		{
+			in_jsons[i]  = cursor;
+			in_names[i]  = cursor->string;
+			matched[i++] = SDC_FALSE;
+		}
+	}
+
+	if (buildNameIndex(ctx, &index, in_names, in_len) == SDC_FAILURE)
+	{
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	cJSON_ArrayForEach(cursor, out_tree)
+	{
+		size_t found;
+
+		if (strcmp(cursor->string, "__metadata__") == 0)
+		{
+			continue;
+		}
+
+		report->tensors++;
+
+		if ((found = findName(&index, cursor->string)) == SIZE_MAX)
+		{
+			errorPrintf(ctx, "%s: %s is not in the input\n",
+				__func__, cursor->string);
+			report->bad_tensors++;
+
+			continue;
+		}
+
+		matched[found] = SDC_TRUE;
+
+		if (matchTensor(ctx, in_jsons[found], cursor, in_data,
+			out_data, &(*tensors)[*count]) == SDC_FAILURE)
+		{
+			report->bad_tensors++;
+
+			continue;
+		}
+
+		(*count)++;
+	}
+
+	for (i = 0; i < in_len; i++)
+	{
+		if (matched[i] == SDC_FALSE)
+		{
+			sdcLog(ctx, SDC_LOG_WARNING, "%s: %s is missing from "
+				"the output\n", __func__, in_names[i]);
+			report->missing++;
+		}
+	}
+
+CLEANUP:
+	if (ret_code == SDC_FAILURE)
+	{
+		sdcFree(ctx, *tensors);
+		*tensors = NULL;
+	}
+
+	sdcFree(ctx, index.slots);
+	sdcFree(ctx, matched);
+	sdcFree(ctx, in_names);
+	sdcFree(ctx, in_jsons);
+
+	return ret_code;
+}
+
+/* Each tensor is split into jobs of about SDC_VERIFY_JOB input bytes, an
+ * empty tensor still getting one so that it is accounted for */
+static struct verifyJob* splitJobs(struct sdc_context *ctx,
+	const struct verifyTensor *tensors, const size_t count, size_t *len)
+{
+	struct verifyJob *jobs;
+	size_t i;
+
+	*len = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		const uint64_t per_job = SDC_VERIFY_JOB / tensors[i].in_size;
+
+		*len += (size_t) ((tensors[i].numel + per_job - 1) / per_job);
+		*len += (tensors[i].numel == 0);
+	}
+
+	if ((jobs = sdcMalloc(ctx, (*len + 1) * sizeof(*jobs))) == NULL)
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+
+		return NULL;
+	}
+
+	memset(jobs, 0, (*len + 1) * sizeof(*jobs));
+	*len = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		const uint64_t per_job = SDC_VERIFY_JOB / tensors[i].in_size;
+		uint64_t first = 0;
+
+		do
+		{
+			jobs[*len].tensor = i;
+			jobs[*len].first  = first;
+			jobs[*len].count  = SDC_MIN(per_job,
+				tensors[i].numel - first);
+			first += jobs[(*len)++].count;
+		} while (first < tensors[i].numel);
+	}
+
+	return jobs;
+}
+
+/* Jobs are in tensor order, so each tensor's are gathered in one pass */
+static void reduceJobs(struct sdc_context *ctx,
+	const struct verifyTensor *tensors, const struct verifyJob *jobs,
+	const size_t jobs_len, struct sdcVerifyReport *report)
+{
+	struct sdcCompare cmp;
+	size_t i = 0;
+
+	while (i < jobs_len)
+	{
+		const struct verifyTensor *tensor = &tensors[jobs[i].tensor];
+
+		memset(&cmp, 0, sizeof(cmp));
+
+		for (; (i < jobs_len) && (&tensors[jobs[i].tensor] == tensor);
+			i++)
+		{
+			cmp.violations += jobs[i].cmp.violations;
+			cmp.saturated  += jobs[i].cmp.saturated;
+			cmp.max_abs = (jobs[i].cmp.max_abs > cmp.max_abs)
+				? jobs[i].cmp.max_abs : cmp.max_abs;
+			cmp.max_rel = (jobs[i].cmp.max_rel > cmp.max_rel)
+				? jobs[i].cmp.max_rel : cmp.max_rel;
+		}
+
+		report->elements   += tensor->numel;
+		report->violations += cmp.violations;
+		report->saturated  += cmp.saturated;
+		report->bytes      += tensor->numel
+			* (tensor->in_size + tensor->out_size);
+		report->max_abs = (cmp.max_abs > report->max_abs)
+			? cmp.max_abs : report->max_abs;
+		report->max_rel = (cmp.max_rel > report->max_rel)
+			? cmp.max_rel : report->max_rel;
+
+		if ((cmp.violations > 0) && (tensor->widen_in == NULL))
+		{
+			errorPrintf(ctx, "%s: %s differs in %llu of %llu "
+				"elements\n", __func__, tensor->name,
+				(unsigned long long) cmp.violations,
+				(unsigned long long) tensor->numel);
+			report->bad_tensors++;
+		}
+		else if (cmp.violations > 0)
+		{
+			errorPrintf(ctx, "%s: %s has %llu of %llu elements out "
+				"of tolerance, worst abs %g rel %g\n", __func__,
+				tensor->name,
+				(unsigned long long) cmp.violations,
+				(unsigned long long) tensor->numel,
+				cmp.max_abs, cmp.max_rel);
+			report->bad_tensors++;
+		}
+		else
+		{
+			verbosePrintf(ctx, "%s: %s within tolerance, worst abs "
+				"%g rel %g\n", __func__, tensor->name,
+				cmp.max_abs, cmp.max_rel);
+		}
+	}
+}
+
+static SDC_STAT verifyMapped(struct sdc_context *ctx,
+	const struct sdcMapping *in_map, const struct sdcMapping *out_map,
+	struct sdcVerifyReport *report)
+{
+	struct verifyTensor *tensors = NULL;
+	struct cJSON *in_tree        = NULL;
+	struct cJSON *out_tree       = NULL;
+	struct sdcReader reader;
+	struct verifyWork work;
+	struct verifyPool pool;
+	uint64_t in_header  = 0;
+	uint64_t out_header = 0;
+	size_t count = 0;
+	unsigned threads;
+	SDC_STAT ret_code = SDC_SUCCESS;
+
+	memset(&work, 0, sizeof(work));
+	memset(&pool, 0, sizeof(pool));
+	readerFromMemory(&reader, in_map->data, in_map->len);
+
+	if (loadHeader(ctx, &reader, &in_tree, &in_header) == SDC_FAILURE)
+	{
+		errorPrintf(ctx, "%s: The input is not a valid safetensors "
+			"file\n", __func__);
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	readerFromMemory(&reader, out_map->data, out_map->len);
+
+	if (loadHeader(ctx, &reader, &out_tree, &out_header) == SDC_FAILURE)
+	{
+		errorPrintf(ctx, "%s: The output is not a valid safetensors "
+			"file\n", __func__);
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	if ((ret_code = matchTensors(ctx, in_tree, out_tree,
+		in_map->data + sizeof(uint64_t) + in_header,
+		out_map->data + sizeof(uint64_t) + out_header,
+		&tensors, &count, report)) == SDC_FAILURE)
+	{
+		goto CLEANUP;
+	}
+
+	if ((work.jobs = splitJobs(ctx, tensors, count, &pool.jobs_len))
+		== NULL)
+	{
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	threads = (ctx->threads == 0) ? onlineCpus() : ctx->threads;
+	threads = (unsigned) SDC_MIN(threads, SDC_MAX(pool.jobs_len, 1));
+	work.tensors = tensors;
+	work.compare = getCompareKernel();
+	pool.run  = runJob;
+	pool.user = &work;
+	report->threads = runPool(ctx, &pool, threads);
+	reduceJobs(ctx, tensors, work.jobs, pool.jobs_len, report);
+
+CLEANUP:
+	sdcFree(ctx, work.jobs);
+	sdcFree(ctx, tensors);
+	cJSON_Delete(out_tree);
+	cJSON_Delete(in_tree);
+
+	return ret_code;
+}
+
+SDC_STAT sdcVerifyFile(struct sdc_context *ctx, const char *in_path,
+	const char *out_path, struct sdcVerifyReport *report)
+{
+	struct sdcMapping in_map;
+	struct sdcMapping out_map;
+	struct sdc_context *prev_ctx;
+	SDC_STAT ret_code = SDC_FAILURE;
+	double start;
+	double span;
+
+	if ((ctx == NULL) || (in_path == NULL) || (out_path == NULL)
+	|| (report == NULL))
+	{
+		return SDC_FAILURE;
+	}
+
+	memset(report, 0, sizeof(*report));
+	memset(&in_map, 0, sizeof(in_map));
+	memset(&out_map, 0, sizeof(out_map));
+	start    = monotonicSecs();
+	span     = traceStart(ctx);
+	prev_ctx = memoryEnter(ctx);
+
+	if ((mapFile(ctx, &in_map, in_path) == SDC_SUCCESS)
+	&& (mapFile(ctx, &out_map, out_path) == SDC_SUCCESS))
+	{
+		ret_code = verifyMapped(ctx, &in_map, &out_map, report);
+	}
+
+	unmapFile(ctx, &out_map);
+	unmapFile(ctx, &in_map);
+	memoryLeave(prev_ctx);
+	report->seconds = monotonicSecs() - start;
+	traceSpan(ctx, "sdcVerifyFile", SDC_FALSE, span);
+
+	return ret_code;
+}
+
+/* Gathers every tensor of the file along with its stored hash, failing
+ * should there be no hashes or ones of a scheme other than ours.
+ * *digests_len gets the chunks of all tensors together */
+static SDC_STAT readHashes(struct sdc_context *ctx, const struct cJSON *tree,
+	const char *data, struct checkTensor **tensors, size_t *count,
+	size_t *digests_len)
+{
+	const struct cJSON *meta = cJSON_GetObjectItemCaseSensitive(tree,
+		"__metadata__");
+	const struct cJSON *scheme = cJSON_GetObjectItemCaseSensitive(meta,
+		SDC_HASH_KEY);
+	const size_t prefix_len = sizeof(SDC_HASH_PREFIX) - 1;
+	const char **names  = NULL;
+	const char **hashes = NULL;
+	const struct cJSON *cursor;
+	struct nameIndex index;
+	char expected[32];
+	size_t hashes_len = 0;
+	size_t i;
+	SDC_STAT ret_code = SDC_SUCCESS;
+
+	memset(&index, 0, sizeof(index));
+	snprintf(expected, sizeof(expected), "%s%d", SDC_HASH_SCHEME,
+		SDC_HASH_CHUNK);
+	*tensors     = NULL;
+	*count       = 0;
+	*digests_len = 0;
+
+	if (cJSON_IsString(scheme) == 0)
+	{
+		errorPrintf(ctx, "%s: The file holds no hashes\n", __func__);
+
+		return SDC_FAILURE;
+	}
+
+	if (strcmp(scheme->valuestring, expected) != 0)
+	{
+		errorPrintf(ctx, "%s: Unsupported hash scheme %s\n", __func__,
+			scheme->valuestring);
+
+		return SDC_FAILURE;
+	}
+
+	cJSON_ArrayForEach(cursor, meta)
+	{
+		hashes_len += ((strncmp(cursor->string, SDC_HASH_PREFIX,
+			prefix_len) == 0) && (cJSON_IsString(cursor) != 0));
+	}
+
+	cJSON_ArrayForEach(cursor, tree)
+	{
+		*count += (strcmp(cursor->string, "__metadata__") != 0);
+	}
+
+	if (((names = sdcMalloc(ctx, (hashes_len + 1) * sizeof(*names)))
+		== NULL)
+	|| ((hashes = sdcMalloc(ctx, (hashes_len + 1) * sizeof(*hashes)))
+		== NULL)
+	|| ((*tensors = sdcMalloc(ctx, (*count + 1) * sizeof(**tensors)))
+		== NULL))
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	i = 0;
+
+	cJSON_ArrayForEach(cursor, meta)
+	{
+		if ((strncmp(cursor->string, SDC_HASH_PREFIX, prefix_len) == 0)
+		&& (cJSON_IsString(cursor) != 0))
+		{
+			names[i]    = cursor->string + prefix_len;
+			hashes[i++] = cursor->valuestring;
+		}
+	}
+
+	if (buildNameIndex(ctx, &index, names, hashes_len) == SDC_FAILURE)
+	{
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	i = 0;
+
+	cJSON_ArrayForEach(cursor, tree)
+	{
+		const struct cJSON *offsets = cJSON_GetObjectItemCaseSensitive(
+			cursor, "data_offsets");
+		struct checkTensor *tensor = &(*tensors)[i];
+		uint64_t start;
+		size_t found;
+
+		if (strcmp(cursor->string, "__metadata__") == 0)
+		{
+			continue;
+		}
+
+		start = (uint64_t) cJSON_GetArrayItem(offsets, 0)->valuedouble;
+		found = findName(&index, cursor->string);
+		tensor->name  = cursor->string;
+		tensor->data  = data + start;
+		tensor->len   = (uint64_t) cJSON_GetArrayItem(offsets,
+			1)->valuedouble - start;
+		tensor->first = *digests_len;
+		tensor->hash  = (found == SIZE_MAX) ? NULL : hashes[found];
+		*digests_len += (size_t) ((tensor->len + SDC_HASH_CHUNK - 1)
+			/ SDC_HASH_CHUNK);
+		i++;
+	}
+
+CLEANUP:
+	if (ret_code == SDC_FAILURE)
+	{
+		sdcFree(ctx, *tensors);
+		*tensors = NULL;
+	}
+
+	sdcFree(ctx, index.slots);
+	sdcFree(ctx, hashes);
+	sdcFree(ctx, names);
+
+	return ret_code;
+}
+
+/* Jobs of SDC_VERIFY_JOB bytes, a whole number of chunks, empty tensors
+ * needing none as they hash to no digests at all */
+static struct checkJob* splitCheckJobs(struct sdc_context *ctx,
+	const struct checkTensor *tensors, const size_t count, size_t *len)
+{
+	struct checkJob *jobs;
+	uint64_t offset;
+	size_t i;
+
+	*len = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		*len += (size_t) ((tensors[i].len + SDC_VERIFY_JOB - 1)
+			/ SDC_VERIFY_JOB);
+	}
+
+	if ((jobs = sdcMalloc(ctx, (*len + 1) * sizeof(*jobs))) == NULL)
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+
+		return NULL;
+	}
+
+	*len = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		for (offset = 0; offset < tensors[i].len;
+			offset += SDC_VERIFY_JOB)
+		{
+			jobs[*len].tensor = i;
+			jobs[*len].offset = offset;
+			jobs[(*len)++].len = SDC_MIN(SDC_VERIFY_JOB,
+				tensors[i].len - offset);
+		}
+	}
+
+	return jobs;
+}
+
+static void reduceChecks(struct sdc_context *ctx,
+	const struct checkTensor *tensors, const size_t count,
+	uint64_t *digests, struct sdcCheckReport *report)
+{
+	char hex[SDC_HASH_HEX + 1];
+	size_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		const struct checkTensor *tensor = &tensors[i];
+
+		report->tensors++;
+		report->bytes += tensor->len;
+
+		if (tensor->hash == NULL)
+		{
+			errorPrintf(ctx, "%s: %s has no hash\n", __func__,
+				tensor->name);
+			report->unhashed++;
+
+			continue;
+		}
+
+		snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)
+			foldDigests(digests + tensor->first, (size_t)
+			((tensor->len + SDC_HASH_CHUNK - 1) / SDC_HASH_CHUNK)));
+
+		if (strcmp(hex, tensor->hash) != 0)
+		{
+			errorPrintf(ctx, "%s: %s does not match its hash, %s "
+				"where %s was stored\n", __func__, tensor->name,
+				hex, tensor->hash);
+			report->mismatched++;
+		}
+		else
+		{
+			verbosePrintf(ctx, "%s: %s matches its hash %s\n",
+				__func__, tensor->name, hex);
+		}
+	}
+}
+
+static SDC_STAT checkMapped(struct sdc_context *ctx,
+	const struct sdcMapping *map, struct sdcCheckReport *report)
+{
+	struct checkTensor *tensors = NULL;
+	struct cJSON *tree          = NULL;
+	struct sdcReader reader;
+	struct checkWork work;
+	struct verifyPool pool;
+	uint64_t header    = 0;
+	size_t count       = 0;
+	size_t digests_len = 0;
+	unsigned threads;
+	SDC_STAT ret_code = SDC_SUCCESS;
+
+	memset(&work, 0, sizeof(work));
+	memset(&pool, 0, sizeof(pool));
+	readerFromMemory(&reader, map->data, map->len);
+
+	if (loadHeader(ctx, &reader, &tree, &header) == SDC_FAILURE)
+	{
+		errorPrintf(ctx, "%s: Not a valid safetensors file\n",
+			__func__);
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	if ((ret_code = readHashes(ctx, tree, map->data + sizeof(uint64_t)
+		+ header, &tensors, &count, &digests_len)) == SDC_FAILURE)
+	{
+		goto CLEANUP;
+	}
+
+	if ((work.jobs = splitCheckJobs(ctx, tensors, count, &pool.jobs_len))
+		== NULL)
+	{
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	if ((work.digests = sdcMalloc(ctx, (digests_len + 1)
+		* sizeof(*work.digests))) == NULL)
+	{
+		errorPrintf(ctx, "%s: Malloc failure\n", __func__);
+		ret_code = SDC_FAILURE;
+
+		goto CLEANUP;
+	}
+
+	threads = (ctx->threads == 0) ? onlineCpus() : ctx->threads;
+	threads = (unsigned) SDC_MIN(threads, SDC_MAX(pool.jobs_len, 1));
+	work.tensors = tensors;
+	work.hash    = getHashKernel();
+	pool.run  = runCheckJob;
+	pool.user = &work;
+	report->threads = runPool(ctx, &pool, threads);
+	reduceChecks(ctx, tensors, count, work.digests, report);
+
+CLEANUP:
+	sdcFree(ctx, work.digests);
+	sdcFree(ctx, (void *) work.jobs);
+	sdcFree(ctx, tensors);
+	cJSON_Delete(tree);
+
+	return ret_code;
+}
+
+SDC_STAT sdcCheckFile(struct sdc_context *ctx, const char *path,
+	struct sdcCheckReport *report)
+{
+	struct sdcMapping map;
+	struct sdc_context *prev_ctx;
+	SDC_STAT ret_code = SDC_FAILURE;
+	double start;
+	double span;
+
+	if ((ctx == NULL) || (path == NULL) || (report == NULL))
+	{
+		return SDC_FAILURE;
+	}
+
+	memset(report, 0, sizeof(*report));
+	memset(&map, 0, sizeof(map));
+	start    = monotonicSecs();
+	span     = traceStart(ctx);
+	prev_ctx = memoryEnter(ctx);
+
+	if (mapFile(ctx, &map, path) == SDC_SUCCESS)
+	{
+		ret_code = checkMapped(ctx, &map, report);
+	}
+
+	unmapFile(ctx, &map);
+	memoryLeave(prev_ctx);
+	report->seconds = monotonicSecs() - start;
+	traceSpan(ctx, "sdcCheckFile", SDC_FALSE, span);
+
+	return ret_code;
+}
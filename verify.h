@@ -0,0 +1,16 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include "main.h"
+
+/* sdcVerifyFile and sdcCheckFile, declared in sdc.h, live here */
+
+/* Input bytes of a tensor each verify or check job covers, about what
+ * keeps every thread busy without the job list growing long. A whole
+ * number of SDC_HASH_CHUNK */
+#define SDC_VERIFY_JOB (4 << 20)
+
+/* Elements widened to doubles at a time within a job */
+#define SDC_VERIFY_BLOCK 2048
+
+#endif /* VERIFY_H */